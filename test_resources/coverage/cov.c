@@ -0,0 +1,16 @@
+/* Source of cov.gcno, and of the counters in cov_a.gcda (run without
+ * arguments) and cov_b.gcda (run with one), for the coverage map tests.
+ */
+
+int cov_a(int x) {
+        return x + 1;
+}
+
+int cov_b(int x) {
+        return x * 2;
+}
+
+int main(int argc, char **argv) {
+        (void)argv;
+        return argc > 1 ? cov_b(argc) : cov_a(argc) - 2;
+}
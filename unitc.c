@@ -1,16 +1,45 @@
 /* Implementation of functions declared in unitc.h */
 
+#define _GNU_SOURCE
+
+#include <stdarg.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <ctype.h>
+#include <errno.h>
 #include <string.h>
 
+#include <dirent.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <malloc.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 
+#include <linux/perf_event.h>
+
 #include <glib.h>
 
 #include "unitc.h"
@@ -29,27 +58,270 @@
                 }\
         } while (0)
 
-/** Call read or write and on failure execute exec_on_failure. rw is the name
-  * of the function to call - read or write.
+/** Call read_full or write_full and on failure execute exec_on_failure. rw is
+  * the name of the underlying function - read or write.
   */
 #define TRY_RW(rw, fd, buf, count, exec_on_failure)\
         do {\
-                if (rw((fd), (buf), (count)) == -1) {\
+                if (!rw##_full((fd), (buf), (count))) {\
                         { exec_on_failure }\
                 }\
         } while (0)
 
+/** Take count bytes from a struct results_buf into dst (see take_results),
+  * returning RESULTS_INCOMPLETE if it has fewer.
+  */
+#define TAKE(buf, dst, count)\
+        do {\
+                if (!take_results((buf), (dst), (count))) {\
+                        return RESULTS_INCOMPLETE;\
+                }\
+        } while (0)
+
+/** Add n to a counter which several threads may update at once. */
+#define ATOMIC_ADD(counter, n)\
+        __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+
 /** Indices to read/write from/to pipes. */
 #define R 0
 #define WR 1
 
+/** Tags of the records making up the results of a test (see
+  * write_test_results).
+  */
+#define RECORD_END '\0'
+#define RECORD_CHECK 'X'
+#define RECORD_CRASH 'S'
+#define RECORD_HEAP 'H'
+#define RECORD_PERF 'P'
+#define RECORD_PLACEMENT 'A'
+#define RECORD_RUN_TIME 'T'
+#define RECORD_SPAN 'W'
+#define RECORD_PROFILE 'F'
+#define RECORD_LOAD 'L'
+
+/** Ways a comment is sent (see write_comment). */
+#define COMMENT_NONE '\0'
+#define COMMENT_INLINE 'X'
+#define COMMENT_NEW 'N'
+#define COMMENT_SENT 'R'
+
+/** Most stack frames sent in a crash record. */
+#define MAX_CRASH_FRAMES 64
+
+/** Markers of the slots of heap_blocks without a block, and the fewest
+  * slots it has.
+  */
+#define HEAP_BLOCK_FREE 0
+#define HEAP_BLOCK_DELETED 1
+#define MIN_HEAP_BLOCKS 1024
+
+/** Most stack samples kept per profiled test (uc_set_profile), and most
+  * frames per sample.
+  */
+#define MAX_PROFILE_SAMPLES 16384
+#define MAX_PROFILE_FRAMES 64
+
+/** Microseconds of CPU time between stack samples (uc_set_profile). */
+#define PROFILE_INTERVAL_US 1000
+
+/** Size of the stack crash_handler runs on. */
+#define CRASH_STACK_SIZE (64 * 1024)
+
+/** Default for uc_set_output_limit. */
+#define DEFAULT_OUTPUT_LIMIT (64 * 1024)
+
+/** Space kept free in a struct results_buf for each read. */
+#define RESULTS_CHUNK 4096
+
+/** Default for uc_set_property_cases. */
+#define DEFAULT_PROPERTY_CASES 1000
+
+/** Most times a failed property is called while shrinking its case. */
+#define SHRINK_LIMIT 10000
+
+/** One in SMALL_CHOICE_ODDS random choices is below SMALL_CHOICE, so that
+  * edge cases like 0, bounds and empty strings come up often.
+  */
+#define SMALL_CHOICE_ODDS 8
+#define SMALL_CHOICE 16
+
+/** Default runs for uc_set_fuzz_limits. */
+#define DEFAULT_FUZZ_RUNS 100000
+
+/** Default seconds an input may run for, for uc_set_fuzz_timeout. */
+#define DEFAULT_FUZZ_TIMEOUT 1.0
+
+/** First and longest waits (ns) between checks on a fuzz child: short at
+  * first, as minimising forks many children which end quickly.
+  */
+#define FUZZ_POLL_MIN_NS 100000
+#define FUZZ_POLL_MAX_NS 10000000
+
+/** Longest input given to a fuzzed function. */
+#define MAX_FUZZ_INPUT 4096
+
+/** Most crashes a fuzz test reports before it stops. */
+#define MAX_FUZZ_CRASHES 8
+
+/** Most times a crashing input is tried while minimising it. */
+#define MINIMISE_LIMIT 1000
+
+/** Bytes of a crashing input shown in its check's comment. */
+#define SHOWN_FUZZ_BYTES 32
+
+/** Seconds a load test calls its function for if given no limits. */
+#define DEFAULT_LOAD_SECONDS 1.0
+
+/** Latency histograms (struct latency_histogram) count values below
+  * LATENCY_SUB_BUCKETS in buckets of their own, and larger values in
+  * LATENCY_SUB_BUCKETS / 2 buckets per power of 2, so buckets are at most
+  * 1/64 of their values wide.
+  */
+#define LATENCY_SUB_BITS 7
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 2) * LATENCY_SUB_BUCKETS / 2)
+
+/** Slots of the coverage map (power of 2). trace-pc-guard guards are
+  * numbered from 1 and share slots beyond this many.
+  */
+#define COVERAGE_MAP_SIZE (1 << 16)
+
+/** Bytes compared by each memcmp of first_difference. */
+#define SNAPSHOT_CHUNK (64 * 1024)
+
+/** Bytes shown either side of the first difference from a snapshot. */
+#define SNAPSHOT_CONTEXT 32
+
+/** Milliseconds without changes uc_watch waits for before restarting, so a
+  * rebuild has finished writing.
+  */
+#define WATCH_SETTLE_MS 100
+
+/** Changes uc_watch restarts on. */
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)
+
+/** gcov file magic numbers and record tags (GCC 12 and later). */
+#define GCOV_DATA_MAGIC 0x67636461
+#define GCOV_NOTE_MAGIC 0x67636e6f
+#define GCOV_TAG_FUNCTION 0x01000000
+#define GCOV_TAG_ARCS 0x01a10000
+
+/** Starting hash of fuzz_hash. */
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325
+
 static const char DEFAULT_SUITE_NAME[] = "Main";
 static const char INDENTATION[] = "    ";
 
+/** Heap use of a test (UC_OPT_HEAP_STATS). Sizes are those the test asked
+  * for, not what the allocator rounded them up to. Only blocks allocated
+  * while the test runs are counted: freeing or resizing a block allocated
+  * before it started counts for nothing.
+  */
+struct heap_stats {
+        size_t allocs;
+        size_t bytes;
+        long peak_bytes;
+        long live_blocks;
+        long live_bytes;
+};
+
+/** A slot of heap_blocks: a block counted in heap_stats and its size. */
+struct heap_block {
+        uintptr_t ptr;
+        size_t size;
+};
+
+/** Counters of UC_OPT_PERF_COUNTERS, indexing perf_counters. */
+enum counter {
+        COUNTER_TASK_CLOCK,
+        COUNTER_PAGE_FAULTS,
+        COUNTER_CONTEXT_SWITCHES,
+        COUNTER_CPU_MIGRATIONS,
+        COUNTER_INSTRUCTIONS,
+        COUNTER_CYCLES,
+        COUNTER_CACHE_MISSES,
+        NUM_COUNTERS
+};
+
+/** Counts of a test's function (UC_OPT_PERF_COUNTERS). Bit i of available
+  * is set if values[i] was counted.
+  */
+struct perf_counts {
+        uint64_t values[NUM_COUNTERS];
+        unsigned int available;
+};
+
+/** Where and how a test was run (uc_set_cpus, uc_set_nice,
+  * uc_set_realtime).
+  */
+struct placement {
+        /* CPU the test was pinned to, -1 if none. */
+        int cpu;
+        /* SCHED_FIFO with its priority, SCHED_OTHER with the nice level, or
+         * -1 if the scheduling was left alone.
+         */
+        int policy;
+        int priority;
+};
+
+/** How the runs of a repeated test went (uc_set_repeat). Runs are numbered
+  * from 1 in the order they were started.
+  */
+struct repeat_stats {
+        unsigned int runs;
+        unsigned int passed;
+        /* Lowest numbered run which failed, 0 if none. */
+        unsigned int first_failure;
+        /* Run whose results the test holds. */
+        unsigned int kept_run;
+        /* Checks made over all runs. */
+        unsigned long num_checks;
+        unsigned long num_succ;
+        /* Run times in seconds, of timed_runs runs. */
+        double min_time;
+        double max_time;
+        double total_time;
+        unsigned int timed_runs;
+};
+
+/** Results of a load test. Latencies are in seconds. */
+struct load_stats {
+        unsigned long calls;
+        unsigned long errors;
+        unsigned int callers;
+        double seconds;
+        double p50;
+        double p99;
+        double p999;
+        double max;
+};
+
+/** When a test process ran a test, in nanoseconds of CLOCK_MONOTONIC (which
+  * all processes share): from before its setup to before its results are
+  * written.
+  */
+struct test_span {
+        uint64_t start;
+        uint64_t end;
+};
+
+/** A stack of a test's profile (uc_set_profile): the names of its frames,
+  * outermost first and separated by ';', and the samples taken of it.
+  */
+struct folded_stack {
+        char *frames;
+        unsigned long count;
+};
+
 /** Representation of a call to uc_check. */
 struct check {
         bool result;
         char *comment;
+        /* Set if comment is not the check's own: borrowed from the caller
+         * of uc_check_borrowed or interned in the suite.
+         */
+        bool borrowed;
         /* Relative to the test this check is a part of. */
         unsigned int check_num;
 };
@@ -64,14 +336,473 @@ struct test {
 
         unsigned int test_num;
 
+        /* Group the test belongs to, NULL if none. */
+        struct group *group;
+
+        /* List of struct checks in REVERSE order. */
+        GList *checks;
+
+        /* Captured output (UC_OPT_CAPTURE_OUTPUT), NULL if none, its length
+         * (it may hold NUL bytes) and the number of bytes dropped from its
+         * front to fit the output limit.
+         */
+        char *output;
+        size_t output_len;
+        size_t output_dropped;
+        /* Whether the test's process died or its results were lost. */
+        bool run_failed;
+        /* Sent by the test's process if it crashed, NULL otherwise. */
+        struct crash *crash;
+        /* Sent by the test's process with UC_OPT_HEAP_STATS. */
+        struct heap_stats heap;
+        bool has_heap;
+        /* Sent by the test's process with UC_OPT_PERF_COUNTERS. */
+        struct perf_counts perf;
+        bool has_perf;
+        /* Left out of runs by uc_select_tests. */
+        bool skipped;
+        /* Resources the test takes (list of struct resource_use) and tests
+         * it runs after (list of struct tests), NULL if none. alone is set
+         * if it runs with no other test.
+         */
+        GList *uses;
+        GList *prerequisites;
+        bool alone;
+        /* In a run, whether the test has been started and has finished, and
+         * the prerequisite which did not pass if the test was not run
+         * because of it.
+         */
+        bool started;
+        bool finished;
+        struct test *blocked_by;
+        /* Sent by the test's process, or set by its thread, when placed. */
+        struct placement placement;
+        bool has_placement;
+        /* Sent by the test's process when repeated: seconds its test
+         * function took.
+         */
+        double run_time;
+        bool has_run_time;
+        /* Sent by the test's process when the run is traced (uc_set_trace).
+         */
+        struct test_span span;
+        bool has_span;
+        /* Folded stacks of the test (uc_set_profile), NULL if it was not
+         * profiled, until written by write_profiles. In the test's process,
+         * profiled is set if its samples are to be sent.
+         */
+        char *profile;
+        size_t profile_len;
+        bool profiled;
+        /* Set once the test has been repeated. Its other results are then
+         * those of one of its runs (see fold_run).
+         */
+        struct repeat_stats repeat;
+        bool has_repeat;
+
+        /* Added by uc_add_test_descs: name and comment are the descriptor's
+         * and the test is part of a struct described_test block.
+         */
+        bool described;
+
+        /* Added by uc_add_fuzz, NULL otherwise. Shared with runs of the test
+         * (init_run_test).
+         */
+        struct fuzz_target *fuzz;
+
+        /* Added by uc_add_load_test, NULL otherwise. Shared like fuzz. */
+        struct load_target *load;
+        /* Set once the load test ran. */
+        struct load_stats load_stats;
+        bool has_load;
+
+        /* Thread running the test. Its checks go straight to checks, those
+         * of other threads to their own struct check_buffer until merged by
+         * merge_check_buffers.
+         */
+        pthread_t owner;
+        pthread_mutex_t buffers_lock;
+        struct check_buffer *buffers;
+        /* Unique among all tests and changed by each merge, so a thread can
+         * tell whether its buffer still belongs to the test. Read and
+         * changed under buffers_lock.
+         */
+        unsigned long buffers_gen;
+};
+
+/** A file mapped by map_file. data is NULL if the file is empty. */
+struct mapped_file {
+        const char *data;
+        size_t len;
+};
+
+/** A path watched by uc_watch: a directory, or a file through the directory
+  * it is in.
+  */
+struct watched_path {
+        int wd;
+        /* Name of the file in the directory, NULL for the directory. */
+        char *name;
+};
+
+/** A test's entry in a coverage map (uc_set_coverage_map): one
+  * "F <start line> <end line> <function> <file>" line per function the test
+  * ran.
+  */
+struct map_entry {
+        char *key;
+        char *functions;
+};
+
+/** A coverage map read by read_coverage_map. */
+struct coverage_map {
+        /* List of struct map_entry in REVERSE order. */
+        GList *entries;
+        /* Test key to the entry's element of entries. */
+        GHashTable *index;
+};
+
+/** A function of a .gcno file. */
+struct covered_function {
+        char *name;
+        char *file;
+        uint32_t start_line;
+        uint32_t end_line;
+};
+
+/** Position in a gcov file being read. */
+struct gcov_reader {
+        const char *data;
+        size_t len;
+        size_t pos;
+};
+
+/** A changed file given to uc_select_tests, with the changed lines. */
+struct change {
+        char *path;
+        unsigned long first;
+        unsigned long last;
+};
+
+/** What a test added by uc_add_fuzz fuzzes. */
+struct fuzz_target {
+        void (*func)(const uint8_t *data, size_t size);
+        /* NULL if none. */
+        char *corpus_dir;
+};
+
+/** An input of a fuzz corpus. */
+struct fuzz_input {
+        size_t len;
+        uint8_t data[];
+};
+
+/** State of a fuzz test shared by its process and its workers, so it
+  * carries on from where a crashed worker left off.
+  */
+struct fuzz_shared {
+        /* Inputs started, including the one being run. */
+        unsigned long runs;
+        /* Set by a worker which reached the limits. */
+        bool done;
+        uint64_t rng[4];
+        /* Bucketed hit counts seen so far in each slot of the coverage map
+         * (see coverage_buckets).
+         */
+        uint8_t seen[COVERAGE_MAP_SIZE];
+        /* Input being run. */
+        size_t len;
+        uint8_t input[MAX_FUZZ_INPUT];
+};
+
+/** Latencies of calls in nanoseconds, counted in buckets (see
+  * latency_bucket). Histograms are merged by adding their counts.
+  */
+struct latency_histogram {
+        uint64_t counts[LATENCY_BUCKETS];
+        uint64_t total;
+        uint64_t max;
+};
+
+/** What a test added by uc_add_load_test calls. options has its defaults
+  * filled in.
+  */
+struct load_target {
+        bool (*func)(unsigned int caller);
+        struct uc_load_options options;
+};
+
+/** What a caller of a load test counted. */
+struct load_caller {
+        struct latency_histogram latencies;
+        unsigned long errors;
+};
+
+/** State of a load test shared by its process and its caller processes.
+  * Each caller only updates its own element of callers.
+  */
+struct load_shared {
+        /* Calls started by all callers, counted if calls are limited. */
+        unsigned long calls;
+        struct load_caller callers[];
+};
+
+/** A thread calling the function of a load test. */
+struct load_thread {
+        pthread_t thread;
+        const struct load_target *load;
+        struct load_shared *shared;
+        unsigned int caller;
+        /* CLOCK_MONOTONIC nanoseconds to stop calling at, 0 for none. */
+        uint64_t deadline;
+};
+
+/** A test added by uc_add_test_descs with its entry in the suite's tests.
+  * Each call allocates one block of these.
+  */
+struct described_test {
+        struct test test;
+        GList entry;
+        const struct uc_test_desc *desc;
+};
+
+/** What a test process sent when it crashed. */
+struct crash {
+        int signal;
+        uintptr_t address;
+        /* Last check made before the crash, 0 if none. */
+        unsigned int check_num;
+        /* Interned in the suite. */
+        const char *check_comment;
+        /* Symbolized stack frames, from backtrace_symbols. */
+        char **backtrace;
+        int num_frames;
+};
+
+/** Keeps the last capacity bytes appended to it. */
+struct output_ring {
+        char *data;
+        size_t capacity;
+        size_t start;
+        size_t len;
+        /* Bytes pushed out of the front. */
+        size_t dropped;
+};
+
+/** Results read from a test process, parsed up to pos. */
+struct results_buf {
+        char *data;
+        size_t len;
+        size_t capacity;
+        size_t pos;
+        /* Interned comments the process has sent with COMMENT_NEW, by id.
+         * NULL until the first.
+         */
+        GPtrArray *comments;
+};
+
+/** Outcome of parsing results from a struct results_buf. */
+enum results_status {
+        RESULTS_OK,
+        /* More has to be read first. */
+        RESULTS_INCOMPLETE,
+        RESULTS_INVALID
+};
+
+/** Outcome of reap_test. */
+enum reap_status {
+        REAP_DONE,
+        /* The process has not exited yet. */
+        REAP_PENDING,
+        REAP_FAILED
+};
+
+/** A test process run by uc_run_step and what it has sent so far. */
+struct slot {
+        /* -1 while no process runs in the slot. */
+        pid_t pid;
+        int results_fd;
+        /* Read end of the output pipe, -1 if output is not captured or all
+         * of it has been read.
+         */
+        int output_fd;
+        struct output_ring output_ring;
+        struct results_buf results;
+        /* Next test the process starts and how many tests of its batch are
+         * left to start.
+         */
+        GList *next;
+        unsigned int remaining;
+        /* Last test the process started (NULL if none) and whether all its
+         * results have been read.
+         */
+        GList *last;
+        bool last_done;
+        /* Set once the process sent something which is not results. */
+        bool invalid;
+        /* When repeating, the test the process runs once, which run it is
+         * and where its results are read to until fold_run; repeat_entry is
+         * NULL otherwise.
+         */
+        GList *repeat_entry;
+        unsigned int iteration;
+        struct test scratch;
+        GList scratch_entry;
+        /* Test whose resources the process holds, NULL if none. */
+        struct test *claimed;
+        /* Set once the process closed its results pipe, until it is reaped:
+         * the test it finished last (or could not start), whether all its
+         * results were read and when reaping started. pid_fd is a pidfd of
+         * the process, readable once it exits, or -1.
+         */
+        bool reaping;
+        GList *reap_entry;
+        bool reap_read_ok;
+        uint64_t reap_start;
+        int pid_fd;
+        /* When the last spans on the slot's lanes of a traced run ended (see
+         * trace_span).
+         */
+        uint64_t trace_ends[2];
+};
+
+/** Test processes shared by the runs of a uc_registry. */
+struct process_pool {
+        unsigned int size;
+        unsigned int busy;
+        /* Run whose test runs with no other test, or is the first test left
+         * of the run and waits for the pool to empty, NULL if none.
+         */
+        uc_run alone;
+        /* List of struct resources shared by name by the runs' suites. */
+        GList *resources;
+        /* Counts processes and runs given back, so runs left waiting in a
+         * pass of uc_registry_run get another.
+         */
+        unsigned long changes;
+};
+
+struct uc_run {
+        uc_suite suite;
+        /* Shared with the other runs of a uc_registry, NULL if not run by
+         * one.
+         */
+        struct process_pool *pool;
+        /* suite->tests when tests left out by uc_select_tests are hidden
+         * from the run, NULL otherwise.
+         */
+        GList *all_tests;
+        /* epoll instance watching the slots' pipes and event_fd, which is
+         * kept signalled while uc_run_step has work the pipes don't show.
+         */
+        int poll_fd;
+        int event_fd;
+        /* First test not yet given to a slot, NULL once all have been. */
+        GList *next;
+        /* Group of the tests last given to a slot. */
+        struct group *prev_group;
+        struct slot *slots;
+        unsigned int num_slots;
+        /* Set while a test which runs alone does. Also held by the pool,
+         * if any.
+         */
+        bool alone;
+        bool done;
+        /* With UC_OPT_THREADS, the thread running the tests from next up to
+         * the next group (see run_thread_segment), and the first test it
+         * leaves. It sets segment_done and signals event_fd once finished.
+         */
+        pthread_t segment_thread;
+        bool segment_running;
+        bool segment_done;
+        GList *segment_next;
+        /* When repeating, runs of next started so far, when the first one
+         * was, and whether to stop starting them (UC_OPT_REPEAT_UNTIL_FAILURE).
+         */
+        unsigned int iteration;
+        struct timespec repeat_start;
+        bool repeat_stop;
+        /* Trace written as the run goes (uc_set_trace), NULL if not traced,
+         * with the time the run started (see monotonic_ns), the parent's
+         * pid, and the values of its counter tracks.
+         */
+        FILE *trace;
+        uint64_t trace_start;
+        pid_t trace_pid;
+        unsigned int trace_children;
+        unsigned long long trace_bytes;
+};
+
+/** A suite of a uc_registry. */
+struct registry_entry {
+        uc_suite suite;
+        /* List of struct registry_entry of sub-suites in REVERSE order of
+         * addition.
+         */
+        GList *children;
+};
+
+struct uc_registry {
+        /* List of struct registry_entry of top-level suites in REVERSE order
+         * of addition.
+         */
+        GList *suites;
+        /* Test processes run at the same time, 0 for one per CPU. */
+        unsigned int jobs;
+};
+
+/** What the parent sends the zygote to spawn a test process for, with the
+  * process's struct test_fds attached.
+  */
+struct zygote_request {
+        GList *entry;
+        unsigned int length;
+        unsigned int slot;
+};
+
+/** File descriptors a test process writes to. */
+struct test_fds {
+        int results;
+        /* stdout and stderr, -1 when output is not captured. */
+        int output;
+};
+
+/** Checks one thread other than its owner made in a test. */
+struct check_buffer {
         /* List of struct checks in REVERSE order. */
         GList *checks;
+        struct check_buffer *next;
+};
+
+/** Something tests use which only capacity units of are available
+  * (uc_add_resource), of which in_use are taken by the tests running.
+  */
+struct resource {
+        char *name;
+        unsigned int capacity;
+        unsigned int in_use;
+        /* The pool's resource of the same name, whose units are taken
+         * instead, while run by a uc_registry. NULL otherwise.
+         */
+        struct resource *pooled;
+};
+
+/** Units of a resource a test takes while it runs (uc_test_uses). */
+struct resource_use {
+        struct resource *resource;
+        unsigned int units;
+};
+
+/** Fixture shared by consecutive tests, run in the parent process. */
+struct group {
+        void (*setup)(uc_suite);
+        void (*teardown)(uc_suite);
 };
 
 struct uc_suite {
         char *name;
         char *comment;
-        uint_least8_t options;
+        uint_least32_t options;
 
         unsigned int num_succ;
         unsigned int num_checks;
@@ -85,6 +816,277 @@ struct uc_suite {
          * not running, points to the final element of test.
          */
         GList *curr_test;
+
+        /* Run in the parent around all tests. */
+        void (*setup)(uc_suite);
+        void (*teardown)(uc_suite);
+        /* Run in the child around each test function. */
+        void (*test_setup)(uc_suite);
+        void (*test_teardown)(uc_suite);
+
+        /* Blocks of struct described_test, for freeing. */
+        GList *test_blocks;
+
+        /* Comments read from test processes, each kept once (see
+         * intern_comment). NULL until the first.
+         */
+        GHashTable *comments;
+
+        /* All groups (for freeing) and the group new tests are added to. */
+        GList *groups;
+        struct group *curr_group;
+
+        /* List of struct resources of the tests (uc_add_resource). */
+        GList *resources;
+
+        /* Zygote spawning test processes (UC_OPT_ZYGOTE) and the parent's end
+         * of its control socket. zygote is -1 when no zygote is running.
+         */
+        pid_t zygote;
+        int zygote_fd;
+        /* Exits of test processes the zygote reported before reap_test
+         * asked for them (struct zygote_reply).
+         */
+        GList *zygote_exits;
+
+        /* Maximum number of consecutive tests run by one process. */
+        unsigned int batch_size;
+
+        /* Number of tests run at the same time, 0 for one per CPU. */
+        unsigned int jobs;
+
+        /* CPUs test processes are pinned to by slot, NULL if not pinned. */
+        int *cpus;
+        size_t num_cpus;
+        /* Scheduling of test processes: a SCHED_FIFO priority if above 0,
+         * otherwise a nice level if has_nice.
+         */
+        int rt_priority;
+        int nice;
+        bool has_nice;
+
+        /* Bytes of output kept per test (UC_OPT_CAPTURE_OUTPUT). */
+        size_t output_limit;
+
+        /* Runs of each test (0 for no limit) and seconds to repeat each test
+         * for (0 for no limit). Tests are not repeated if both are left at
+         * 1 and 0.
+         */
+        unsigned int repeat_times;
+        double repeat_seconds;
+
+        /* Cases tried and seed used by uc_check_property. */
+        unsigned long property_cases;
+        uint64_t property_seed;
+
+        /* Inputs (0 for no limit) and seconds (0 for no limit) of each test
+         * added by uc_add_fuzz.
+         */
+        unsigned long fuzz_runs;
+        double fuzz_seconds;
+        /* Seconds (0 for no limit) before an input is reported as a hang. */
+        double fuzz_timeout;
+        /* Directory inputs reaching new coverage are written to, NULL for
+         * none (uc_set_fuzz_output).
+         */
+        char *fuzz_output;
+
+        /* Path of the coverage map (uc_set_coverage_map), NULL if none, and
+         * gcov's functions writing and clearing the process's counters.
+         * Test processes write each test's counters under coverage_dir
+         * during a run, NULL outside of one.
+         */
+        char *coverage_map;
+        void (*coverage_dump)(void);
+        void (*coverage_reset)(void);
+        char *coverage_dir;
+
+        /* Path runs write a trace to (uc_set_trace), NULL if none. */
+        char *trace_path;
+
+        /* Directory profiles of tests are written to (uc_set_profile), NULL
+         * if tests are not profiled, and the seconds a test function must
+         * take for its profile to be kept.
+         */
+        char *profile_dir;
+        double profile_min_seconds;
+};
+
+/** A case of uc_check_property. Its inputs are decided by a sequence of
+  * choices, each an integer up to a bound: new cases draw them at random and
+  * record them, and shrinking replays edited sequences. Generators map
+  * smaller choices to simpler values, so shortening the sequence or lowering
+  * a choice simplifies the case.
+  */
+struct uc_prop {
+        /* xoshiro256** state. */
+        uint64_t rng[4];
+
+        uint64_t *choices;
+        size_t num_choices;
+        size_t cap_choices;
+        /* Index of the next choice drawn. */
+        size_t next;
+        /* Whether choices are replayed rather than drawn at random. Choices
+         * past num_choices then replay as 0.
+         */
+        bool replay;
+        /* Set if a choice could not be recorded. */
+        bool failed;
+
+        /* Buffers of uc_gen_bytes and uc_gen_string, the n-th reused by the
+         * n-th call of each case.
+         */
+        char **bufs;
+        size_t *buf_sizes;
+        size_t num_bufs;
+        size_t next_buf;
+
+        /* Generated values, written when describe is set. */
+        bool describe;
+        char *desc;
+        size_t desc_len;
+        size_t desc_cap;
+
+        /* heap_paused of the caller, restored around the property. */
+        bool was_paused;
+};
+
+/** Deque of tests owned by a worker of the thread pool (UC_OPT_THREADS).
+  * entries is shared by all deques, each owning [front, back).
+  */
+struct work_deque {
+        pthread_mutex_t lock;
+        GList **entries;
+        unsigned int front;
+        unsigned int back;
+};
+
+struct thread_pool {
+        uc_suite suite;
+        struct work_deque *deques;
+        unsigned int num_workers;
+};
+
+struct pool_worker {
+        struct thread_pool *pool;
+        unsigned int id;
+        /* CPU the worker is pinned to (uc_set_cpus), -1 if none. */
+        int cpu;
+};
+
+/* The suite and test a thread of the thread pool is running. uc_check uses
+ * these in place of suite->curr_test when called for thread_suite.
+ */
+static __thread uc_suite thread_suite = NULL;
+static __thread GList *thread_test = NULL;
+
+/* Check buffer of the calling thread, valid while thread_buffer_test's
+ * buffers_gen is thread_buffer_gen.
+ */
+static __thread struct check_buffer *thread_buffer = NULL;
+static __thread struct test *thread_buffer_test = NULL;
+static __thread unsigned long thread_buffer_gen = 0;
+
+/* Source of struct test buffers_gen values. */
+static unsigned long buffers_gen_counter = 0;
+
+/** Signals which crash a test process, handled by crash_handler. */
+static const int crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL,
+                                     SIGABRT };
+#define NUM_CRASH_SIGNALS (sizeof(crash_signals) / sizeof(int))
+
+/* State of a test process for crash_handler: the test running, where its
+ * results go, and whether they are being written (the handler then writes
+ * nothing).
+ */
+static struct test *volatile crash_test = NULL;
+static volatile int crash_fd = -1;
+static volatile sig_atomic_t in_write_results = 0;
+
+/* Stack samples profile_handler takes in a test process (uc_set_profile):
+ * MAX_PROFILE_SAMPLES of MAX_PROFILE_FRAMES frames, innermost first, and
+ * the number of frames of each. profile_next counts the samples taken,
+ * including those which did not fit. profile_base holds a stack of
+ * run_test_child: the frames of its callers, which end the samples of the
+ * thread running tests, are left out of them.
+ */
+static void **profile_frames = NULL;
+static int *profile_depths = NULL;
+static unsigned long profile_next = 0;
+static void *profile_base[MAX_PROFILE_FRAMES];
+static int profile_base_depth = 0;
+
+/** Comments a test process has sent with COMMENT_NEW, mapped to their id
+  * plus one. Created by the first.
+  */
+static GHashTable *sent_comments = NULL;
+static uint32_t num_sent_comments = 0;
+
+/** Heap accounting in a test process (UC_OPT_HEAP_STATS). Allocations are
+  * only counted while heap_counting is set and the calling thread is not
+  * inside unitc (heap_paused), so checks don't count as leaks.
+  */
+static bool heap_counting = false;
+static __thread bool heap_paused = false;
+static struct heap_stats heap_stats;
+
+/** Blocks counted in heap_stats and not yet freed: an open addressing set of
+  * their addresses, with the sizes asked for, HEAP_BLOCK_FREE or
+  * HEAP_BLOCK_DELETED in slots without one. Mapped outside the heap, so
+  * updating it allocates nothing. heap_blocks_used counts the slots which are
+  * not free.
+  */
+static struct heap_block *heap_blocks = NULL;
+static size_t heap_blocks_size = 0;
+static size_t heap_blocks_used = 0;
+static size_t heap_blocks_live = 0;
+static pthread_mutex_t heap_blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Hit counts of the slots of the coverage map in a fuzz worker, counted by
+  * the -fsanitize-coverage callbacks while coverage_on is set, and the
+  * slots hit since new_coverage last cleared them. Nothing is counted unless
+  * the program is built with coverage callbacks. num_guards numbers the
+  * guards of trace-pc-guard.
+  */
+static uint8_t coverage[COVERAGE_MAP_SIZE];
+static uint32_t touched[COVERAGE_MAP_SIZE];
+static uint32_t num_touched = 0;
+static uint32_t num_guards = 0;
+static bool coverage_on = false;
+
+/** What perf_event_open counts for each enum counter. */
+static const struct {
+        uint32_t type;
+        uint64_t config;
+        const char *name;
+} perf_counters[NUM_COUNTERS] = {
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-clock" },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults" },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES,
+          "context-switches" },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "cpu-migrations" },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache-misses" }
+};
+
+/** The C library's allocator, which the wrappers below forward to. */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t num, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+extern void __libc_free(void *ptr);
+
+/** Reply from the zygote: the pid of the test process it spawned (-1 if
+  * it could not), or, with exited set, that a test process has finished.
+  */
+struct zygote_reply {
+        pid_t pid;
+        bool exited;
+        int wstatus;
 };
 
 static void output_indent(const unsigned int level);
@@ -121,386 +1123,7696 @@ static void output_main_header(uc_suite);
   * abort() is called.
   *
   * Format:
-  *  1. Write any non-null character if the checks list is not empty. If the
-  *     checks list is empty, skip to #8.
+  *  1. Write RECORD_CHECK if the checks list still has elements. If it does
+  *     not, skip to #6.
   *  2. Write a bool for the result of the current check.
-  *  3. Write a null character if no comment exists for the current check, and
-  *     skip to #6. Otherwise write a non-null character.
+  *  3. Write COMMENT_NONE if no comment exists for the current check, and
+  *     skip to #1. If the process sent the comment before, write
+  *     COMMENT_SENT and its uint32_t id, and skip to #1. Otherwise write
+  *     COMMENT_NEW followed by the next id (from 0) - or COMMENT_INLINE
+  *     without an id if the comment is not to be remembered.
   *  4. Write a size_t for the number of characters in the comment string of
   *     the current check (does not include the terminating null character).
   *  5. Write the comment string from the current check, including the
-  *     terminating null character.
-  *  6. Write a non-null character if the checks list still has elements.
-  *  7. Repeat #2-#6 until the entire checks list has been written.
-  *  8. Write a null character.
+  *     terminating null character. Repeat from #1.
+  *  6. Write RECORD_HEAP followed by a struct heap_stats if test has heap
+  *     stats.
+  *  7. Write RECORD_PERF followed by a struct perf_counts if test has
+  *     performance counts.
+  *  8. Write RECORD_PLACEMENT followed by a struct placement if test was
+  *     placed.
+  *  9. Write RECORD_RUN_TIME followed by a double if test was timed.
+  * 10. Write RECORD_SPAN followed by a struct test_span if the run is
+  *     traced.
+  * 11. Write RECORD_PROFILE followed by a profile record (see
+  *     write_profile) if test was profiled.
+  * 12. Write RECORD_LOAD followed by a struct load_stats if test is a load
+  *     test which ran.
+  * 13. Write RECORD_END.
+  *
+  * A test process which crashes writes its checks as in #1-#5, then
+  * RECORD_CRASH followed by a crash record (see crash_handler) and
+  * RECORD_END.
   */
 static void write_test_results(const struct test *test, const int wr_fd);
-/** Reads the results from r_fd and fills in the curr_test in the suite.
-  * The checks list is populated by calling uc_check. Returns true if FULL
-  * results were read, otherwise returns false.
+/** Writes check as in #1-#5 of write_test_results' format. Returns false if
+  * a write fails.
+  */
+static bool write_check(const struct check *check, const int wr_fd,
+                        const bool intern);
+/** Writes comment as in #3-#5 of write_test_results' format (NULL for no
+  * comment). With intern, a comment sent before is sent by its id and a new
+  * one is given an id (in sent_comments); otherwise it is sent inline, which
+  * does not allocate (for crash_handler). Returns false if a write fails.
+  */
+static bool write_comment(const char *comment, const int wr_fd,
+                          const bool intern);
+/** Writes a non-null character to wr_fd before a test starts running, so a
+  * process running several tests can be followed test by test. If the write
+  * fails, abort() is called.
+  */
+static void write_test_start(const int wr_fd);
+/** Parses the results of one test from buf and fills in the curr_test in
+  * the suite. The checks list is populated by calling uc_check. With
+  * dry_run, only finds whether all of the results are in buf. Returns
+  * RESULTS_INCOMPLETE if buf ends first, leaving buf->pos anywhere.
   *
   * The format is as defined by write_test_results.
   */
-static bool read_test_results(uc_suite, const int r_fd);
+static enum results_status read_test_results(uc_suite,
+                                             struct results_buf *buf,
+                                             const bool dry_run);
+/** Parses what write_comment wrote into comment, interned in suite (NULL
+  * for no comment). Skips the comment if comment is NULL. Returns
+  * RESULTS_INVALID if it cannot be saved.
+  */
+static enum results_status read_comment(uc_suite, struct results_buf *buf,
+                                        const char **comment);
 
-static void struct_check_free(void *);
-static void struct_test_free(void *);
+/** Returns the copy of comment kept in suite->comments, adding one if there
+  * is none, or NULL if it cannot be added.
+  */
+static const char *intern_comment(uc_suite, const char *comment);
+/** Parses a crash record (following RECORD_CRASH) into curr_test's crash,
+  * symbolizing its stack frames, unless dry_run is set.
+  */
+static enum results_status read_crash_record(uc_suite,
+                                             struct results_buf *buf,
+                                             const bool dry_run);
 
-uc_suite uc_init(const uint_least8_t options, const char *name,
+/** Copies the next count bytes of buf to dst, or skips them if dst is NULL.
+  * Returns false if buf has fewer.
+  */
+static bool take_results(struct results_buf *buf, void *dst,
+                         const size_t count);
+
+/** Appends what can be read from fd without blocking to buf. Returns false
+  * at end of file or on error.
+  */
+static bool fill_results(struct results_buf *buf, const int fd);
+
+/** Installs crash_handler for signals which crash a test process. */
+static void install_crash_handlers(void);
+
+/** Restores the default action of the signals of install_crash_handlers, in
+  * children of a test process whose crashes are not the test's.
+  */
+static void reset_crash_handlers(void);
+
+/** Sends the checks made so far by crash_test and a crash record to crash_fd
+  * and lets the signal kill the process. Only uses async-signal-safe calls
+  * (backtrace is loaded beforehand by install_crash_handlers).
+  *
+  * Crash record format:
+  *  1. Write an int for the signal number.
+  *  2. Write a uintptr_t for the faulting address (0 if not applicable).
+  *  3. Write an unsigned int for the number of the last check.
+  *  4. Write the comment of the last check as per write_comment.
+  *  5. Write an int for the number of stack frames and that many void *s for
+  *     the return addresses of the frames.
+  */
+static void crash_handler(int signal, siginfo_t *info, void *context);
+
+/** Calls hook (if not NULL) in the parent with checks counting as dangling
+  * checks.
+  */
+static void run_parent_hook(uc_suite, void (*hook)(uc_suite));
+
+/** Gives tests to the free slots of run, as many as one batch each. A new
+  * group is only started once no slot is busy.
+  */
+static void fill_slots(uc_run);
+
+/** The first test of run's current group which can start now, with the
+  * number of tests to start with it in *length, or NULL if none can. Tests
+  * whose prerequisites did not pass are marked as failed to run on the way.
+  */
+static GList *next_startable(uc_run, unsigned int *length);
+
+/** Whether the resources or prerequisites of test constrain when it runs. */
+static bool test_constrained(const struct test *test);
+
+/** Whether all of test's prerequisites have finished, setting its
+  * blocked_by to the first which did not pass, if any.
+  */
+static bool prerequisites_finished(struct test *test);
+
+/** Whether the resources test uses are free. */
+static bool resources_free(const struct test *test);
+
+/** The resource whose units are taken for resource: its pooled one if any.
+  */
+static struct resource *held_resource(struct resource *resource);
+
+/** The resource of pool called like resource, added with resource's capacity
+  * if it was not already, and lowered to it if larger. NULL if it cannot be
+  * allocated.
+  */
+static struct resource *pool_resource(struct process_pool *pool,
+                                      const struct resource *resource);
+
+/** Takes the resources test uses for slot's process, or gives back those
+  * slot holds.
+  */
+static void claim_resources(uc_run, struct slot *, struct test *test);
+static void release_resources(uc_run, struct slot *);
+
+/** Marks test as started and finished without running it, failed to run if
+  * run_failed.
+  */
+static void pass_over_test(struct test *test, const bool run_failed);
+
+/** The resource of suite called name, declared with 1 unit if it was not
+  * already. NULL if it cannot be allocated.
+  */
+static struct resource *find_resource(uc_suite, const char *name);
+
+/** Frees a struct resource. */
+static void struct_resource_free(void *);
+
+/** Starts a process in slot for the length tests starting at entry. Returns
+  * false if it cannot be started.
+  */
+static bool start_batch(uc_run, struct slot *, GList *entry,
+                        const unsigned int length);
+
+/** Reads what slot's process has sent, records the results of the tests it
+  * finished, and finishes the slot once the process is done.
+  */
+static void service_slot(uc_run, struct slot *);
+
+/** Records the results of the tests completely in slot's results buffer. */
+static void parse_results(uc_run, struct slot *);
+
+/** Closes slot's pipes once its process is done with them (killing it
+  * first if kill_first) and reaps it with reap_slot.
+  */
+static void finish_slot(uc_run, struct slot *, const bool kill_first);
+
+/** Reaps slot's process if it has exited, or else watches for its exit and
+  * returns, to be called again by a later step. Once reaped, deals with the
+  * test it did not finish, if any, and starts a new process for the rest of
+  * its batch.
+  */
+static void reap_slot(uc_run, struct slot *);
+
+/** Stops watching slot's pipes and pidfd and closes them. */
+static void close_slot_fds(uc_run, struct slot *);
+
+/** Closes slot's file descriptors and frees it for another process. */
+static void close_slot(uc_run, struct slot *);
+
+/** Whether a process runs in slot, or in any slot of run (or a segment of
+  * run's tests on a thread, with UC_OPT_THREADS).
+  */
+static bool slot_busy(const struct slot *);
+static bool run_busy(uc_run);
+
+/** Stops the zygote and runs the remaining group and suite teardowns. */
+static void finish_run(uc_run);
+
+/** Frees run, closing what it has open. */
+static void struct_run_free(uc_run);
+
+/** Starts running suite's tests, in as many processes at a time as pool
+  * allows if not NULL. See uc_run_tests_async.
+  */
+static uc_run start_run(uc_suite, struct process_pool *pool);
+
+/** Whether pool is not NULL and all of its processes are busy. */
+static bool pool_full(const struct process_pool *pool);
+
+/** Whether pool is NULL, or has no processes busy and no test running alone
+  * or waiting to.
+  */
+static bool pool_idle(const struct process_pool *pool);
+
+/** Whether a test of run which runs alone has to wait: processes of run, or
+  * of its pool, are busy.
+  */
+static bool alone_waits(uc_run);
+
+/** Opens suite's trace for run and writes the names of its lanes: two per
+  * slot, one for what the slot's processes do and one for the transfer of
+  * their results, which overlaps the next test of a batch. The run is not
+  * traced if the file cannot be opened.
+  */
+static void start_trace(uc_run run);
+
+/** Writes the end of run's trace and closes it. */
+static void finish_trace(uc_run run);
+
+/** Writes a span named name from start to end (see monotonic_ns) on a lane
+  * of slot to run's trace (its results lane if results), with args (the
+  * members of a JSON object, NULL for none). The span is clipped to start
+  * after the last one on the lane, which viewers expect: a test process
+  * can start before fork returns in the parent.
+  */
+static void trace_span(uc_run run, struct slot *slot, const bool results,
+                       const char *name, const uint64_t start,
+                       const uint64_t end, const char *args);
+
+/** Writes the value of the counter track name, as series, to run's trace. */
+static void trace_counter(uc_run run, const char *name, const char *series,
+                          const unsigned long long value);
+
+/** Writes the spans of test, whose results slot has just read (bytes of
+  * them), to run's trace.
+  */
+static void trace_test(uc_run run, struct slot *slot,
+                       const struct test *test, const size_t bytes);
+
+/** Marks the end of the run of the repeated test whose results are kept,
+  * with an instant event in run's trace.
+  */
+static void trace_kept_run(uc_run run, const struct test *test);
+
+/** Outputs string to out as a JSON string, quoted and escaped. */
+static void output_json_string(FILE *out, const char *string);
+
+/** Current time of CLOCK_MONOTONIC in nanoseconds. */
+static uint64_t monotonic_ns(void);
+
+/** The entry of suite among entries or their sub-suites, NULL if none. */
+static struct registry_entry *find_entry(GList *entries, uc_suite);
+
+/** Prepends the suites of entries, each followed by its sub-suites, to
+  * suites.
+  */
+static GList *flatten_entries(GList *entries, GList *suites);
+
+/** Outputs the results of the suites of entries and their sub-suites. */
+static void output_registry_entries(GList *entries, const unsigned int indent);
+
+/** Frees a struct registry_entry with its suite and sub-suites. */
+static void struct_registry_entry_free(void *);
+
+/** Whether suite's tests are repeated (uc_set_repeat). */
+static bool repeating(uc_suite);
+
+/** Whether all runs of run->next have been started. */
+static bool repeat_done(uc_run);
+
+/** Starts run number iteration of the test at entry in slot. A run which
+  * cannot be started counts as failed to run.
+  */
+static void start_iteration(uc_run, struct slot *, GList *entry,
+                            const unsigned int iteration);
+
+/** Initialises test as having no results, except for its name and
+  * comment.
+  */
+static void init_test(struct test *test, void (*test_func)(uc_suite),
+                      const unsigned int test_num, struct group *group);
+
+/** Orders struct described_tests by the file and line of their descriptors.
+  */
+static int compare_described_tests(const void *a, const void *b);
+
+/** Sets up run_test to receive the results of one run of test. */
+static void init_run_test(struct test *run_test, const struct test *test);
+
+/** Adds run number iteration, whose results are in run_test, to test's
+  * struct repeat_stats. test keeps the results of its lowest numbered
+  * failed run, or of its lowest numbered run if none failed; the others are
+  * freed along with run_test.
+  */
+static void fold_run(uc_run, struct test *test, struct test *run_test,
+                     const unsigned int iteration);
+
+/** Swaps the results (checks, crash, output, ...) of a and b. */
+static void swap_results(struct test *a, struct test *b);
+
+/** Seconds from start to end. */
+static double seconds_between(const struct timespec *start,
+                              const struct timespec *end);
+
+/** Runs the tests from entry up to the next group (or between groups) in the
+  * calling process on a pool of threads (UC_OPT_THREADS). Returns the first
+  * test not run, NULL if none.
+  */
+static GList *run_thread_segment(uc_suite, GList *entry);
+
+/** Runs run's next segment of tests on the thread started by
+  * start_segment. Returns NULL.
+  */
+static void *segment_main(void *run);
+
+/** Starts running run's next segment of tests on a thread of its own, or
+  * runs it in the calling thread if one cannot be created.
+  */
+static void start_segment(uc_run);
+
+/** Waits for the thread running run's segment of tests, if any, and moves
+  * run past the segment.
+  */
+static void join_segment(uc_run);
+
+/** Runs the num_tests tests in entries on num_workers threads (including the
+  * calling thread) and returns once they have all finished.
+  */
+static void run_thread_pool(uc_suite, GList **entries,
+                            const unsigned int num_tests,
+                            const unsigned int num_workers);
+
+/** Thread function of a struct pool_worker. */
+static void *pool_worker_main(void *worker);
+
+/** Takes the next test for worker id to run, stealing from other workers
+  * once its own deque is empty. Returns NULL when no tests are left.
+  */
+static GList *take_test(struct thread_pool *, const unsigned int id);
+
+/** Number of tests, starting from the test at entry, to run in one process:
+  * at most the suite's batch size, never across groups and only up to a
+  * test which has been started or is constrained (see test_constrained).
+  */
+static unsigned int batch_length(uc_suite, GList *entry);
+
+/** Runs the length tests starting at entry in the current process, writes
+  * their results to fds as each finishes and exits. Only called in a freshly
+  * forked test process.
+  */
+static void run_test_child(uc_suite, GList *entry, const unsigned int length,
+                           const unsigned int slot,
+                           const struct test_fds *fds);
+
+/** Starts a process in slot for the length tests starting at entry writing
+  * to fds - forked directly or, with a zygote, by the zygote. On success,
+  * sets pid and returns true.
+  */
+static bool spawn_test(uc_suite, GList *entry, const unsigned int length,
+                       const unsigned int slot, const struct test_fds *fds,
+                       pid_t *pid);
+
+/** Reaps the test process started by spawn_test and sets wstatus, waiting
+  * for it to exit if wait is set. Returns REAP_PENDING if it has not
+  * exited and wait is not set.
+  */
+static enum reap_status reap_test(uc_suite, const pid_t pid, int *wstatus,
+                                  const bool wait);
+
+/** Forks the zygote which spawns test processes sent to it over a socket,
+  * keeping spawn cost independent of the parent's heap. Returns false on
+  * failure, in which case tests are forked directly.
+  */
+static bool start_zygote(uc_suite);
+
+/** Closes the zygote's control socket and waits for it to exit. */
+static void stop_zygote(uc_suite);
+
+/** Main loop of the zygote process, told of its test processes' exits by
+  * sig_fd (a signalfd for SIGCHLD). Never returns.
+  */
+static void zygote_loop(uc_suite, const int ctl_fd, const int sig_fd);
+
+/** Reaps the zygote's finished test processes and reports their exits to
+  * ctl_fd. Returns false if a report cannot be written.
+  */
+static bool send_exits(const int ctl_fd);
+
+/** Reads the zygote's reply to a spawn request, or with pid, the exit of
+  * pid, into reply. Other exits are kept in suite->zygote_exits. Returns
+  * false on error.
+  */
+static bool read_zygote_reply(uc_suite, const pid_t pid,
+                              struct zygote_reply *reply);
+
+/** Reads the exits the zygote has reported into suite->zygote_exits without
+  * blocking. Returns false on error.
+  */
+static bool read_zygote_exits(uc_suite);
+
+/** Removes all results of test, including from the suite totals. */
+static void clear_test_results(uc_suite, struct test *test);
+
+/** Like read and write, but retry until count bytes have been transferred.
+  * Return false on error or end of file.
+  */
+static bool read_full(const int fd, void *buf, size_t count);
+static bool write_full(const int fd, const void *buf, size_t count);
+
+/** Reads what is available on slot->output_fd into slot->output_ring.
+  * Closes it and sets it to -1 at end of file.
+  */
+static void drain_output(uc_run, struct slot *);
+
+/** Drains what is left of slot's output and moves it from its output_ring
+  * to test, unless it is empty or to be discarded.
+  */
+static void attach_output(uc_run, struct slot *, struct test *test);
+
+/** Appends len bytes of buf to ring, dropping from its front to fit. */
+static void output_ring_append(struct output_ring *ring, const char *buf,
+                               size_t len);
+
+/** Outputs test's heap stats, if it has any. */
+static void output_test_heap(struct test *test, const unsigned int indent);
+
+/** Outputs test's performance counts, if it has any. */
+static void output_test_perf(struct test *test, const unsigned int indent);
+
+/** Outputs where and how test was run, if it was placed. */
+static void output_test_placement(struct test *test,
+                                  const unsigned int indent);
+
+/** Outputs how test crashed or that it failed to run, if it did. */
+static void output_test_crash(struct test *test, const unsigned int indent);
+
+/** Outputs that test was not run, if left out by uc_select_tests. */
+static void output_test_skipped(struct test *test, const unsigned int indent);
+
+/** Outputs how the runs of a repeated test went:
+  * [indent]Runs: p/n passed (x%), first failure in run i.
+  * [indent]Checks over all runs: x/y.
+  * [indent]Run time: min x ms, mean y ms, max z ms.
+  */
+static void output_test_repeat(struct test *test, const unsigned int indent);
+
+/** Outputs the results of a load test (uc_add_load_test):
+  * [indent]Load: n calls from c callers in s s (x calls/s), e failed (y%).
+  * [indent]Latency: p50 a us, p99 b us, p99.9 c us, max d us.
+  */
+static void output_test_load(struct test *test, const unsigned int indent);
+
+/** Outputs test's captured output, indented, if it failed. */
+static void output_test_output(struct test *test, const unsigned int indent);
+
+/** Returns the calling thread's check buffer for test, adding one to test if
+  * needed, with test's buffers_lock held so a merge cannot free the buffer
+  * while it is used. The caller unlocks. Returns NULL, unlocked, on
+  * allocation failure.
+  */
+static struct check_buffer *lock_check_buffer(struct test *test);
+
+/** Moves the checks of all of test's check buffers into its checks list,
+  * ordered by check number. Checks made at the same time go to new buffers,
+  * merged the next time.
+  */
+static void merge_check_buffers(struct test *test);
+
+/** Orders struct checks by descending check_num (i.e. REVERSE order). */
+static gint compare_checks(gconstpointer a, gconstpointer b);
+
+/** Whether the calling thread's allocations are to be counted. */
+static bool heap_counted(void);
+
+/** Zero heap_stats and start counting allocations. */
+static void heap_start(void);
+
+/** Count an allocation of size bytes at ptr, or a resize to size bytes of
+  * one of old_size bytes when resized is true.
+  */
+static void heap_count_alloc(void *ptr, const size_t size,
+                             const bool resized, const size_t old_size);
+
+/** Count ptr being freed, if it was counted when allocated. */
+static void heap_count_free(void *ptr);
+
+/** Add ptr, of size bytes, to heap_blocks, growing it as needed. Returns
+  * false on failure, when ptr is not counted.
+  */
+static bool add_heap_block(void *ptr, const size_t size);
+
+/** Remove ptr from heap_blocks, setting *size to its size. Returns whether
+  * it was there.
+  */
+static bool remove_heap_block(void *ptr, size_t *size);
+
+/** Slot of heap_blocks holding ptr or, if none does, the first free slot
+  * on its probe sequence. heap_blocks must not be full.
+  */
+static size_t find_heap_block(const uintptr_t ptr);
+
+/** Allocates the buffers of profile_handler and records profile_base from
+  * the calling run_test_child. Returns false on failure.
+  */
+static bool init_profile(void);
+
+/** Frees the buffers of profile_handler. */
+static void free_profile(void);
+
+/** Starts taking stack samples of the calling process every
+  * PROFILE_INTERVAL_US of its CPU time, or stops.
+  */
+static void start_profile(void);
+static void stop_profile(void);
+
+/** SIGPROF handler taking a stack sample. */
+static void profile_handler(int signal);
+
+/** Writes the samples taken since start_profile to wr_fd as a profile
+  * record: an unsigned long for the number of samples taken, a uint32_t for
+  * the number of distinct stacks, then for each stack a uint32_t for its
+  * samples, an int for its number of frames and its frames (void *),
+  * innermost first. Returns false if a write fails.
+  */
+static bool write_profile(const int wr_fd);
+
+/** Orders samples of profile_frames, given by index, by their stacks. */
+static int compare_samples(const void *a, const void *b);
+
+/** Parses a profile record into the folded stacks of the suite's
+  * curr_test, merging stacks whose frames have the same names. See
+  * read_test_results.
+  */
+static enum results_status read_profile_record(uc_suite,
+                                               struct results_buf *buf,
+                                               const bool dry_run);
+
+/** Orders struct folded_stacks by their frames. */
+static int compare_folded_stacks(const void *a, const void *b);
+
+/** Outputs the function of a frame described by backtrace_symbols as
+  * symbol to out, or its module and offset if it has no name.
+  */
+static void output_frame(FILE *out, const char *symbol);
+
+/** Writes the profiles of suite's tests under its profile_dir and frees
+  * them.
+  */
+static void write_profiles(uc_suite);
+
+/** Opens a counter of the calling process for each enum counter, disabled.
+  * fds[i] is -1 for counters which cannot be opened (e.g. without a PMU or
+  * permission).
+  */
+static void open_perf_counters(int fds[NUM_COUNTERS]);
+
+/** Resets and enables the counters opened by open_perf_counters. */
+static void start_perf_counters(const int fds[NUM_COUNTERS]);
+
+/** Disables the counters opened by open_perf_counters and reads them into
+  * counts.
+  */
+static void stop_perf_counters(const int fds[NUM_COUNTERS],
+                               struct perf_counts *counts);
+
+/** Fills in suite->cpus from the calling process's affinity mask if
+  * UC_OPT_PIN_CPUS is set and no CPUs were given by uc_set_cpus, taking one
+  * CPU of each core.
+  */
+static void resolve_cpus(uc_suite);
+
+/** Whether cpu is the lowest of the CPUs in allowed sharing its core, as
+  * listed in its topology/thread_siblings_list. true if that can't be read.
+  */
+static bool first_sibling(const int cpu, const cpu_set_t *allowed);
+
+/** Pins the calling test process to the CPU of slot and sets its scheduling
+  * as configured for suite, recording what took effect in placement.
+  * Returns false if nothing was configured.
+  */
+static bool place_test_process(uc_suite, const unsigned int slot,
+                               struct placement *placement);
+
+/** Adds a check with cond and comment to suite (see uc_check), copying
+  * comment unless borrow is set.
+  */
+static void add_check(uc_suite, const bool cond, const char *comment,
+                      const bool borrow);
+
+/** A seed for uc_check_property differing between suites and runs. */
+static uint64_t default_property_seed(void);
+
+/** splitmix64, to spread a seed over a xoshiro256** state (next_random). */
+static uint64_t splitmix(uint64_t *state);
+
+/** realloc for the machinery of uc_check_property, which is unitc's memory
+  * rather than the test's (heap_paused).
+  */
+static void *prop_realloc(void *ptr, const size_t size);
+
+/** Draws the next choice of prop, in [0, bound]. */
+static uint64_t draw(struct uc_prop *prop, const uint64_t bound);
+
+/** Appends to the description of the values generated by prop. */
+static void describe(struct uc_prop *prop, const char *format, ...)
+        __attribute__((format(printf, 2, 3)));
+
+/** Separates the values of a description. */
+static void describe_next(struct uc_prop *prop);
+
+/** Returns the next buffer of prop for a generator, of at least size bytes,
+  * or NULL on allocation failure.
+  */
+static char *prop_buffer(struct uc_prop *prop, const size_t size);
+
+/** Runs a case of property: a new one if choices is NULL, otherwise one
+  * replaying num_choices choices. Returns whether property held.
+  */
+static bool run_case(struct uc_prop *prop, bool (*property)(uc_prop, void *),
+                     void *data, const uint64_t *choices,
+                     const size_t num_choices);
+
+/** Whether choices a are simpler than b, which has as many: lower at the
+  * first difference.
+  */
+static bool choices_less(const uint64_t *a, const uint64_t *b,
+                         const size_t num);
+
+/** Replays the num_candidate choices of candidate, keeping them in best if
+  * property fails on them and they are simpler than the num_best of best.
+  * Returns whether best was replaced. Counts calls, up to SHRINK_LIMIT.
+  */
+static bool try_shrink(struct uc_prop *prop,
+                       bool (*property)(uc_prop, void *), void *data,
+                       const uint64_t *candidate, const size_t num_candidate,
+                       uint64_t *best, size_t *num_best, unsigned int *calls);
+
+/** Shrinks the num_best choices of best, a case property fails on, to a
+  * simpler one it still fails on: by deleting runs of choices (also lowering
+  * the choice before, often a length) and by lowering each choice as far as
+  * it goes, until neither helps. candidate is scratch space as large as best.
+  * Returns the number of times best was made simpler.
+  */
+static unsigned int shrink(struct uc_prop *prop,
+                           bool (*property)(uc_prop, void *), void *data,
+                           uint64_t *best, size_t *num_best,
+                           uint64_t *candidate);
+
+/** Fuzzes the running test, added by uc_add_fuzz: the test_func of such
+  * tests.
+  */
+static void run_fuzz_test(uc_suite);
+
+/** waitpid for a child of a fuzz test, retried if interrupted. With a
+  * timeout above 0, kills the child if it spends longer than timeout seconds
+  * on one input and sets *hung (if not NULL): runs, if not NULL, counts the
+  * inputs it has started, else its whole run is one input.
+  */
+static bool wait_fuzz_child(const pid_t pid, int *wstatus,
+                            const volatile unsigned long *runs,
+                            const double timeout, bool *hung);
+
+/** Runs fuzz->func on inputs until the suite's fuzz limits are reached, then
+  * exits after setting shared->done. Runs in a child of the fuzz test.
+  */
+static void fuzz_worker(uc_suite, const struct fuzz_target *fuzz,
+                        struct fuzz_shared *shared,
+                        const struct timespec *start)
+        __attribute__((noreturn));
+
+/** Adds the files in dir, if any, to corpus as struct fuzz_inputs. */
+static void load_corpus(const char *dir, GPtrArray *corpus);
+
+/** Orders strings by strcmp, for qsort. */
+static int compare_names(const void *a, const void *b);
+
+/** Adds len bytes of data to corpus, and writes it to dir unless NULL. */
+static void add_to_corpus(const char *dir, GPtrArray *corpus,
+                          const uint8_t *data, const size_t len);
+
+/** Sets shared's input to a random mutation of an input of corpus. */
+static void mutate_input(struct fuzz_shared *shared, GPtrArray *corpus);
+
+/** The bit for the bucket of a number of hits: 1, 2, 3, 4-7, 8-15, 16-31,
+  * 32-127 or 128+. 0 for no hits.
+  */
+static uint8_t coverage_bucket(const uint8_t hits);
+
+/** Counts a hit of slot of the coverage map, up to 255. */
+static void count_hit(const uint32_t slot);
+
+/** Adds the buckets hit in coverage to shared->seen, returning whether any
+  * were new, and clears coverage.
+  */
+static bool new_coverage(struct fuzz_shared *shared);
+
+/** Minimises shared's input, which ended a worker with wstatus (or hung,
+  * which is reported as is), and adds a failed check for it unless one of the
+  * num_reported hashes (fuzz_hash of the minimised input and wstatus) in
+  * reported is the same. Adds its hash to reported otherwise.
+  */
+static void report_fuzz_crash(uc_suite, const struct fuzz_target *fuzz,
+                              struct fuzz_shared *shared, const int wstatus,
+                              const bool hung, uint64_t *reported,
+                              unsigned int *num_reported);
+
+/** FNV-1a of len bytes of data, continuing from hash. */
+static uint64_t fuzz_hash(uint64_t hash, const void *data, const size_t len);
+
+/** Shrinks the len bytes of input, which end fuzz->func with wstatus, while
+  * they still do within timeout seconds. Returns the length left.
+  */
+static size_t minimise_input(const struct fuzz_target *fuzz, uint8_t *input,
+                             size_t len, const int wstatus,
+                             const double timeout);
+
+/** Whether fuzz->func, called on input in a child, ends it with wstatus
+  * within timeout seconds (0 for no limit).
+  */
+static bool crashes_like(const struct fuzz_target *fuzz, const uint8_t *input,
+                         const size_t len, const int wstatus,
+                         const double timeout);
+
+/** Load tests the running test, added by uc_add_load_test: the test_func of
+  * such tests.
+  */
+static void run_load_test(uc_suite);
+
+/** Calls load->func from the callers of a process, numbered from first:
+  * from the calling thread and load->options.threads - 1 threads it
+  * starts. Returns false if a thread could not be started.
+  */
+static bool run_load_callers(const struct load_target *load,
+                             struct load_shared *shared,
+                             const unsigned int first, const uint64_t deadline);
+
+/** Calls the function of a load test until the limits are reached, timing
+  * each call: the start routine of a struct load_thread.
+  */
+static void *call_load(void *arg);
+
+/** Makes the checks of a load test against its objectives. */
+static void check_load(uc_suite, const struct uc_load_options *options,
+                       const struct load_stats *stats);
+
+/** Bucket of a latency histogram counting ns. */
+static size_t latency_bucket(const uint64_t ns);
+
+/** Highest value counted in bucket of a latency histogram. */
+static uint64_t latency_bucket_max(const size_t bucket);
+
+/** Adds the latencies of src to dst. */
+static void merge_latencies(struct latency_histogram *dst,
+                            const struct latency_histogram *src);
+
+/** Latency in nanoseconds at or below which permille thousandths of the
+  * calls counted in histogram took, at the top of its bucket but no higher
+  * than the highest latency. 0 if histogram is empty.
+  */
+static uint64_t latency_percentile(const struct latency_histogram *histogram,
+                                   const unsigned int permille);
+
+/* Called by code built with -fsanitize-coverage=trace-pc-guard (Clang) or
+ * -fsanitize-coverage=trace-pc (GCC).
+ */
+void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop);
+void __sanitizer_cov_trace_pc_guard(uint32_t *guard);
+void __sanitizer_cov_trace_pc(void);
+
+/** Compares the len bytes of data with the golden file at path as a check,
+  * or rewrites the golden file if UC_UPDATE_SNAPSHOTS is 1. Returns whether
+  * they matched (or it was rewritten).
+  */
+static bool check_snapshot(uc_suite, const char *data, const size_t len,
+                           const char *path);
+
+/** Maps the file at path read-only into file. Returns false on failure. */
+static bool map_file(const char *path, struct mapped_file *file);
+
+/** Unmaps a file mapped by map_file. */
+static void unmap_file(struct mapped_file *file);
+
+/** Offset of the first byte differing between a and b, or the length of the
+  * shorter if it is a prefix of the other. Compares by memcmp of
+  * SNAPSHOT_CHUNK bytes at a time.
+  */
+static size_t first_difference(const char *a, const size_t a_len,
+                               const char *b, const size_t b_len);
+
+/** Writes the line of data around offset to dst, quoted and escaped, or
+  * "end of file" if offset is len. dst needs 8 * SNAPSHOT_CONTEXT + 16
+  * bytes. Returns the length written.
+  */
+static int snapshot_context(char *dst, const char *data, const size_t len,
+                            const size_t offset);
+
+/** Replaces the file at path with len bytes of data. Returns false on
+  * failure.
+  */
+static bool write_snapshot(const char *data, const size_t len,
+                           const char *path);
+
+/** In a test process, writes the counters of test under suite's
+  * coverage_dir.
+  */
+static void dump_test_coverage(uc_suite, const struct test *test);
+
+/** Replaces the entries of the tests of the run ending in the coverage map
+  * with the functions they ran, and removes suite's coverage_dir.
+  */
+static void update_coverage_map(uc_suite);
+
+/** Reads the coverage map at path into map, which is empty if there is no
+  * map. Returns false if it cannot be read. map is to be freed either way.
+  */
+static bool read_coverage_map(const char *path, struct coverage_map *map);
+
+/** Frees what read_coverage_map read into map. */
+static void free_coverage_map(struct coverage_map *map);
+
+/** The lines of the entry (struct map_entry) of the functions run by the
+  * test whose counters are under dir, or NULL if there are none. notes
+  * caches read_gcno by path.
+  */
+static char *test_coverage(const char *dir, GHashTable *notes);
+
+/** Writes the functions run according to each .gcda file under path to out.
+  * The file a .gcda file was written for is its path after the first
+  * prefix_len bytes.
+  */
+static void collect_gcda(const char *path, const size_t prefix_len,
+                         GHashTable *notes, FILE *out);
+
+/** Table of the functions (struct covered_function) of the .gcno file at
+  * path by ident, NULL if it cannot be read.
+  */
+static GHashTable *read_gcno(const char *path);
+static void struct_covered_function_free(void *);
+
+/** Starts reading a gcov file, checking it has magic and was written by a
+  * supported GCC. Returns false otherwise.
+  */
+static bool read_gcov_header(struct gcov_reader *reader, const uint32_t magic);
+
+/** Reads a word or string of a gcov file. Strings point into the file.
+  * Return false at the end of the file.
+  */
+static bool read_gcov_word(struct gcov_reader *reader, uint32_t *word);
+static bool read_gcov_string(struct gcov_reader *reader, const char **str);
+
+/** Reads the list of struct change at path, one file per line optionally
+  * followed by ":<line>" or ":<first line>-<last line>". Returns false if it
+  * cannot be read.
+  */
+static bool read_changes(const char *path, GList **changes);
+static void struct_change_free(void *);
+
+/** Whether any line of an entry's functions covers one of changes. */
+static bool covers_change(const char *functions, GList *changes);
+
+/** Whether file is changed, or ends with it after a '/'. */
+static bool path_matches(const char *file, const char *changed);
+
+/** Removes the file or directory tree at path. */
+static void remove_tree(const char *path);
+
+/** Whether test passed: all its checks were successful and it ran. */
+static bool test_passed(const struct test *test);
+
+/** The name of test, or "Test #<n>" written to buf (32 bytes) if it has
+  * none.
+  */
+static const char *test_key(const struct test *test, char *buf);
+
+/** Reads the outcome of each test of the previous run of uc_watch from fd,
+  * one "P <test key>" or "F <test key>" line per test. Returns a table from
+  * test key to 'P' or 'F', empty if there was no previous run.
+  */
+static GHashTable *read_watch_state(const int fd);
+
+/** Replaces the contents of fd with the outcome of each of suite's tests. */
+static void write_watch_state(uc_suite, const int fd);
+
+/** A copy of tests (as suite->tests) with the tests which failed according
+  * to state moved to the front of the run, each part keeping its order.
+  */
+static GList *failing_first(GList *tests, GHashTable *state);
+
+/** Outputs how many of suite's tests passed and which tests passed or failed
+  * unlike in state.
+  */
+static void output_watch_diff(uc_suite, GHashTable *state);
+
+/** Watches path (see struct watched_path) on inotify_fd. Returns false on
+  * failure.
+  */
+static bool add_watch(const int inotify_fd, const char *path,
+                      struct watched_path *watched);
+
+/** Blocks until one of the num_watched paths in watched changes and no
+  * changes follow for WATCH_SETTLE_MS. Returns false on failure.
+  */
+static bool wait_for_change(const int inotify_fd,
+                            const struct watched_path *watched,
+                            const size_t num_watched);
+
+/** The arguments the process was started with, NULL terminated, from
+  * /proc/self/cmdline, or NULL on failure. Freed by freeing the first
+  * argument and then the array.
+  */
+static char **read_cmdline(void);
+
+static void struct_check_free(void *);
+static void struct_crash_free(struct crash *);
+static void struct_test_free(void *);
+
+uc_suite uc_init(const uint_least32_t options, const char *name,
                  const char *comment) {
         uc_suite suite = malloc(sizeof(struct uc_suite));
         if (suite == NULL) return NULL;
 
-        suite->options = options;
-        suite->tests = NULL;
-        suite->num_succ = 0;
-        suite->num_checks = 0;
-        suite->num_tests = 0;
+        suite->options = options;
+        suite->tests = NULL;
+        suite->num_succ = 0;
+        suite->num_checks = 0;
+        suite->num_tests = 0;
+        suite->setup = NULL;
+        suite->teardown = NULL;
+        suite->test_setup = NULL;
+        suite->test_teardown = NULL;
+        suite->test_blocks = NULL;
+        suite->comments = NULL;
+        suite->groups = NULL;
+        suite->curr_group = NULL;
+        suite->resources = NULL;
+        suite->zygote = -1;
+        suite->zygote_fd = -1;
+        suite->zygote_exits = NULL;
+        suite->batch_size = 1;
+        suite->jobs = 0;
+        suite->output_limit = DEFAULT_OUTPUT_LIMIT;
+        suite->cpus = NULL;
+        suite->num_cpus = 0;
+        suite->rt_priority = 0;
+        suite->nice = 0;
+        suite->has_nice = false;
+        suite->repeat_times = 1;
+        suite->repeat_seconds = 0;
+        suite->property_cases = DEFAULT_PROPERTY_CASES;
+        suite->property_seed = default_property_seed();
+        suite->fuzz_runs = DEFAULT_FUZZ_RUNS;
+        suite->fuzz_seconds = 0;
+        suite->fuzz_timeout = DEFAULT_FUZZ_TIMEOUT;
+        suite->fuzz_output = NULL;
+        suite->coverage_map = NULL;
+        suite->coverage_dump = NULL;
+        suite->coverage_reset = NULL;
+        suite->coverage_dir = NULL;
+        suite->trace_path = NULL;
+        suite->profile_dir = NULL;
+        suite->profile_min_seconds = 0;
+
+        ALLOC_STRING(name, suite->name, { uc_free(suite); return NULL; });
+        ALLOC_STRING(comment, suite->comment, { uc_free(suite); return NULL; });
+
+        /* Add a test for all checks made outside a test. */
+        uc_add_test(suite, NULL, NULL, NULL);
+        suite->curr_test = g_list_last(suite->tests);
+
+        return suite;
+}
+
+void uc_free(uc_suite suite) {
+        if (suite == NULL) return;
+        if (suite->name != NULL) free(suite->name);
+        if (suite->comment != NULL) free(suite->comment);
+
+        /* Entries of described tests are part of their blocks. */
+        for (GList *curr = suite->tests, *next; curr != NULL; curr = next) {
+                struct test *test = curr->data;
+
+                next = curr->next;
+                if (!test->described) continue;
+
+                suite->tests = g_list_remove_link(suite->tests, curr);
+                struct_test_free(test);
+        }
+
+        g_list_free_full(suite->tests, &struct_test_free);
+        g_list_free_full(suite->test_blocks, &free);
+        g_list_free_full(suite->groups, &free);
+        g_list_free_full(suite->resources, &struct_resource_free);
+        /* After the checks and crashes using them. */
+        if (suite->comments != NULL) g_hash_table_destroy(suite->comments);
+        if (suite->cpus != NULL) free(suite->cpus);
+        if (suite->coverage_map != NULL) free(suite->coverage_map);
+        if (suite->coverage_dir != NULL) free(suite->coverage_dir);
+        if (suite->trace_path != NULL) free(suite->trace_path);
+        if (suite->profile_dir != NULL) free(suite->profile_dir);
+        if (suite->fuzz_output != NULL) free(suite->fuzz_output);
+
+        free(suite);
+}
+
+void uc_check(uc_suite suite, const bool cond, const char *comment) {
+        if (suite == NULL) return;
+        add_check(suite, cond, comment, false);
+}
+
+void uc_check_borrowed(uc_suite suite, const bool cond, const char *comment) {
+        if (suite == NULL) return;
+        add_check(suite, cond, comment, true);
+}
+
+void add_check(uc_suite suite, const bool cond, const char *comment,
+               const bool borrow) {
+        struct check *check;
+        struct test *curr_test;
+        struct check_buffer *buffer = NULL;
+        /* Whether the check is made by a test of the thread pool. */
+        bool in_pool = suite == thread_suite;
+        /* Memory held by checks is unitc's, not the test's. */
+        bool was_paused = heap_paused;
+
+        curr_test = in_pool ? thread_test->data : suite->curr_test->data;
+
+        heap_paused = true;
+        check = malloc(sizeof(struct check));
+        if (check == NULL) {
+                fprintf(stderr, "uc_check: failure to check: %s\n",
+                        comment == NULL ? "no comment provided." : comment);
+                heap_paused = was_paused;
+                return;
+        }
+
+        check->borrowed = borrow;
+        if (borrow) {
+                check->comment = (char *)comment;
+        } else {
+                ALLOC_STRING(comment, check->comment,
+                             { fprintf(stderr,
+                                       "uc_check: failure to save comment: "
+                                       "%s\n", comment); });
+        }
+
+        check->result = cond;
+
+        /* Only threads other than the test's own need a buffer. */
+        if (!pthread_equal(curr_test->owner, pthread_self())) {
+                buffer = lock_check_buffer(curr_test);
+                if (buffer == NULL) {
+                        fprintf(stderr, "uc_check: failure to check: %s\n",
+                                comment == NULL ? "no comment provided." :
+                                                  comment);
+                        struct_check_free(check);
+                        heap_paused = was_paused;
+                        return;
+                }
+        }
+
+        /* The pool adds the test's checks to the suite once it finishes. */
+        if (!in_pool) {
+                ATOMIC_ADD(suite->num_checks, 1);
+                if (cond) ATOMIC_ADD(suite->num_succ, 1);
+        }
+
+        check->check_num = ATOMIC_ADD(curr_test->num_checks, 1) + 1;
+        if (cond) ATOMIC_ADD(curr_test->num_succ, 1);
+
+        if (buffer != NULL) {
+                buffer->checks = g_list_prepend(buffer->checks, check);
+                pthread_mutex_unlock(&curr_test->buffers_lock);
+        } else {
+                curr_test->checks = g_list_prepend(curr_test->checks, check);
+        }
+
+        heap_paused = was_paused;
+}
+
+uint64_t default_property_seed(void) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        return ((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec) ^
+               ((uint64_t)getpid() << 32);
+}
+
+uint64_t splitmix(uint64_t *state) {
+        uint64_t z = (*state += 0x9e3779b97f4a7c15);
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(const uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+}
+
+/* xoshiro256**. */
+static inline uint64_t next_random(uint64_t s[4]) {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+}
+
+void *prop_realloc(void *ptr, const size_t size) {
+        bool was_paused = heap_paused;
+        void *new_ptr;
+
+        heap_paused = true;
+        new_ptr = realloc(ptr, size);
+        heap_paused = was_paused;
+
+        return new_ptr;
+}
+
+uint64_t draw(struct uc_prop *prop, const uint64_t bound) {
+        uint64_t choice, random;
+
+        if (prop->replay) {
+                if (prop->next >= prop->num_choices) {
+                        ++prop->next;
+                        return 0;
+                }
+
+                /* Clamped in place, so the sequence replays the same. */
+                choice = prop->choices[prop->next];
+                if (choice > bound) prop->choices[prop->next] = choice = bound;
+                ++prop->next;
+                return choice;
+        }
+
+        random = next_random(prop->rng);
+        if (random % SMALL_CHOICE_ODDS == 0) {
+                choice = (random >> 32) %
+                         ((bound < SMALL_CHOICE ? bound : SMALL_CHOICE) + 1);
+        } else if (bound == UINT64_MAX) {
+                choice = next_random(prop->rng);
+        } else {
+                choice = next_random(prop->rng) % (bound + 1);
+        }
+
+        if (prop->num_choices == prop->cap_choices) {
+                size_t cap = prop->cap_choices == 0 ? 64 :
+                                                      2 * prop->cap_choices;
+                uint64_t *choices = prop_realloc(prop->choices,
+                                                 cap * sizeof(uint64_t));
+
+                if (choices == NULL) {
+                        prop->failed = true;
+                        ++prop->next;
+                        return choice;
+                }
+
+                prop->choices = choices;
+                prop->cap_choices = cap;
+        }
+
+        prop->choices[prop->num_choices++] = choice;
+        ++prop->next;
+
+        return choice;
+}
+
+void describe(struct uc_prop *prop, const char *format, ...) {
+        va_list args;
+        int len;
+
+        va_start(args, format);
+        len = vsnprintf(NULL, 0, format, args);
+        va_end(args);
+        if (len < 0) return;
+
+        if (prop->desc_len + len + 1 > prop->desc_cap) {
+                size_t cap = 2 * (prop->desc_len + len + 1);
+                char *desc = prop_realloc(prop->desc, cap);
+
+                if (desc == NULL) return;
+                prop->desc = desc;
+                prop->desc_cap = cap;
+        }
+
+        va_start(args, format);
+        vsnprintf(prop->desc + prop->desc_len, len + 1, format, args);
+        va_end(args);
+        prop->desc_len += len;
+}
+
+void describe_next(struct uc_prop *prop) {
+        if (prop->desc_len > 0) describe(prop, ", ");
+}
+
+char *prop_buffer(struct uc_prop *prop, const size_t size) {
+        if (prop->next_buf == prop->num_bufs) {
+                char **bufs = prop_realloc(prop->bufs, (prop->num_bufs + 1) *
+                                                       sizeof(char *));
+                size_t *buf_sizes;
+
+                if (bufs == NULL) return NULL;
+                prop->bufs = bufs;
+
+                buf_sizes = prop_realloc(prop->buf_sizes,
+                                         (prop->num_bufs + 1) *
+                                         sizeof(size_t));
+                if (buf_sizes == NULL) return NULL;
+                prop->buf_sizes = buf_sizes;
+
+                prop->bufs[prop->num_bufs] = NULL;
+                prop->buf_sizes[prop->num_bufs] = 0;
+                ++prop->num_bufs;
+        }
+
+        if (prop->buf_sizes[prop->next_buf] < size) {
+                char *buf = prop_realloc(prop->bufs[prop->next_buf], size);
+
+                if (buf == NULL) return NULL;
+                prop->bufs[prop->next_buf] = buf;
+                prop->buf_sizes[prop->next_buf] = size;
+        }
+
+        return prop->bufs[prop->next_buf++];
+}
+
+int64_t uc_gen_int(uc_prop prop, const int64_t min, const int64_t max) {
+        int64_t lo = min <= max ? min : max, hi = min <= max ? max : min;
+        uint64_t choice, pos, neg, both;
+        int64_t value;
+
+        if (prop == NULL) return lo;
+
+        choice = draw(prop, (uint64_t)hi - (uint64_t)lo);
+        if (lo >= 0) {
+                value = (int64_t)((uint64_t)lo + choice);
+        } else if (hi <= 0) {
+                value = (int64_t)((uint64_t)hi - choice);
+        } else {
+                /* Alternate around 0 while both sides have values left,
+                 * then take the rest of the longer side.
+                 */
+                pos = hi;
+                neg = -(uint64_t)lo;
+                both = pos < neg ? pos : neg;
+                if (choice <= 2 * both) {
+                        value = choice % 2 == 0 ?
+                                (int64_t)(choice / 2) :
+                                (int64_t)(-(choice / 2) - 1);
+                } else if (pos > neg) {
+                        value = (int64_t)(choice - both);
+                } else {
+                        value = (int64_t)-(choice - both);
+                }
+        }
+
+        if (prop->describe) {
+                describe_next(prop);
+                describe(prop, "%" PRId64, value);
+        }
+
+        return value;
+}
+
+double uc_gen_double(uc_prop prop, const double min, const double max) {
+        double lo = min <= max ? min : max, hi = min <= max ? max : min;
+        /* Fraction of the way from the value closest to 0 to the bound. */
+        double fraction;
+        double value;
+
+        if (prop == NULL) return lo;
+
+        if (lo <= 0 && hi >= 0) {
+                bool negative = draw(prop, 1) == 1;
+
+                fraction = draw(prop, (1ULL << 53) - 1) / (double)(1ULL << 53);
+                value = negative ? lo * fraction : hi * fraction;
+        } else {
+                fraction = draw(prop, 1ULL << 53) / (double)(1ULL << 53);
+                value = lo > 0 ? lo + fraction * (hi - lo) :
+                                 hi - fraction * (hi - lo);
+        }
+
+        if (prop->describe) {
+                describe_next(prop);
+                describe(prop, "%g", value);
+        }
+
+        return value;
+}
+
+const uint8_t *uc_gen_bytes(uc_prop prop, const size_t max_len, size_t *len) {
+        uint8_t *bytes;
+        size_t num;
+
+        if (len != NULL) *len = 0;
+        if (prop == NULL) return NULL;
+
+        num = draw(prop, max_len);
+        bytes = (uint8_t *)prop_buffer(prop, num + 1);
+        if (bytes == NULL) return NULL;
+
+        for (size_t i = 0; i < num; ++i) bytes[i] = draw(prop, UINT8_MAX);
+        if (len != NULL) *len = num;
+
+        if (prop->describe) {
+                describe_next(prop);
+                describe(prop, "[");
+                for (size_t i = 0; i < num; ++i) {
+                        describe(prop, i == 0 ? "%02x" : " %02x", bytes[i]);
+                }
+                describe(prop, "]");
+        }
+
+        return bytes;
+}
+
+const char *uc_gen_string(uc_prop prop, const size_t max_len) {
+        char *string;
+        size_t num;
+
+        if (prop == NULL) return NULL;
+
+        num = draw(prop, max_len);
+        string = prop_buffer(prop, num + 1);
+        if (string == NULL) return NULL;
+
+        /* The 95 printable characters, starting from 'a' for choice 0. */
+        for (size_t i = 0; i < num; ++i) {
+                string[i] = ' ' + ('a' - ' ' + draw(prop, 94)) % 95;
+        }
+        string[num] = '\0';
+
+        if (prop->describe) {
+                describe_next(prop);
+                describe(prop, "\"");
+                for (size_t i = 0; i < num; ++i) {
+                        bool escape = string[i] == '"' || string[i] == '\\';
+
+                        describe(prop, escape ? "\\%c" : "%c", string[i]);
+                }
+                describe(prop, "\"");
+        }
+
+        return string;
+}
+
+bool run_case(struct uc_prop *prop, bool (*property)(uc_prop, void *),
+              void *data, const uint64_t *choices, const size_t num_choices) {
+        bool holds;
+
+        prop->replay = choices != NULL;
+        prop->next = 0;
+        prop->next_buf = 0;
+        if (prop->replay) {
+                memcpy(prop->choices, choices, num_choices * sizeof(uint64_t));
+                prop->num_choices = num_choices;
+        } else {
+                prop->num_choices = 0;
+        }
+
+        heap_paused = prop->was_paused;
+        holds = property(prop, data);
+        heap_paused = true;
+
+        /* Choices never drawn did not matter. */
+        if (prop->next < prop->num_choices) prop->num_choices = prop->next;
+
+        return holds;
+}
+
+bool choices_less(const uint64_t *a, const uint64_t *b, const size_t num) {
+        for (size_t i = 0; i < num; ++i) {
+                if (a[i] != b[i]) return a[i] < b[i];
+        }
+
+        return false;
+}
+
+bool try_shrink(struct uc_prop *prop, bool (*property)(uc_prop, void *),
+                void *data, const uint64_t *candidate,
+                const size_t num_candidate, uint64_t *best, size_t *num_best,
+                unsigned int *calls) {
+        if (*calls >= SHRINK_LIMIT) return false;
+        ++*calls;
+
+        if (run_case(prop, property, data, candidate, num_candidate)) {
+                return false;
+        }
+
+        /* Simpler is shorter, or as long and lower at the first difference. */
+        if (prop->num_choices > *num_best ||
+            (prop->num_choices == *num_best &&
+             !choices_less(prop->choices, best, *num_best))) {
+                return false;
+        }
+
+        memcpy(best, prop->choices, prop->num_choices * sizeof(uint64_t));
+        *num_best = prop->num_choices;
+
+        return true;
+}
+
+unsigned int shrink(struct uc_prop *prop, bool (*property)(uc_prop, void *),
+                    void *data, uint64_t *best, size_t *num_best,
+                    uint64_t *candidate) {
+        unsigned int shrinks = 0, calls = 0;
+        bool shrunk;
+
+        do {
+                shrunk = false;
+
+                for (size_t run = 8; run > 0; run /= 2) {
+                        for (size_t i = 0; i + run <= *num_best;) {
+                                size_t num = *num_best - run;
+
+                                memcpy(candidate, best, i * sizeof(uint64_t));
+                                memcpy(candidate + i, best + i + run,
+                                       (num - i) * sizeof(uint64_t));
+                                if (try_shrink(prop, property, data, candidate,
+                                               num, best, num_best, &calls)) {
+                                        ++shrinks;
+                                        shrunk = true;
+                                        continue;
+                                }
+
+                                if (i > 0 && candidate[i - 1] > 0) {
+                                        --candidate[i - 1];
+                                        if (try_shrink(prop, property, data,
+                                                       candidate, num, best,
+                                                       num_best, &calls)) {
+                                                ++shrinks;
+                                                shrunk = true;
+                                                continue;
+                                        }
+                                }
+
+                                ++i;
+                        }
+                }
+
+                for (size_t i = 0; i < *num_best; ++i) {
+                        uint64_t low = 0;
+
+                        /* Lowest failing value, by bisection from 0. */
+                        while (i < *num_best && best[i] > low) {
+                                uint64_t mid = low + (best[i] - low) / 2;
+
+                                memcpy(candidate, best,
+                                       *num_best * sizeof(uint64_t));
+                                candidate[i] = mid;
+                                if (try_shrink(prop, property, data, candidate,
+                                               *num_best, best, num_best,
+                                               &calls)) {
+                                        ++shrinks;
+                                        shrunk = true;
+                                } else if (mid == low) {
+                                        break;
+                                } else {
+                                        low = mid;
+                                }
+                        }
+                }
+        } while (shrunk && calls < SHRINK_LIMIT);
+
+        return shrinks;
+}
+
+bool uc_check_snapshot(uc_suite suite, const void *buf, const size_t len,
+                       const char *path) {
+        if (suite == NULL || path == NULL || (buf == NULL && len > 0)) {
+                return false;
+        }
+
+        return check_snapshot(suite, buf, len, path);
+}
+
+bool uc_check_snapshot_file(uc_suite suite, const char *path,
+                            const char *golden_path) {
+        struct mapped_file actual;
+        bool matches;
+
+        if (suite == NULL || path == NULL || golden_path == NULL) {
+                return false;
+        }
+
+        if (!map_file(path, &actual)) {
+                char comment[PATH_MAX + 64];
+
+                snprintf(comment, sizeof(comment), "Snapshot output %s "
+                         "cannot be read.", path);
+                uc_check(suite, false, comment);
+                return false;
+        }
+
+        matches = check_snapshot(suite, actual.data, actual.len, golden_path);
+        unmap_file(&actual);
+
+        return matches;
+}
+
+bool check_snapshot(uc_suite suite, const char *data, const size_t len,
+                    const char *path) {
+        const char *update = getenv("UC_UPDATE_SNAPSHOTS");
+        char comment[PATH_MAX + 2 * (8 * SNAPSHOT_CONTEXT + 16) + 128];
+        struct mapped_file golden;
+        size_t offset, line;
+        int used;
+
+        if (update != NULL && strcmp(update, "1") == 0) {
+                bool written = write_snapshot(data, len, path);
+
+                snprintf(comment, sizeof(comment), written ?
+                         "Snapshot %s updated." :
+                         "Snapshot %s cannot be written.", path);
+                uc_check(suite, written, comment);
+                return written;
+        }
+
+        if (!map_file(path, &golden)) {
+                snprintf(comment, sizeof(comment),
+                         "Snapshot %s cannot be read (UC_UPDATE_SNAPSHOTS=1 "
+                         "writes it).", path);
+                uc_check(suite, false, comment);
+                return false;
+        }
+
+        offset = first_difference(golden.data, golden.len, data, len);
+        if (offset == golden.len && offset == len) {
+                snprintf(comment, sizeof(comment), "Snapshot %s matches.",
+                         path);
+                uc_check(suite, true, comment);
+                unmap_file(&golden);
+                return true;
+        }
+
+        /* Lines are counted from 1, by the newlines before the difference. */
+        line = 1;
+        for (const char *curr = golden.data, *end = golden.data + offset;
+             (curr = memchr(curr, '\n', end - curr)) != NULL; ++curr) {
+                ++line;
+        }
+
+        used = snprintf(comment, sizeof(comment), "Snapshot %s differs at "
+                        "byte %zu (line %zu): expected ", path, offset, line);
+        used += snapshot_context(comment + used, golden.data, golden.len,
+                                 offset);
+        used += snprintf(comment + used, sizeof(comment) - used, ", got ");
+        used += snapshot_context(comment + used, data, len, offset);
+        snprintf(comment + used, sizeof(comment) - used, ".");
+
+        uc_check(suite, false, comment);
+        unmap_file(&golden);
+
+        return false;
+}
+
+bool map_file(const char *path, struct mapped_file *file) {
+        struct stat stat_buf;
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1) return false;
+        if (fstat(fd, &stat_buf) == -1) {
+                close(fd);
+                return false;
+        }
+
+        file->len = stat_buf.st_size;
+        file->data = NULL;
+        /* Empty files cannot be mapped. */
+        if (file->len > 0) {
+                void *data = mmap(NULL, file->len, PROT_READ, MAP_PRIVATE,
+                                  fd, 0);
+
+                if (data == MAP_FAILED) {
+                        close(fd);
+                        return false;
+                }
+
+                madvise(data, file->len, MADV_SEQUENTIAL);
+                file->data = data;
+        }
+        close(fd);
+
+        return true;
+}
+
+void unmap_file(struct mapped_file *file) {
+        if (file->data != NULL) munmap((void *)file->data, file->len);
+}
+
+size_t first_difference(const char *a, const size_t a_len, const char *b,
+                        const size_t b_len) {
+        size_t len = a_len < b_len ? a_len : b_len;
+
+        for (size_t offset = 0; offset < len; offset += SNAPSHOT_CHUNK) {
+                size_t chunk = len - offset < SNAPSHOT_CHUNK ?
+                               len - offset : SNAPSHOT_CHUNK;
+
+                if (memcmp(a + offset, b + offset, chunk) == 0) continue;
+
+                while (a[offset] == b[offset]) ++offset;
+                return offset;
+        }
+
+        return len;
+}
+
+int snapshot_context(char *dst, const char *data, const size_t len,
+                     const size_t offset) {
+        const char *line_start, *line_end;
+        const char *from, *to;
+        char *curr = dst;
+
+        if (offset >= len) return sprintf(dst, "end of file");
+
+        /* Up to SNAPSHOT_CONTEXT bytes either side, within the line. */
+        line_start = offset == 0 ? NULL : memrchr(data, '\n', offset);
+        line_start = line_start == NULL ? data : line_start + 1;
+        line_end = memchr(data + offset, '\n', len - offset);
+        if (line_end == NULL) line_end = data + len;
+
+        from = data + offset - line_start > SNAPSHOT_CONTEXT ?
+               data + offset - SNAPSHOT_CONTEXT : line_start;
+        to = line_end - (data + offset) > SNAPSHOT_CONTEXT ?
+             data + offset + SNAPSHOT_CONTEXT : line_end;
+
+        *curr++ = '"';
+        if (from != line_start) curr += sprintf(curr, "...");
+        for (const char *c = from; c < to; ++c) {
+                if (*c == '"' || *c == '\\') {
+                        curr += sprintf(curr, "\\%c", *c);
+                } else if (*c == '\t') {
+                        curr += sprintf(curr, "\\t");
+                } else if (*c == '\r') {
+                        curr += sprintf(curr, "\\r");
+                } else if (*c >= ' ' && *c <= '~') {
+                        *curr++ = *c;
+                } else {
+                        curr += sprintf(curr, "\\x%02x", (unsigned char)*c);
+                }
+        }
+        if (to != line_end) curr += sprintf(curr, "...");
+        if (to == line_end && line_end != data + len) {
+                curr += sprintf(curr, "\\n");
+        }
+        *curr++ = '"';
+        *curr = '\0';
+
+        return curr - dst;
+}
+
+bool write_snapshot(const char *data, const size_t len, const char *path) {
+        char tmp_path[PATH_MAX];
+        int fd;
+
+        /* Written aside and renamed, so the golden file is never partial. */
+        if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path) >=
+            (int)sizeof(tmp_path)) {
+                return false;
+        }
+        fd = mkstemp(tmp_path);
+        if (fd == -1) return false;
+
+        if (!write_full(fd, data, len) || fsync(fd) == -1) {
+                close(fd);
+                unlink(tmp_path);
+                return false;
+        }
+        close(fd);
+        /* mkstemp's files are private to the user. */
+        chmod(tmp_path, 0644);
+
+        if (rename(tmp_path, path) == -1) {
+                unlink(tmp_path);
+                return false;
+        }
+
+        return true;
+}
+
+void dump_test_coverage(uc_suite suite, const struct test *test) {
+        char prefix[PATH_MAX];
+
+        /* gcov writes the counters of each object file under GCOV_PREFIX,
+         * at the path of the object's own .gcda file.
+         */
+        snprintf(prefix, sizeof(prefix), "%s/%u", suite->coverage_dir,
+                 test->test_num);
+        setenv("GCOV_PREFIX", prefix, 1);
+        setenv("GCOV_PREFIX_STRIP", "0", 1);
+        suite->coverage_dump();
+}
+
+void update_coverage_map(uc_suite suite) {
+        GHashTable *notes = g_hash_table_new_full(
+                g_str_hash, g_str_equal, free,
+                (GDestroyNotify)g_hash_table_destroy);
+        struct coverage_map map;
+        FILE *out;
+        char *text = NULL;
+        size_t len = 0;
+
+        /* An unreadable map is replaced. */
+        read_coverage_map(suite->coverage_map, &map);
+
+        /* Only the tests of the run, the others keep their entries. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                struct test *test = curr->data;
+                char dir[PATH_MAX], buf[32];
+                const char *key = test_key(test, buf);
+                GList *found = g_hash_table_lookup(map.index, key);
+                struct map_entry *entry;
+                char *functions;
+
+                snprintf(dir, sizeof(dir), "%s/%u", suite->coverage_dir,
+                         test->test_num);
+                functions = test_coverage(dir, notes);
+
+                if (found != NULL) {
+                        entry = found->data;
+                        free(entry->functions);
+                        entry->functions = functions;
+                        continue;
+                }
+
+                if (functions == NULL) continue;
+
+                entry = malloc(sizeof(struct map_entry));
+                if (entry == NULL || (entry->key = strdup(key)) == NULL) {
+                        free(entry);
+                        free(functions);
+                        continue;
+                }
+                entry->functions = functions;
+                map.entries = g_list_prepend(map.entries, entry);
+                g_hash_table_insert(map.index, entry->key, map.entries);
+        }
+        g_hash_table_destroy(notes);
+
+        /* Tests without functions, e.g. which crashed, are left out. */
+        out = open_memstream(&text, &len);
+        if (out != NULL) {
+                for (GList *curr = g_list_last(map.entries); curr != NULL;
+                     curr = curr->prev) {
+                        struct map_entry *entry = curr->data;
+
+                        if (entry->functions == NULL) continue;
+                        fprintf(out, "T %s\n%s", entry->key,
+                                entry->functions);
+                }
+                fclose(out);
+        }
+        if (text == NULL || !write_snapshot(text, len, suite->coverage_map)) {
+                fputs("uc_run_tests: cannot write coverage map.\n", stderr);
+        }
+        free(text);
+        free_coverage_map(&map);
+
+        remove_tree(suite->coverage_dir);
+        free(suite->coverage_dir);
+        suite->coverage_dir = NULL;
+}
+
+bool read_coverage_map(const char *path, struct coverage_map *map) {
+        struct mapped_file file;
+        struct map_entry *entry = NULL;
+        const char *line, *end;
+
+        map->entries = NULL;
+        map->index = g_hash_table_new(g_str_hash, g_str_equal);
+
+        /* No map yet is an empty one. */
+        if (!map_file(path, &file)) return errno == ENOENT;
+
+        for (line = file.data; line != NULL && line < file.data + file.len;
+             line = end + 1) {
+                size_t line_len;
+
+                end = memchr(line, '\n', file.data + file.len - line);
+                if (end == NULL) break;
+                line_len = end - line;
+
+                if (line_len > 2 && line[0] == 'T' && line[1] == ' ') {
+                        entry = malloc(sizeof(struct map_entry));
+                        if (entry == NULL) break;
+
+                        entry->key = strndup(line + 2, line_len - 2);
+                        entry->functions = strdup("");
+                        map->entries = g_list_prepend(map->entries, entry);
+                        g_hash_table_insert(map->index, entry->key,
+                                            map->entries);
+                } else if (entry != NULL && line_len > 2 && line[0] == 'F' &&
+                           line[1] == ' ') {
+                        size_t had = strlen(entry->functions);
+                        char *grown = realloc(entry->functions,
+                                              had + line_len + 2);
+
+                        if (grown == NULL) break;
+                        memcpy(grown + had, line, line_len + 1);
+                        grown[had + line_len + 1] = '\0';
+                        entry->functions = grown;
+                }
+        }
+
+        unmap_file(&file);
+        return true;
+}
+
+void free_coverage_map(struct coverage_map *map) {
+        for (GList *curr = map->entries; curr != NULL; curr = curr->next) {
+                struct map_entry *entry = curr->data;
+
+                free(entry->key);
+                free(entry->functions);
+                free(entry);
+        }
+        g_list_free(map->entries);
+        g_hash_table_destroy(map->index);
+}
+
+char *test_coverage(const char *dir, GHashTable *notes) {
+        char *text = NULL;
+        size_t len = 0;
+        FILE *out = open_memstream(&text, &len);
+
+        if (out == NULL) return NULL;
+
+        collect_gcda(dir, strlen(dir), notes, out);
+        fclose(out);
+
+        if (len == 0) {
+                free(text);
+                return NULL;
+        }
+
+        return text;
+}
+
+void collect_gcda(const char *path, const size_t prefix_len,
+                  GHashTable *notes, FILE *out) {
+        struct gcov_reader reader;
+        struct mapped_file file;
+        GHashTable *functions;
+        char note_path[PATH_MAX];
+        size_t path_len = strlen(path);
+        uint32_t tag, length, ident = 0;
+        bool in_function = false, ran = false;
+        DIR *dir = opendir(path);
+
+        if (dir != NULL) {
+                struct dirent *entry;
+
+                while ((entry = readdir(dir)) != NULL) {
+                        char child[PATH_MAX];
+
+                        if (strcmp(entry->d_name, ".") == 0 ||
+                            strcmp(entry->d_name, "..") == 0) {
+                                continue;
+                        }
+                        if (snprintf(child, sizeof(child), "%s/%s", path,
+                                     entry->d_name) >= (int)sizeof(child)) {
+                                continue;
+                        }
+                        collect_gcda(child, prefix_len, notes, out);
+                }
+                closedir(dir);
+                return;
+        }
+
+        if (path_len < prefix_len + strlen(".gcda") ||
+            strcmp(path + path_len - strlen(".gcda"), ".gcda") != 0) {
+                return;
+        }
+
+        /* The .gcno file is next to the .gcda file gcov would have
+         * written.
+         */
+        snprintf(note_path, sizeof(note_path), "%.*s.gcno",
+                 (int)(path_len - prefix_len - strlen(".gcda")),
+                 path + prefix_len);
+        functions = g_hash_table_lookup(notes, note_path);
+        if (functions == NULL) {
+                functions = read_gcno(note_path);
+                if (functions == NULL) return;
+                g_hash_table_insert(notes, strdup(note_path), functions);
+        }
+
+        if (!map_file(path, &file)) return;
+        reader.data = file.data;
+        reader.len = file.len;
+        reader.pos = 0;
+
+        if (!read_gcov_header(&reader, GCOV_DATA_MAGIC)) {
+                unmap_file(&file);
+                return;
+        }
+
+        /* A function's record is followed by its counters. Negative lengths
+         * are of counters which are all 0, with none written.
+         */
+        for (;;) {
+                bool more = read_gcov_word(&reader, &tag) &&
+                            read_gcov_word(&reader, &length);
+
+                if (!more || tag == GCOV_TAG_FUNCTION) {
+                        struct covered_function *function =
+                                g_hash_table_lookup(functions,
+                                                    GUINT_TO_POINTER(ident));
+
+                        if (in_function && ran && function != NULL) {
+                                fprintf(out, "F %" PRIu32 " %" PRIu32
+                                        " %s %s\n", function->start_line,
+                                        function->end_line, function->name,
+                                        function->file);
+                        }
+                        if (!more) break;
+
+                        in_function = length >= sizeof(uint32_t) &&
+                                      read_gcov_word(&reader, &ident);
+                        ran = false;
+                        if (in_function) length -= sizeof(uint32_t);
+                } else if (tag == GCOV_TAG_ARCS && (int32_t)length > 0) {
+                        for (uint32_t i = 0; i + sizeof(uint64_t) <= length &&
+                             reader.pos + i + sizeof(uint64_t) <= reader.len;
+                             i += sizeof(uint64_t)) {
+                                uint64_t count;
+
+                                memcpy(&count, reader.data + reader.pos + i,
+                                       sizeof(count));
+                                if (count != 0) ran = true;
+                        }
+                }
+
+                if ((int32_t)length > 0) reader.pos += length;
+        }
+
+        unmap_file(&file);
+}
+
+GHashTable *read_gcno(const char *path) {
+        GHashTable *functions;
+        struct gcov_reader reader;
+        struct mapped_file file;
+        const char *cwd;
+        uint32_t tag, length, unexecuted;
+
+        if (!map_file(path, &file)) return NULL;
+        reader.data = file.data;
+        reader.len = file.len;
+        reader.pos = 0;
+
+        if (!read_gcov_header(&reader, GCOV_NOTE_MAGIC) ||
+            !read_gcov_string(&reader, &cwd) ||
+            !read_gcov_word(&reader, &unexecuted)) {
+                unmap_file(&file);
+                return NULL;
+        }
+
+        functions = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                          &struct_covered_function_free);
+
+        while (read_gcov_word(&reader, &tag) &&
+               read_gcov_word(&reader, &length)) {
+                size_t end = reader.pos + length;
+                struct covered_function *function;
+                uint32_t ident, checksum, artificial, column;
+                const char *name, *file_name;
+
+                if (tag != GCOV_TAG_FUNCTION) {
+                        reader.pos = end;
+                        continue;
+                }
+
+                function = malloc(sizeof(struct covered_function));
+                if (function == NULL) break;
+
+                if (!read_gcov_word(&reader, &ident) ||
+                    !read_gcov_word(&reader, &checksum) ||
+                    !read_gcov_word(&reader, &checksum) ||
+                    !read_gcov_string(&reader, &name) ||
+                    !read_gcov_word(&reader, &artificial) ||
+                    !read_gcov_string(&reader, &file_name) ||
+                    !read_gcov_word(&reader, &function->start_line) ||
+                    !read_gcov_word(&reader, &column) ||
+                    !read_gcov_word(&reader, &function->end_line)) {
+                        free(function);
+                        break;
+                }
+
+                function->name = strdup(name);
+                if (file_name[0] == '/') {
+                        function->file = strdup(file_name);
+                } else if (asprintf(&function->file, "%s/%s", cwd,
+                                    file_name) == -1) {
+                        function->file = NULL;
+                }
+                if (function->name == NULL || function->file == NULL) {
+                        struct_covered_function_free(function);
+                        break;
+                }
+
+                g_hash_table_insert(functions, GUINT_TO_POINTER(ident),
+                                    function);
+                reader.pos = end;
+        }
+
+        unmap_file(&file);
+        return functions;
+}
+
+void struct_covered_function_free(void *data) {
+        struct covered_function *function = data;
+
+        free(function->name);
+        free(function->file);
+        free(function);
+}
+
+bool read_gcov_header(struct gcov_reader *reader, const uint32_t magic) {
+        uint32_t file_magic, version, stamp, checksum;
+        int major;
+
+        if (!read_gcov_word(reader, &file_magic) ||
+            !read_gcov_word(reader, &version) ||
+            !read_gcov_word(reader, &stamp) ||
+            !read_gcov_word(reader, &checksum)) {
+                return false;
+        }
+
+        /* Versions are "<major / 10 + 'A'><major % 10><minor><status>". From
+         * GCC 12, lengths are in bytes and headers have a checksum.
+         */
+        major = (int)((version >> 24) & 0xff) - 'A';
+        major = major * 10 + (int)((version >> 16) & 0xff) - '0';
+
+        return file_magic == magic && major >= 12;
+}
+
+bool read_gcov_word(struct gcov_reader *reader, uint32_t *word) {
+        if (reader->pos + sizeof(uint32_t) > reader->len) return false;
+
+        memcpy(word, reader->data + reader->pos, sizeof(uint32_t));
+        reader->pos += sizeof(uint32_t);
+        return true;
+}
+
+bool read_gcov_string(struct gcov_reader *reader, const char **str) {
+        uint32_t length;
+
+        if (!read_gcov_word(reader, &length)) return false;
+
+        if (length == 0) {
+                *str = "";
+                return true;
+        }
+
+        /* Lengths count the terminating null. */
+        if (reader->pos + length > reader->len ||
+            reader->data[reader->pos + length - 1] != '\0') {
+                return false;
+        }
+
+        *str = reader->data + reader->pos;
+        reader->pos += length;
+        return true;
+}
+
+bool read_changes(const char *path, GList **changes) {
+        char line[PATH_MAX + 64];
+        FILE *file;
+
+        if (path == NULL || (file = fopen(path, "r")) == NULL) return false;
+
+        *changes = NULL;
+        while (fgets(line, sizeof(line), file) != NULL) {
+                struct change *change;
+                char *colon;
+
+                line[strcspn(line, "\n")] = '\0';
+                if (line[0] == '\0') continue;
+
+                change = malloc(sizeof(struct change));
+                if (change == NULL) break;
+
+                change->first = 0;
+                change->last = ULONG_MAX;
+                colon = strrchr(line, ':');
+                if (colon != NULL) {
+                        char *end;
+
+                        change->first = strtoul(colon + 1, &end, 10);
+                        change->last = change->first;
+                        if (*end == '-') {
+                                change->last = strtoul(end + 1, NULL, 10);
+                        }
+                        *colon = '\0';
+                }
+
+                change->path = strdup(line);
+                if (change->path == NULL) {
+                        free(change);
+                        break;
+                }
+                *changes = g_list_prepend(*changes, change);
+        }
+
+        fclose(file);
+        return true;
+}
+
+void struct_change_free(void *data) {
+        struct change *change = data;
+
+        free(change->path);
+        free(change);
+}
+
+bool covers_change(const char *functions, GList *changes) {
+        const char *line, *newline;
+
+        for (line = functions; line != NULL && *line != '\0';
+             line = newline != NULL ? newline + 1 : NULL) {
+                unsigned long start, end;
+                const char *file;
+                size_t file_len;
+                int name_end;
+
+                newline = strchr(line, '\n');
+                if (sscanf(line, "F %lu %lu %*s %n", &start, &end,
+                           &name_end) < 2) {
+                        continue;
+                }
+                file = line + name_end;
+                file_len = newline != NULL ? (size_t)(newline - file) :
+                                             strlen(file);
+
+                for (GList *curr = changes; curr != NULL; curr = curr->next) {
+                        struct change *change = curr->data;
+                        char path[PATH_MAX];
+
+                        if (change->first > end || change->last < start) {
+                                continue;
+                        }
+                        if (file_len >= sizeof(path)) continue;
+                        memcpy(path, file, file_len);
+                        path[file_len] = '\0';
+
+                        if (path_matches(path, change->path)) return true;
+                }
+        }
+
+        return false;
+}
+
+bool path_matches(const char *file, const char *changed) {
+        size_t file_len = strlen(file), changed_len = strlen(changed);
+
+        if (changed_len == 0 || changed_len > file_len) return false;
+        if (strcmp(file + file_len - changed_len, changed) != 0) return false;
+
+        return changed_len == file_len ||
+               file[file_len - changed_len - 1] == '/';
+}
+
+void remove_tree(const char *path) {
+        DIR *dir = opendir(path);
+
+        if (dir != NULL) {
+                struct dirent *entry;
+
+                while ((entry = readdir(dir)) != NULL) {
+                        char child[PATH_MAX];
+
+                        if (strcmp(entry->d_name, ".") == 0 ||
+                            strcmp(entry->d_name, "..") == 0) {
+                                continue;
+                        }
+                        if (snprintf(child, sizeof(child), "%s/%s", path,
+                                     entry->d_name) < (int)sizeof(child)) {
+                                remove_tree(child);
+                        }
+                }
+                closedir(dir);
+        }
+
+        remove(path);
+}
+
+bool uc_check_property(uc_suite suite, bool (*property)(uc_prop prop,
+                                                        void *data),
+                       void *data, const char *comment) {
+        struct uc_prop prop;
+        uint64_t seed;
+        uint64_t *best = NULL, *candidate = NULL;
+        size_t num_best;
+        unsigned long cases, failed_case = 0;
+        unsigned int shrinks = 0;
+        bool holds = true;
+        char *failure = NULL;
+        int len;
+
+        if (suite == NULL || property == NULL) return false;
+
+        memset(&prop, 0, sizeof(prop));
+        prop.was_paused = heap_paused;
+        heap_paused = true;
+
+        seed = suite->property_seed;
+        for (int i = 0; i < 4; ++i) prop.rng[i] = splitmix(&seed);
+
+        cases = suite->property_cases;
+        for (unsigned long i = 0; i < cases && holds; ++i) {
+                holds = run_case(&prop, property, data, NULL, 0);
+                if (!holds) failed_case = i + 1;
+        }
+
+        if (!holds) {
+                num_best = prop.num_choices;
+                best = malloc(num_best * sizeof(uint64_t) + 1);
+                candidate = malloc(num_best * sizeof(uint64_t) + 1);
+        }
+
+        if (best != NULL && candidate != NULL && !prop.failed) {
+                memcpy(best, prop.choices, num_best * sizeof(uint64_t));
+                shrinks = shrink(&prop, property, data, best, &num_best,
+                                 candidate);
+
+                /* Once more, to describe the counterexample. */
+                prop.describe = true;
+                run_case(&prop, property, data, best, num_best);
+        } else if (!holds) {
+                fputs("uc_check_property: cannot shrink counterexample.\n",
+                      stderr);
+        }
+
+        if (!holds) {
+                const char *format = "%s [seed %" PRIu64 ", case %lu of %lu, "
+                                     "%u shrinks] Counterexample: %s";
+                const char *name = comment == NULL ? "Property" : comment;
+                const char *desc = prop.desc == NULL ? "" : prop.desc;
+
+                len = snprintf(NULL, 0, format, name, suite->property_seed,
+                               failed_case, cases, shrinks, desc);
+                if (len >= 0) failure = malloc(len + 1);
+                if (failure != NULL) {
+                        snprintf(failure, len + 1, format, name,
+                                 suite->property_seed, failed_case, cases,
+                                 shrinks, desc);
+                }
+        }
+
+        free(best);
+        free(candidate);
+        free(prop.choices);
+        for (size_t i = 0; i < prop.num_bufs; ++i) free(prop.bufs[i]);
+        free(prop.bufs);
+        free(prop.buf_sizes);
+        free(prop.desc);
+        heap_paused = prop.was_paused;
+
+        uc_check(suite, holds, holds || failure == NULL ? comment : failure);
+
+        heap_paused = true;
+        free(failure);
+        heap_paused = prop.was_paused;
+
+        return holds;
+}
+
+void run_fuzz_test(uc_suite suite) {
+        struct test *test = suite == thread_suite ? thread_test->data :
+                                                    suite->curr_test->data;
+        struct fuzz_shared *shared;
+        struct timespec start;
+        uint64_t seed = suite->property_seed;
+        /* Hashes of the crashes reported, as worker crashes may repeat. */
+        uint64_t reported[MAX_FUZZ_CRASHES];
+        unsigned int crashes = 0, num_reported = 0;
+        bool was_paused = heap_paused;
+
+        if (test->fuzz == NULL) return;
+
+        shared = mmap(NULL, sizeof(struct fuzz_shared),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                      -1, 0);
+        if (shared == MAP_FAILED) {
+                uc_check(suite, false, "uc_add_fuzz: cannot map fuzz state.");
+                return;
+        }
+
+        /* The workers' allocations are their own, the rest unitc's. */
+        heap_paused = true;
+        for (int i = 0; i < 4; ++i) shared->rng[i] = splitmix(&seed);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        while (!shared->done && crashes < MAX_FUZZ_CRASHES) {
+                int wstatus;
+                bool hung;
+                pid_t pid;
+
+                /* Or the worker may write out the test's buffered output. */
+                fflush(NULL);
+                pid = fork();
+
+                if (pid == -1) {
+                        uc_check(suite, false,
+                                 "uc_add_fuzz: cannot fork fuzz worker.");
+                        break;
+                }
+                if (pid == 0) fuzz_worker(suite, test->fuzz, shared, &start);
+
+                if (!wait_fuzz_child(pid, &wstatus, &shared->runs,
+                                     suite->fuzz_timeout, &hung)) {
+                        uc_check(suite, false,
+                                 "uc_add_fuzz: lost fuzz worker.");
+                        break;
+                }
+                if (shared->done) break;
+
+                report_fuzz_crash(suite, test->fuzz, shared, wstatus, hung,
+                                  reported, &num_reported);
+                ++crashes;
+        }
+
+        if (crashes == 0) {
+                char comment[64];
+
+                snprintf(comment, sizeof(comment), "No crashes in %lu runs.",
+                         shared->runs);
+                uc_check(suite, true, comment);
+        }
+
+        munmap(shared, sizeof(struct fuzz_shared));
+        heap_paused = was_paused;
+}
+
+bool wait_fuzz_child(const pid_t pid, int *wstatus,
+                     const volatile unsigned long *runs, const double timeout,
+                     bool *hung) {
+        unsigned long last_runs = runs != NULL ? *runs : 0;
+        long wait_ns = FUZZ_POLL_MIN_NS;
+        bool killed = false;
+        struct timespec last, now;
+        pid_t reaped;
+
+        if (hung != NULL) *hung = false;
+        clock_gettime(CLOCK_MONOTONIC, &last);
+
+        for (;;) {
+                reaped = waitpid(pid, wstatus,
+                                 timeout > 0 && !killed ? WNOHANG : 0);
+                if (reaped == pid) return true;
+                if (reaped == -1) {
+                        if (errno != EINTR) return false;
+                        continue;
+                }
+
+                /* Still running: see whether it has moved on to another
+                 * input since the last check.
+                 */
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                if (runs != NULL && *runs != last_runs) {
+                        last_runs = *runs;
+                        last = now;
+                } else if (seconds_between(&last, &now) >= timeout) {
+                        kill(pid, SIGKILL);
+                        killed = true;
+                        if (hung != NULL) *hung = true;
+                        continue;
+                }
+
+                nanosleep(&(struct timespec){.tv_nsec = wait_ns}, NULL);
+                if (wait_ns < FUZZ_POLL_MAX_NS) wait_ns *= 2;
+        }
+}
+
+void fuzz_worker(uc_suite suite, const struct fuzz_target *fuzz,
+                 struct fuzz_shared *shared, const struct timespec *start) {
+        GPtrArray *corpus = g_ptr_array_new_with_free_func(&free);
+        unsigned long limit = suite->fuzz_runs;
+        double seconds = suite->fuzz_seconds;
+
+        /* A crash is for the test's process to report, not crash_handler. */
+        reset_crash_handlers();
+
+        load_corpus(fuzz->corpus_dir, corpus);
+        if (corpus->len == 0) {
+                g_ptr_array_add(corpus, calloc(1, sizeof(struct fuzz_input)));
+        }
+
+        coverage_on = true;
+        for (unsigned long i = 0; limit == 0 || shared->runs < limit; ++i) {
+                struct fuzz_input *input;
+
+                if (seconds > 0 && i % 256 == 0) {
+                        struct timespec now;
+
+                        clock_gettime(CLOCK_MONOTONIC, &now);
+                        if (seconds_between(start, &now) >= seconds) break;
+                }
+
+                /* The corpus as is first, then mutations of it. */
+                if (shared->runs < corpus->len) {
+                        input = g_ptr_array_index(corpus, shared->runs);
+                        shared->len = input->len;
+                        memcpy(shared->input, input->data, input->len);
+                } else {
+                        mutate_input(shared, corpus);
+                }
+
+                ++shared->runs;
+                fuzz->func(shared->input, shared->len);
+
+                if (new_coverage(shared)) {
+                        add_to_corpus(suite->fuzz_output, corpus,
+                                      shared->input, shared->len);
+                }
+        }
+
+        shared->done = true;
+        _exit(EXIT_SUCCESS);
+}
+
+void load_corpus(const char *dir, GPtrArray *corpus) {
+        GPtrArray *names;
+        DIR *stream;
+        struct dirent *dirent;
+
+        if (dir == NULL) return;
+
+        stream = opendir(dir);
+        if (stream == NULL) {
+                fprintf(stderr, "uc_add_fuzz: cannot open corpus %s.\n", dir);
+                return;
+        }
+
+        /* In order of name, so runs are the same whatever the directory's
+         * order.
+         */
+        names = g_ptr_array_new_with_free_func(&free);
+        while ((dirent = readdir(stream)) != NULL) {
+                if (dirent->d_name[0] == '.') continue;
+                g_ptr_array_add(names, strdup(dirent->d_name));
+        }
+        closedir(stream);
+        qsort(names->pdata, names->len, sizeof(char *), &compare_names);
+
+        for (unsigned int i = 0; i < names->len; ++i) {
+                char path[PATH_MAX];
+                struct fuzz_input *input;
+                ssize_t len;
+                int fd;
+
+                snprintf(path, sizeof(path), "%s/%s", dir,
+                         (char *)g_ptr_array_index(names, i));
+                fd = open(path, O_RDONLY | O_CLOEXEC);
+                if (fd == -1) continue;
+
+                input = malloc(sizeof(struct fuzz_input) + MAX_FUZZ_INPUT);
+                if (input == NULL) {
+                        close(fd);
+                        continue;
+                }
+
+                /* Longer inputs are cut short. */
+                input->len = 0;
+                while (input->len < MAX_FUZZ_INPUT &&
+                       (len = read(fd, input->data + input->len,
+                                   MAX_FUZZ_INPUT - input->len)) > 0) {
+                        input->len += len;
+                }
+                close(fd);
+
+                g_ptr_array_add(corpus, input);
+        }
+
+        g_ptr_array_free(names, true);
+}
+
+int compare_names(const void *a, const void *b) {
+        return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+void add_to_corpus(const char *dir, GPtrArray *corpus, const uint8_t *data,
+                   const size_t len) {
+        struct fuzz_input *input = malloc(sizeof(struct fuzz_input) + len);
+        char path[PATH_MAX];
+        int fd;
+
+        if (input == NULL) return;
+        input->len = len;
+        memcpy(input->data, data, len);
+        g_ptr_array_add(corpus, input);
+
+        if (dir == NULL) return;
+
+        snprintf(path, sizeof(path), "%s/%016" PRIx64, dir,
+                 fuzz_hash(FNV_OFFSET_BASIS, data, len));
+
+        /* An input already there is the same input. */
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd == -1) return;
+        if (!write_full(fd, data, len)) {
+                fprintf(stderr, "uc_add_fuzz: cannot write %s.\n", path);
+        }
+        close(fd);
+}
+
+void mutate_input(struct fuzz_shared *shared, GPtrArray *corpus) {
+        static const uint8_t interesting[] = { 0x00, 0x01, 0x7f, 0x80, 0xff };
+        uint64_t *rng = shared->rng;
+        struct fuzz_input *base = g_ptr_array_index(corpus,
+                                                    next_random(rng) %
+                                                    corpus->len);
+        uint8_t *input = shared->input;
+        size_t len = base->len;
+        /* Mutations stacked on the input, 1 to 4. */
+        int mutations = 1 + next_random(rng) % 4;
+
+        memcpy(input, base->data, len);
+
+        for (int i = 0; i < mutations; ++i) {
+                size_t pos = len == 0 ? 0 : next_random(rng) % len;
+
+                switch (next_random(rng) % 7) {
+                case 0: /* Flip a bit. */
+                        if (len > 0) input[pos] ^= 1 << (next_random(rng) % 8);
+                        break;
+                case 1: /* Set a byte. */
+                        if (len > 0) input[pos] = next_random(rng);
+                        break;
+                case 2: /* Set a byte to an edge case. */
+                        if (len > 0) {
+                                input[pos] = interesting[next_random(rng) %
+                                                         sizeof(interesting)];
+                        }
+                        break;
+                case 3: /* Insert a byte. */
+                        if (len < MAX_FUZZ_INPUT) {
+                                memmove(input + pos + 1, input + pos,
+                                        len - pos);
+                                input[pos] = next_random(rng);
+                                ++len;
+                        }
+                        break;
+                case 4: /* Delete a byte. */
+                        if (len > 0) {
+                                memmove(input + pos, input + pos + 1,
+                                        len - pos - 1);
+                                --len;
+                        }
+                        break;
+                case 5: /* Add to a byte. */
+                        if (len > 0) input[pos] += 1 + next_random(rng) % 16;
+                        break;
+                default: { /* Splice in part of another input. */
+                        struct fuzz_input *other;
+                        size_t from, count;
+
+                        other = g_ptr_array_index(corpus, next_random(rng) %
+                                                          corpus->len);
+                        if (other->len == 0) break;
+                        from = next_random(rng) % other->len;
+                        count = 1 + next_random(rng) % (other->len - from);
+                        if (count > MAX_FUZZ_INPUT - pos) {
+                                count = MAX_FUZZ_INPUT - pos;
+                        }
+                        memcpy(input + pos, other->data + from, count);
+                        if (pos + count > len) len = pos + count;
+                        break;
+                }
+                }
+        }
+
+        shared->len = len;
+}
+
+uint8_t coverage_bucket(const uint8_t hits) {
+        if (hits <= 3) return hits == 3 ? 4 : hits;
+        if (hits <= 7) return 8;
+        if (hits <= 15) return 16;
+        if (hits <= 31) return 32;
+        if (hits <= 127) return 64;
+        return 128;
+}
+
+bool new_coverage(struct fuzz_shared *shared) {
+        bool found = false;
+
+        for (uint32_t i = 0; i < num_touched; ++i) {
+                uint32_t slot = touched[i];
+                uint8_t bucket = coverage_bucket(coverage[slot]);
+
+                if ((bucket & ~shared->seen[slot]) != 0) {
+                        shared->seen[slot] |= bucket;
+                        found = true;
+                }
+                coverage[slot] = 0;
+        }
+        num_touched = 0;
+
+        return found;
+}
+
+void report_fuzz_crash(uc_suite suite, const struct fuzz_target *fuzz,
+                       struct fuzz_shared *shared, const int wstatus,
+                       const bool hung, uint64_t *reported,
+                       unsigned int *num_reported) {
+        uint8_t *input = malloc(shared->len + 1);
+        size_t len = shared->len;
+        char comment[128 + 3 * SHOWN_FUZZ_BYTES];
+        uint64_t hash;
+        size_t used;
+
+        if (input == NULL) {
+                uc_check(suite, false, "uc_add_fuzz: input crashed.");
+                return;
+        }
+        memcpy(input, shared->input, len);
+        /* An input which makes func exit successfully cannot be told from
+         * one which doesn't.
+         */
+        if (!hung && (!WIFEXITED(wstatus) ||
+                      WEXITSTATUS(wstatus) != EXIT_SUCCESS)) {
+                len = minimise_input(fuzz, input, len, wstatus,
+                                     suite->fuzz_timeout);
+        }
+
+        /* A hang is a SIGKILL, but not a crash by one. */
+        hash = fuzz_hash(fuzz_hash(fuzz_hash(FNV_OFFSET_BASIS, input, len),
+                                   &wstatus, sizeof(int)),
+                         &hung, sizeof(bool));
+        for (unsigned int i = 0; i < *num_reported; ++i) {
+                if (reported[i] == hash) {
+                        free(input);
+                        return;
+                }
+        }
+        reported[(*num_reported)++] = hash;
+
+        if (hung) {
+                used = snprintf(comment, sizeof(comment),
+                                "Hung: over %.3f s, run %lu, input [",
+                                suite->fuzz_timeout, shared->runs);
+        } else if (WIFSIGNALED(wstatus)) {
+                used = snprintf(comment, sizeof(comment),
+                                "Crashed: %s (signal %d), run %lu, input [",
+                                strsignal(WTERMSIG(wstatus)),
+                                WTERMSIG(wstatus), shared->runs);
+        } else {
+                used = snprintf(comment, sizeof(comment),
+                                "Exited with status %d, run %lu, input [",
+                                WEXITSTATUS(wstatus), shared->runs);
+        }
+
+        for (size_t i = 0; i < len && i < SHOWN_FUZZ_BYTES &&
+                           used < sizeof(comment); ++i) {
+                used += snprintf(comment + used, sizeof(comment) - used,
+                                 i == 0 ? "%02x" : " %02x", input[i]);
+        }
+        if (used < sizeof(comment)) {
+                snprintf(comment + used, sizeof(comment) - used,
+                         len > SHOWN_FUZZ_BYTES ? " ...] (%zu bytes)." :
+                                                  "] (%zu bytes).", len);
+        }
+
+        uc_check(suite, false, comment);
+        free(input);
+}
+
+uint64_t fuzz_hash(uint64_t hash, const void *data, const size_t len) {
+        const uint8_t *bytes = data;
+
+        for (size_t i = 0; i < len; ++i) {
+                hash = (hash ^ bytes[i]) * 0x100000001b3;
+        }
+
+        return hash;
+}
+
+size_t minimise_input(const struct fuzz_target *fuzz, uint8_t *input,
+                      size_t len, const int wstatus, const double timeout) {
+        uint8_t *candidate = malloc(len + 1);
+        unsigned int tries = 0;
+
+        if (candidate == NULL) return len;
+
+        /* Delete ever smaller chunks... */
+        for (size_t chunk = len / 2 > 0 ? len / 2 : 1; chunk > 0; chunk /= 2) {
+                for (size_t i = 0; i + chunk <= len &&
+                                   tries < MINIMISE_LIMIT;) {
+                        memcpy(candidate, input, i);
+                        memcpy(candidate + i, input + i + chunk,
+                               len - i - chunk);
+                        ++tries;
+                        if (crashes_like(fuzz, candidate, len - chunk,
+                                         wstatus, timeout)) {
+                                len -= chunk;
+                                memcpy(input, candidate, len);
+                        } else {
+                                i += chunk;
+                        }
+                }
+        }
+
+        /* ...then zero the bytes left. */
+        for (size_t i = 0; i < len && tries < MINIMISE_LIMIT; ++i) {
+                if (input[i] == 0) continue;
+
+                memcpy(candidate, input, len);
+                candidate[i] = 0;
+                ++tries;
+                if (crashes_like(fuzz, candidate, len, wstatus, timeout)) {
+                        input[i] = 0;
+                }
+        }
+
+        free(candidate);
+        return len;
+}
+
+bool crashes_like(const struct fuzz_target *fuzz, const uint8_t *input,
+                  const size_t len, const int wstatus, const double timeout) {
+        int candidate_wstatus;
+        bool hung;
+        pid_t pid;
+
+        fflush(NULL);
+        pid = fork();
+        if (pid == -1) return false;
+        if (pid == 0) {
+                reset_crash_handlers();
+                coverage_on = false;
+                fuzz->func(input, len);
+                _exit(EXIT_SUCCESS);
+        }
+
+        return wait_fuzz_child(pid, &candidate_wstatus, NULL, timeout,
+                               &hung) &&
+               !hung && candidate_wstatus == wstatus;
+}
+
+void run_load_test(uc_suite suite) {
+        struct test *test = suite == thread_suite ? thread_test->data :
+                                                    suite->curr_test->data;
+        const struct uc_load_options *options;
+        struct load_shared *shared;
+        struct load_stats *stats;
+        unsigned int num_callers;
+        size_t shared_size;
+        uint64_t start, deadline = 0;
+        bool was_paused = heap_paused;
+
+        if (test->load == NULL) return;
+
+        options = &test->load->options;
+        num_callers = options->threads *
+                      (options->processes > 0 ? options->processes : 1);
+        shared_size = sizeof(struct load_shared) +
+                      num_callers * sizeof(struct load_caller);
+        shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shared == MAP_FAILED) {
+                uc_check(suite, false,
+                         "uc_add_load_test: cannot map load state.");
+                return;
+        }
+
+        /* The callers' allocations are their own, the rest unitc's. */
+        heap_paused = true;
+        start = monotonic_ns();
+        if (options->seconds > 0) {
+                deadline = start + (uint64_t)(options->seconds * 1e9);
+        }
+
+        if (options->processes == 0) {
+                if (!run_load_callers(test->load, shared, 0, deadline)) {
+                        uc_check(suite, false,
+                                 "uc_add_load_test: cannot start callers.");
+                }
+        } else {
+                unsigned int forked = 0;
+                pid_t *pids = malloc(options->processes * sizeof(pid_t));
+
+                /* Or the callers may write out the test's buffered output. */
+                fflush(NULL);
+                for (; pids != NULL && forked < options->processes;
+                     ++forked) {
+                        pids[forked] = fork();
+                        if (pids[forked] == -1) break;
+                        if (pids[forked] == 0) {
+                                /* A crash is for the test's process to
+                                 * report, not crash_handler.
+                                 */
+                                reset_crash_handlers();
+                                heap_paused = was_paused;
+                                _exit(run_load_callers(test->load, shared,
+                                                       forked *
+                                                       options->threads,
+                                                       deadline) ?
+                                      EXIT_SUCCESS : EXIT_FAILURE);
+                        }
+                }
+
+                if (forked < options->processes) {
+                        uc_check(suite, false,
+                                 "uc_add_load_test: cannot fork callers.");
+                }
+                for (unsigned int i = 0; i < forked; ++i) {
+                        char comment[80];
+                        int wstatus;
+
+                        if (!wait_fuzz_child(pids[i], &wstatus, NULL, 0,
+                                             NULL)) {
+                                uc_check(suite, false,
+                                         "uc_add_load_test: lost caller.");
+                        } else if (WIFSIGNALED(wstatus)) {
+                                snprintf(comment, sizeof(comment),
+                                         "Caller process %u was killed by "
+                                         "signal %d.", i, WTERMSIG(wstatus));
+                                uc_check(suite, false, comment);
+                        } else if (WEXITSTATUS(wstatus) != EXIT_SUCCESS) {
+                                snprintf(comment, sizeof(comment),
+                                         "Caller process %u exited with "
+                                         "status %d.", i,
+                                         WEXITSTATUS(wstatus));
+                                uc_check(suite, false, comment);
+                        }
+                }
+                free(pids);
+        }
+
+        stats = &test->load_stats;
+        stats->seconds = (monotonic_ns() - start) / 1e9;
+        stats->callers = num_callers;
+        stats->errors = shared->callers[0].errors;
+        for (unsigned int i = 1; i < num_callers; ++i) {
+                merge_latencies(&shared->callers[0].latencies,
+                                &shared->callers[i].latencies);
+                stats->errors += shared->callers[i].errors;
+        }
+        stats->calls = shared->callers[0].latencies.total;
+        stats->p50 = latency_percentile(&shared->callers[0].latencies,
+                                        500) / 1e9;
+        stats->p99 = latency_percentile(&shared->callers[0].latencies,
+                                        990) / 1e9;
+        stats->p999 = latency_percentile(&shared->callers[0].latencies,
+                                         999) / 1e9;
+        stats->max = shared->callers[0].latencies.max / 1e9;
+        test->has_load = true;
+
+        check_load(suite, options, stats);
+
+        munmap(shared, shared_size);
+        heap_paused = was_paused;
+}
+
+bool run_load_callers(const struct load_target *load,
+                      struct load_shared *shared, const unsigned int first,
+                      const uint64_t deadline) {
+        struct load_thread *threads;
+        unsigned int started = 1;
+        bool was_paused = heap_paused;
+
+        heap_paused = true;
+        threads = malloc(load->options.threads * sizeof(struct load_thread));
+        heap_paused = was_paused;
+        if (threads == NULL) return false;
+
+        for (unsigned int i = 0; i < load->options.threads; ++i) {
+                threads[i].load = load;
+                threads[i].shared = shared;
+                threads[i].caller = first + i;
+                threads[i].deadline = deadline;
+        }
+
+        /* The calling thread is the first caller. */
+        for (; started < load->options.threads; ++started) {
+                if (pthread_create(&threads[started].thread, NULL,
+                                   &call_load, &threads[started]) != 0) {
+                        break;
+                }
+        }
+        call_load(&threads[0]);
+        for (unsigned int i = 1; i < started; ++i) {
+                pthread_join(threads[i].thread, NULL);
+        }
+
+        heap_paused = true;
+        free(threads);
+        heap_paused = was_paused;
+
+        return started == load->options.threads;
+}
+
+void *call_load(void *arg) {
+        const struct load_thread *thread = arg;
+        const struct load_target *load = thread->load;
+        struct load_caller *caller = &thread->shared->callers[thread->caller];
+        struct latency_histogram *latencies = &caller->latencies;
+
+        for (;;) {
+                uint64_t start, end;
+
+                if (load->options.calls > 0 &&
+                    ATOMIC_ADD(thread->shared->calls, 1) >=
+                    load->options.calls) {
+                        break;
+                }
+
+                start = monotonic_ns();
+                if (!load->func(thread->caller)) ++caller->errors;
+                end = monotonic_ns();
+
+                ++latencies->counts[latency_bucket(end - start)];
+                ++latencies->total;
+                if (end - start > latencies->max) latencies->max = end - start;
+
+                if (thread->deadline != 0 && end >= thread->deadline) break;
+        }
+
+        return NULL;
+}
+
+void check_load(uc_suite suite, const struct uc_load_options *options,
+                const struct load_stats *stats) {
+        static const char *const names[] = { "p50", "p99", "p99.9", "Max" };
+        const double limits[] = { options->max_p50, options->max_p99,
+                                  options->max_p999, options->max_latency };
+        const double latencies[] = { stats->p50, stats->p99, stats->p999,
+                                     stats->max };
+        double error_rate = stats->calls == 0 ? 0 :
+                            (double)stats->errors / stats->calls;
+        char comment[96];
+
+        snprintf(comment, sizeof(comment),
+                 "%lu/%lu calls failed (%.2f%%), at most %.2f%% allowed.",
+                 stats->errors, stats->calls, error_rate * 100,
+                 options->max_error_rate * 100);
+        uc_check(suite, error_rate <= options->max_error_rate, comment);
+
+        for (size_t i = 0; i < sizeof(limits) / sizeof(limits[0]); ++i) {
+                if (limits[i] <= 0) continue;
+
+                snprintf(comment, sizeof(comment),
+                         "%s latency %.3f us, at most %.3f us allowed.",
+                         names[i], latencies[i] * 1e6, limits[i] * 1e6);
+                uc_check(suite, latencies[i] <= limits[i], comment);
+        }
+
+        if (options->min_throughput > 0) {
+                double throughput = stats->seconds > 0 ?
+                                    stats->calls / stats->seconds : 0;
+
+                snprintf(comment, sizeof(comment),
+                         "Throughput %.1f calls/s, at least %.1f calls/s "
+                         "required.", throughput, options->min_throughput);
+                uc_check(suite, throughput >= options->min_throughput,
+                         comment);
+        }
+}
+
+size_t latency_bucket(const uint64_t ns) {
+        int shift = 63 - __builtin_clzll(ns | (LATENCY_SUB_BUCKETS - 1)) -
+                    (LATENCY_SUB_BITS - 1);
+
+        return (size_t)shift * (LATENCY_SUB_BUCKETS / 2) + (ns >> shift);
+}
+
+uint64_t latency_bucket_max(const size_t bucket) {
+        unsigned int shift = bucket < LATENCY_SUB_BUCKETS ? 0 :
+                             bucket / (LATENCY_SUB_BUCKETS / 2) - 1;
+        uint64_t lowest = (uint64_t)(bucket -
+                                     shift * (LATENCY_SUB_BUCKETS / 2))
+                          << shift;
+
+        return lowest + (((uint64_t)1 << shift) - 1);
+}
+
+void merge_latencies(struct latency_histogram *dst,
+                     const struct latency_histogram *src) {
+        if (src->total == 0) return;
+
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+                dst->counts[i] += src->counts[i];
+        }
+        dst->total += src->total;
+        if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t latency_percentile(const struct latency_histogram *histogram,
+                            const unsigned int permille) {
+        /* Calls at or below the percentile, rounded up. */
+        uint64_t rank = (histogram->total * permille + 999) / 1000;
+        uint64_t seen = 0;
+
+        if (histogram->total == 0) return 0;
+        if (rank == 0) rank = 1;
+
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+                seen += histogram->counts[i];
+                if (seen >= rank) {
+                        uint64_t max = latency_bucket_max(i);
+
+                        return max < histogram->max ? max : histogram->max;
+                }
+        }
+
+        return histogram->max;
+}
+
+void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop) {
+        /* Called once per module, possibly more than once. */
+        if (start == stop || *start != 0) return;
+
+        for (uint32_t *guard = start; guard < stop; ++guard) {
+                *guard = ++num_guards;
+        }
+}
+
+void count_hit(const uint32_t slot) {
+        if (coverage[slot] == 0) touched[num_touched++] = slot;
+        if (coverage[slot] != UINT8_MAX) ++coverage[slot];
+}
+
+void __sanitizer_cov_trace_pc_guard(uint32_t *guard) {
+        if (coverage_on) count_hit(*guard & (COVERAGE_MAP_SIZE - 1));
+}
+
+void __sanitizer_cov_trace_pc(void) {
+        uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+
+        if (coverage_on) count_hit((pc ^ (pc >> 16)) & (COVERAGE_MAP_SIZE - 1));
+}
+
+void uc_add_test(uc_suite suite, void (*test_func)(uc_suite suite),
+                 const char *name, const char *comment) {
+        struct test *test;
+        test = malloc(sizeof(struct test));
+        if (test == NULL) {
+                fprintf(stderr, "uc_add_test: failure to add test: %s\n",
+                        comment == NULL ? "no name provided." : name);
+                return;
+        }
+
+        ALLOC_STRING(name, test->name,
+                     { fprintf(stderr,
+                               "uc_add_test: failure to save name: %s\n",
+                               name); });
+        ALLOC_STRING(comment, test->comment,
+                     { fprintf(stderr,
+                               "uc_add_test: failure to save comment: %s\n",
+                               comment); });
+
+        init_test(test, test_func, suite->num_tests, suite->curr_group);
+
+        ++suite->num_tests;
+        suite->tests = g_list_prepend(suite->tests, test);
+}
+
+void uc_add_fuzz(uc_suite suite, void (*func)(const uint8_t *data,
+                                              size_t size),
+                 const char *name, const char *corpus_dir) {
+        struct fuzz_target *fuzz;
+        unsigned int num_tests;
+
+        if (suite == NULL || func == NULL) return;
+
+        fuzz = malloc(sizeof(struct fuzz_target));
+        if (fuzz == NULL) {
+                fprintf(stderr, "uc_add_fuzz: failure to add test: %s\n",
+                        name == NULL ? "no name provided." : name);
+                return;
+        }
+        fuzz->func = func;
+        ALLOC_STRING(corpus_dir, fuzz->corpus_dir,
+                     { fprintf(stderr,
+                               "uc_add_fuzz: failure to save corpus: %s\n",
+                               corpus_dir); });
+
+        num_tests = suite->num_tests;
+        uc_add_test(suite, &run_fuzz_test, name, NULL);
+        if (suite->num_tests == num_tests) {
+                if (fuzz->corpus_dir != NULL) free(fuzz->corpus_dir);
+                free(fuzz);
+                return;
+        }
+
+        ((struct test *)suite->tests->data)->fuzz = fuzz;
+}
+
+void uc_add_load_test(uc_suite suite, bool (*func)(unsigned int caller),
+                      const char *name, const char *comment,
+                      const struct uc_load_options *options) {
+        struct load_target *load;
+        unsigned int num_tests;
+
+        if (suite == NULL || func == NULL) return;
+
+        load = calloc(1, sizeof(struct load_target));
+        if (load == NULL) {
+                fprintf(stderr, "uc_add_load_test: failure to add test: %s\n",
+                        name == NULL ? "no name provided." : name);
+                return;
+        }
+        load->func = func;
+        if (options != NULL) load->options = *options;
+        if (load->options.threads == 0) load->options.threads = 1;
+        if (load->options.seconds < 0) load->options.seconds = 0;
+        if (load->options.seconds == 0 && load->options.calls == 0) {
+                load->options.seconds = DEFAULT_LOAD_SECONDS;
+        }
+
+        num_tests = suite->num_tests;
+        uc_add_test(suite, &run_load_test, name, comment);
+        if (suite->num_tests == num_tests) {
+                free(load);
+                return;
+        }
+
+        ((struct test *)suite->tests->data)->load = load;
+}
+
+void uc_add_test_descs(uc_suite suite, const struct uc_test_desc *start,
+                       const struct uc_test_desc *stop) {
+        struct described_test *block;
+        size_t num_tests;
+
+        if (suite == NULL || start == NULL || stop <= start) return;
+
+        num_tests = stop - start;
+        block = malloc(sizeof(struct described_test) * num_tests);
+        if (block == NULL) {
+                fputs("uc_add_test_descs: failure to add tests.\n", stderr);
+                return;
+        }
+
+        /* The linker keeps no particular order. */
+        for (size_t i = 0; i < num_tests; ++i) block[i].desc = &start[i];
+        qsort(block, num_tests, sizeof(struct described_test),
+              &compare_described_tests);
+
+        for (size_t i = 0; i < num_tests; ++i) {
+                struct test *test = &block[i].test;
+                GList *entry = &block[i].entry;
+
+                init_test(test, block[i].desc->test_func, suite->num_tests,
+                          suite->curr_group);
+                test->name = (char *)block[i].desc->name;
+                test->comment = (char *)block[i].desc->comment;
+                test->described = true;
+                ++suite->num_tests;
+
+                /* As g_list_prepend, without allocating. */
+                entry->data = test;
+                entry->prev = NULL;
+                entry->next = suite->tests;
+                suite->tests->prev = entry;
+                suite->tests = entry;
+        }
+
+        suite->test_blocks = g_list_prepend(suite->test_blocks, block);
+}
+
+void uc_set_suite_fixture(uc_suite suite, void (*setup)(uc_suite suite),
+                          void (*teardown)(uc_suite suite)) {
+        if (suite == NULL) return;
+
+        suite->setup = setup;
+        suite->teardown = teardown;
+}
+
+void uc_begin_group(uc_suite suite, void (*setup)(uc_suite suite),
+                    void (*teardown)(uc_suite suite)) {
+        struct group *group;
+        if (suite == NULL) return;
+
+        group = malloc(sizeof(struct group));
+        if (group == NULL) {
+                fputs("uc_begin_group: failure to add group.\n", stderr);
+                return;
+        }
+
+        group->setup = setup;
+        group->teardown = teardown;
+
+        suite->groups = g_list_prepend(suite->groups, group);
+        suite->curr_group = group;
+}
+
+void uc_end_group(uc_suite suite) {
+        if (suite == NULL) return;
+        suite->curr_group = NULL;
+}
+
+void uc_set_test_fixture(uc_suite suite, void (*setup)(uc_suite suite),
+                         void (*teardown)(uc_suite suite)) {
+        if (suite == NULL) return;
+
+        suite->test_setup = setup;
+        suite->test_teardown = teardown;
+}
+
+void uc_add_resource(uc_suite suite, const char *name,
+                     const unsigned int capacity) {
+        struct resource *resource;
+
+        if (suite == NULL || name == NULL || capacity == 0) return;
+
+        resource = find_resource(suite, name);
+        if (resource == NULL) {
+                fprintf(stderr, "uc_add_resource: failure to add resource: "
+                        "%s\n", name);
+                return;
+        }
+
+        resource->capacity = capacity;
+}
+
+bool uc_test_uses(uc_suite suite, const char *resource,
+                  const unsigned int units) {
+        struct test *test;
+        struct resource_use *use;
+
+        /* The final test is for checks made outside a test. */
+        if (suite == NULL || suite->tests->next == NULL) return false;
+
+        test = suite->tests->data;
+        if (resource == NULL) {
+                test->alone = true;
+                return true;
+        }
+
+        use = malloc(sizeof(struct resource_use));
+        if (use == NULL) return false;
+
+        use->resource = find_resource(suite, resource);
+        use->units = units;
+        if (use->resource == NULL || units > use->resource->capacity) {
+                free(use);
+                return false;
+        }
+
+        test->uses = g_list_prepend(test->uses, use);
+        return true;
+}
+
+bool uc_test_after(uc_suite suite, const char *prerequisite) {
+        struct test *test;
+
+        if (suite == NULL || prerequisite == NULL ||
+            suite->tests->next == NULL) {
+                return false;
+        }
+
+        test = suite->tests->data;
+        /* Only earlier tests, so prerequisites can't form a cycle. */
+        for (GList *curr = suite->tests->next; curr != NULL;
+             curr = curr->next) {
+                struct test *other = curr->data;
+
+                if (other->name == NULL ||
+                    strcmp(other->name, prerequisite) != 0) {
+                        continue;
+                }
+
+                test->prerequisites = g_list_prepend(test->prerequisites,
+                                                     other);
+                return true;
+        }
+
+        return false;
+}
+
+void uc_set_batch_size(uc_suite suite, const unsigned int batch_size) {
+        if (suite == NULL) return;
+        suite->batch_size = batch_size == 0 ? 1 : batch_size;
+}
+
+void uc_set_jobs(uc_suite suite, const unsigned int jobs) {
+        if (suite == NULL) return;
+        suite->jobs = jobs;
+}
+
+void uc_set_output_limit(uc_suite suite, const size_t limit) {
+        if (suite == NULL) return;
+        suite->output_limit = limit;
+}
+
+void uc_set_property_cases(uc_suite suite, const unsigned long cases) {
+        if (suite == NULL || cases == 0) return;
+        suite->property_cases = cases;
+}
+
+void uc_set_property_seed(uc_suite suite, const uint64_t seed) {
+        if (suite == NULL) return;
+        suite->property_seed = seed;
+}
+
+void uc_set_fuzz_limits(uc_suite suite, const unsigned long runs,
+                        const double seconds) {
+        if (suite == NULL) return;
+
+        suite->fuzz_seconds = seconds > 0 ? seconds : 0;
+        /* Without a time limit, there has to be a limit on runs. */
+        suite->fuzz_runs = runs == 0 && seconds <= 0 ? DEFAULT_FUZZ_RUNS :
+                                                       runs;
+}
+
+void uc_set_fuzz_timeout(uc_suite suite, const double seconds) {
+        if (suite == NULL) return;
+
+        suite->fuzz_timeout = seconds > 0 ? seconds : 0;
+}
+
+void uc_set_fuzz_output(uc_suite suite, const char *dir) {
+        if (suite == NULL) return;
+
+        if (suite->fuzz_output != NULL) free(suite->fuzz_output);
+        suite->fuzz_output = NULL;
+        if (dir != NULL) ALLOC_STRING(dir, suite->fuzz_output, return;);
+}
+
+void uc_set_coverage_map(uc_suite suite, const char *path,
+                         void (*dump)(void), void (*reset)(void)) {
+        if (suite == NULL) return;
+
+        if (suite->coverage_map != NULL) free(suite->coverage_map);
+        suite->coverage_map = NULL;
+        if (path == NULL || dump == NULL || reset == NULL) return;
+
+        ALLOC_STRING(path, suite->coverage_map, return;);
+        suite->coverage_dump = dump;
+        suite->coverage_reset = reset;
+}
+
+void uc_set_trace(uc_suite suite, const char *path) {
+        if (suite == NULL) return;
+
+        if (suite->trace_path != NULL) free(suite->trace_path);
+        suite->trace_path = NULL;
+        if (path != NULL) ALLOC_STRING(path, suite->trace_path, return;);
+}
+
+void uc_set_profile(uc_suite suite, const char *dir,
+                    const double min_seconds) {
+        if (suite == NULL) return;
+
+        if (suite->profile_dir != NULL) free(suite->profile_dir);
+        suite->profile_dir = NULL;
+        suite->profile_min_seconds = min_seconds > 0 ? min_seconds : 0;
+        if (dir != NULL) ALLOC_STRING(dir, suite->profile_dir, return;);
+}
+
+bool uc_select_tests(uc_suite suite, const char *changes_path) {
+        struct coverage_map map;
+        GList *changes = NULL;
+        bool read;
+
+        if (suite == NULL || suite->coverage_map == NULL) return false;
+
+        read = read_coverage_map(suite->coverage_map, &map) &&
+               read_changes(changes_path, &changes);
+
+        /* Guaranteed to have at least one element from uc_init. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                struct test *test = curr->data;
+                struct map_entry *entry = NULL;
+                char buf[32];
+
+                if (read) {
+                        GList *found = g_hash_table_lookup(
+                                map.index, test_key(test, buf));
+
+                        if (found != NULL) entry = found->data;
+                }
+
+                /* Tests not in the map are always run. */
+                test->skipped = entry != NULL &&
+                                !covers_change(entry->functions, changes);
+        }
+
+        free_coverage_map(&map);
+        g_list_free_full(changes, &struct_change_free);
+
+        return read;
+}
+
+void uc_set_repeat(uc_suite suite, const unsigned int times,
+                   const double seconds) {
+        if (suite == NULL) return;
+
+        suite->repeat_seconds = seconds > 0 ? seconds : 0;
+        /* Without a time limit, there has to be a limit on runs. */
+        suite->repeat_times = times == 0 && seconds <= 0 ? 1 : times;
+}
+
+void uc_set_cpus(uc_suite suite, const int *cpus, const size_t num_cpus) {
+        int *copy = NULL;
+        if (suite == NULL || (cpus == NULL && num_cpus > 0)) return;
+
+        for (size_t i = 0; i < num_cpus; ++i) {
+                if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+                        fprintf(stderr, "uc_set_cpus: invalid CPU %d.\n",
+                                cpus[i]);
+                        return;
+                }
+        }
+
+        if (num_cpus > 0) {
+                copy = malloc(sizeof(int) * num_cpus);
+                if (copy == NULL) {
+                        fputs("uc_set_cpus: failure to save CPUs.\n", stderr);
+                        return;
+                }
+                memcpy(copy, cpus, sizeof(int) * num_cpus);
+        }
+
+        if (suite->cpus != NULL) free(suite->cpus);
+        suite->cpus = copy;
+        suite->num_cpus = num_cpus;
+}
+
+void uc_set_nice(uc_suite suite, const int nice) {
+        if (suite == NULL) return;
+        suite->nice = nice;
+        suite->has_nice = true;
+}
+
+void uc_set_realtime(uc_suite suite, const int priority) {
+        if (suite == NULL) return;
+        suite->rt_priority = priority;
+}
+
+void uc_run_tests(uc_suite suite) {
+        uc_run run;
+        if (suite == NULL) return;
+
+        run = uc_run_tests_async(suite);
+        if (run == NULL) {
+                fputs("uc_run_tests: cannot start running tests.\n", stderr);
+                return;
+        }
+
+        uc_run_wait(run);
+}
+
+uc_run uc_run_tests_async(uc_suite suite) {
+        if (suite == NULL) return NULL;
+        return start_run(suite, NULL);
+}
+
+uc_run start_run(uc_suite suite, struct process_pool *pool) {
+        struct epoll_event event;
+        uc_run run;
+
+        run = malloc(sizeof(struct uc_run));
+        if (run == NULL) return NULL;
+
+        run->suite = suite;
+        run->pool = pool;
+        /* Guaranteed to have at least one element from uc_init. */
+        run->next = g_list_last(suite->tests)->prev;
+        run->prev_group = NULL;
+        run->done = false;
+        run->segment_running = false;
+        run->segment_done = false;
+        run->segment_next = NULL;
+        run->iteration = 0;
+        run->repeat_stop = false;
+        run->trace = NULL;
+        run->alone = false;
+        /* Alone, tests run one at a time unless in parallel, and runs of the
+         * same test at the same time.
+         */
+        run->num_slots = pool != NULL ? pool->size : 1;
+        if (repeating(suite) ||
+            (pool == NULL && suite->options & UC_OPT_PARALLEL)) {
+                long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+                run->num_slots = suite->jobs;
+                if (run->num_slots == 0) {
+                        run->num_slots = num_cpus > 0 ? num_cpus : 1;
+                }
+        }
+        run->slots = malloc(sizeof(struct slot) * run->num_slots);
+        /* Signalled so the first step starts the tests. */
+        run->event_fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        run->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (run->slots != NULL) {
+                for (unsigned int i = 0; i < run->num_slots; ++i) {
+                        struct slot *slot = &run->slots[i];
+
+                        slot->pid = -1;
+                        slot->results_fd = -1;
+                        slot->output_fd = -1;
+                        slot->output_ring.data = NULL;
+                        slot->output_ring.capacity = suite->output_limit;
+                        slot->output_ring.start = 0;
+                        slot->output_ring.len = 0;
+                        slot->output_ring.dropped = 0;
+                        slot->results.data = NULL;
+                        slot->results.len = 0;
+                        slot->results.capacity = 0;
+                        slot->results.pos = 0;
+                        slot->results.comments = NULL;
+                        slot->repeat_entry = NULL;
+                        slot->claimed = NULL;
+                        slot->reaping = false;
+                        slot->pid_fd = -1;
+                }
+        }
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+        if (run->slots == NULL || run->event_fd == -1 ||
+            run->poll_fd == -1 ||
+            epoll_ctl(run->poll_fd, EPOLL_CTL_ADD, run->event_fd,
+                      &event) == -1) {
+                struct_run_free(run);
+                return NULL;
+        }
+
+        /* Tests left out by uc_select_tests are hidden from the run. */
+        run->all_tests = NULL;
+        for (GList *curr = suite->tests; curr != NULL; curr = curr->next) {
+                if (((struct test *)curr->data)->skipped) {
+                        run->all_tests = suite->tests;
+                        break;
+                }
+        }
+        if (run->all_tests != NULL) {
+                GList *selected = NULL;
+
+                for (GList *curr = g_list_last(suite->tests); curr != NULL;
+                     curr = curr->prev) {
+                        struct test *test = curr->data;
+
+                        if (!test->skipped) {
+                                selected = g_list_prepend(selected, test);
+                        }
+                }
+                suite->tests = selected;
+                suite->curr_test = g_list_last(suite->tests);
+                run->next = suite->curr_test->prev;
+        }
+
+        for (GList *curr = suite->tests; curr != NULL; curr = curr->next) {
+                struct test *test = curr->data;
+
+                test->started = false;
+                test->finished = false;
+                test->blocked_by = NULL;
+        }
+        for (GList *curr = suite->resources; curr != NULL;
+             curr = curr->next) {
+                struct resource *resource = curr->data;
+
+                resource->in_use = 0;
+                resource->pooled = pool != NULL ?
+                                   pool_resource(pool, resource) : NULL;
+        }
+
+        /* Counters are per process, so threads share them. */
+        if (suite->coverage_map != NULL &&
+            !(suite->options & UC_OPT_THREADS)) {
+                char dir[] = "/tmp/uc_coverage.XXXXXX";
+
+                if (mkdtemp(dir) != NULL) suite->coverage_dir = strdup(dir);
+                if (suite->coverage_dir == NULL) {
+                        fputs("uc_run_tests: cannot record coverage.\n",
+                              stderr);
+                }
+        }
+
+        /* Threads have no lanes of their own. */
+        if (suite->trace_path != NULL &&
+            !(suite->options & UC_OPT_THREADS)) {
+                start_trace(run);
+        }
+
+        resolve_cpus(suite);
+        run_parent_hook(suite, suite->setup);
+
+        if (!(suite->options & UC_OPT_THREADS) &&
+            suite->options & UC_OPT_ZYGOTE && !start_zygote(suite)) {
+                fputs("uc_run_tests: cannot create zygote, forking tests "
+                      "directly.\n", stderr);
+        }
+
+        /* The zygote reports exits of test processes being reaped. */
+        if (suite->zygote != -1) {
+                struct epoll_event event;
+
+                memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN;
+                event.data.ptr = NULL;
+                epoll_ctl(run->poll_fd, EPOLL_CTL_ADD, suite->zygote_fd,
+                          &event);
+        }
+
+        return run;
+}
+
+int uc_run_fd(uc_run run) {
+        return run != NULL ? run->poll_fd : -1;
+}
+
+bool uc_run_step(uc_run run) {
+        eventfd_t events;
+
+        if (run == NULL || run->done) return false;
+
+        /* Reset; set again below if there is more to do. */
+        eventfd_read(run->event_fd, &events);
+
+        if (run->suite->options & UC_OPT_THREADS) {
+                /* The segment signals event_fd once it has finished. */
+                if (run->segment_running &&
+                    __atomic_load_n(&run->segment_done, __ATOMIC_ACQUIRE)) {
+                        join_segment(run);
+                }
+                if (!run->segment_running && run->next != NULL) {
+                        start_segment(run);
+                }
+        } else {
+                /* Or the exits the zygote reports keep uc_run_fd readable. */
+                if (run->suite->zygote != -1 &&
+                    !read_zygote_exits(run->suite)) {
+                        epoll_ctl(run->poll_fd, EPOLL_CTL_DEL,
+                                  run->suite->zygote_fd, NULL);
+                }
+
+                for (unsigned int i = 0; i < run->num_slots; ++i) {
+                        if (slot_busy(&run->slots[i])) {
+                                service_slot(run, &run->slots[i]);
+                        }
+                }
+
+                fill_slots(run);
+        }
+
+        if (!run_busy(run) && run->next == NULL) {
+                finish_run(run);
+                eventfd_write(run->event_fd, 1);
+                return false;
+        }
+
+        /* Only the pipes of running processes show more work, or those of
+         * other runs holding processes, resources or all of the pool.
+         */
+        if (!run_busy(run) && pool_idle(run->pool)) {
+                eventfd_write(run->event_fd, 1);
+        }
+
+        return true;
+}
+
+void uc_run_wait(uc_run run) {
+        if (run == NULL) return;
+
+        while (uc_run_step(run)) {
+                struct pollfd fds;
+
+                fds.fd = run->poll_fd;
+                fds.events = POLLIN;
+                if (poll(&fds, 1, -1) == -1 && errno != EINTR) {
+                        fputs("uc_run_wait: cannot wait for tests.\n",
+                              stderr);
+                        uc_run_cancel(run);
+                        return;
+                }
+        }
+
+        struct_run_free(run);
+}
+
+void uc_run_cancel(uc_run run) {
+        if (run == NULL) return;
+
+        if (!run->done) {
+                /* Tests running on threads cannot be stopped. */
+                join_segment(run);
+
+                for (unsigned int i = 0; i < run->num_slots; ++i) {
+                        struct slot *slot = &run->slots[i];
+                        int wstatus;
+
+                        if (!slot_busy(slot)) continue;
+
+                        kill(slot->pid, SIGKILL);
+                        reap_test(run->suite, slot->pid, &wstatus, true);
+                        /* The test being run when cancelled failed to run. */
+                        if (slot->last != NULL && !slot->last_done) {
+                                clear_test_results(run->suite,
+                                                   slot->last->data);
+                        }
+                        close_slot(run, slot);
+
+                        if (slot->repeat_entry != NULL) {
+                                if (slot->last == NULL) {
+                                        clear_test_results(run->suite,
+                                                           &slot->scratch);
+                                }
+                                fold_run(run, slot->repeat_entry->data,
+                                         &slot->scratch, slot->iteration);
+                                slot->repeat_entry = NULL;
+                        }
+                }
+
+                run->next = NULL;
+                finish_run(run);
+        }
+
+        struct_run_free(run);
+}
+
+void fill_slots(uc_run run) {
+        uc_suite suite = run->suite;
+
+        for (unsigned int i = 0; i < run->num_slots && run->next != NULL;) {
+                struct slot *slot = &run->slots[i];
+                struct test *test = run->next->data;
+                GList *entry = run->next;
+                unsigned int length;
+
+                if (slot_busy(slot)) {
+                        ++i;
+                        continue;
+                }
+
+                /* Another run frees a process for this one. */
+                if (pool_full(run->pool)) return;
+
+                if (test->group != run->prev_group) {
+                        /* Group fixtures run while none of its tests do. */
+                        if (run_busy(run)) return;
+
+                        /* The zygote runs group fixtures itself. */
+                        if (suite->zygote == -1 && run->prev_group != NULL) {
+                                run_parent_hook(suite,
+                                                run->prev_group->teardown);
+                        }
+
+                        if (suite->zygote == -1 && test->group != NULL) {
+                                run_parent_hook(suite, test->group->setup);
+                        }
+
+                        run->prev_group = test->group;
+                }
+
+                if (repeating(suite)) {
+                        if (repeat_done(run)) {
+                                /* The next test starts once all runs of this
+                                 * one have finished.
+                                 */
+                                if (run_busy(run)) return;
+
+                                if (run->trace != NULL) {
+                                        trace_kept_run(run, run->next->data);
+                                }
+                                run->next = run->next->prev;
+                                run->iteration = 0;
+                                run->repeat_stop = false;
+                                continue;
+                        }
+
+                        if (run->iteration == 0) {
+                                clock_gettime(CLOCK_MONOTONIC,
+                                              &run->repeat_start);
+                        }
+                        start_iteration(run, slot, entry, ++run->iteration);
+                        continue;
+                }
+
+                entry = next_startable(run, &length);
+                if (entry == NULL && !run_busy(run) && pool_idle(run->pool) &&
+                    !((struct test *)run->next->data)->started) {
+                        char buf[32];
+
+                        /* Its prerequisites come after it, in a group
+                         * which can't start first.
+                         */
+                        fprintf(stderr, "uc_run_tests: cannot run %s after "
+                                "its prerequisites.\n",
+                                test_key(run->next->data, buf));
+                        pass_over_test(run->next->data, true);
+                }
+
+                if (entry != NULL) {
+                        test = entry->data;
+                        if (start_batch(run, slot, entry, length)) {
+                                if (test_constrained(test)) {
+                                        claim_resources(run, slot, test);
+                                }
+                                for (GList *curr = entry; length > 0;
+                                     curr = curr->prev, --length) {
+                                        ((struct test *)curr->data)->started =
+                                                true;
+                                }
+                        } else {
+                                /* Skip the test, not the whole batch. */
+                                pass_over_test(test, false);
+                        }
+                }
+
+                /* Tests may have been started or passed over out of
+                 * order.
+                 */
+                while (run->next != NULL &&
+                       ((struct test *)run->next->data)->started) {
+                        run->next = run->next->prev;
+                }
+                if (entry == NULL && run->next != NULL &&
+                    ((struct test *)run->next->data)->group == test->group) {
+                        return;
+                }
+        }
+}
+
+GList *next_startable(uc_run run, unsigned int *length) {
+        uc_suite suite = run->suite;
+        struct process_pool *pool = run->pool;
+        struct group *group = ((struct test *)run->next->data)->group;
+        GList *found = NULL;
+
+        /* A test running alone holds all of the run, and of its pool. */
+        if (run->alone) return NULL;
+        if (pool != NULL && pool->alone != NULL && pool->alone != run) {
+                return NULL;
+        }
+
+        for (GList *entry = run->next; entry != NULL; entry = entry->prev) {
+                struct test *test = entry->data;
+
+                if (test->group != group) break;
+                if (test->started || !prerequisites_finished(test)) continue;
+
+                if (test->blocked_by != NULL) {
+                        pass_over_test(test, true);
+                        continue;
+                }
+
+                /* Started once the run (and its pool) is empty. Until then,
+                 * later tests start unless it is the first test left, which
+                 * none start ahead of.
+                 */
+                if (test->alone && alone_waits(run)) {
+                        if (entry != run->next) continue;
+                        if (pool != NULL) pool->alone = run;
+                        return NULL;
+                }
+                if (!resources_free(test)) continue;
+
+                *length = test_constrained(test) ? 1 :
+                                                   batch_length(suite, entry);
+                found = entry;
+                break;
+        }
+
+        /* The test the pool waited to empty for starts or was passed over. */
+        if (pool != NULL && pool->alone == run) {
+                pool->alone = NULL;
+                ++pool->changes;
+        }
+
+        return found;
+}
+
+bool test_constrained(const struct test *test) {
+        return test->uses != NULL || test->prerequisites != NULL ||
+               test->alone;
+}
+
+bool prerequisites_finished(struct test *test) {
+        for (GList *curr = test->prerequisites; curr != NULL;
+             curr = curr->next) {
+                struct test *prerequisite = curr->data;
+
+                /* Left out of the run by uc_select_tests. */
+                if (prerequisite->skipped) continue;
+                if (!prerequisite->finished) return false;
+
+                if (!test_passed(prerequisite) && test->blocked_by == NULL) {
+                        test->blocked_by = prerequisite;
+                }
+        }
+
+        return true;
+}
+
+bool resources_free(const struct test *test) {
+        for (GList *curr = test->uses; curr != NULL; curr = curr->next) {
+                struct resource_use *use = curr->data;
+                struct resource *resource = held_resource(use->resource);
+
+                if (resource->in_use + use->units > resource->capacity) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+struct resource *held_resource(struct resource *resource) {
+        return resource->pooled != NULL ? resource->pooled : resource;
+}
+
+struct resource *pool_resource(struct process_pool *pool,
+                               const struct resource *resource) {
+        struct resource *pooled;
+
+        for (GList *curr = pool->resources; curr != NULL; curr = curr->next) {
+                pooled = curr->data;
+                if (strcmp(pooled->name, resource->name) != 0) continue;
+
+                if (resource->capacity < pooled->capacity) {
+                        pooled->capacity = resource->capacity;
+                }
+                return pooled;
+        }
+
+        pooled = malloc(sizeof(struct resource));
+        if (pooled == NULL) return NULL;
+
+        ALLOC_STRING(resource->name, pooled->name,
+                     { free(pooled); return NULL; });
+        pooled->capacity = resource->capacity;
+        pooled->in_use = 0;
+        pooled->pooled = NULL;
+        pool->resources = g_list_prepend(pool->resources, pooled);
+
+        return pooled;
+}
+
+void claim_resources(uc_run run, struct slot *slot, struct test *test) {
+        for (GList *curr = test->uses; curr != NULL; curr = curr->next) {
+                struct resource_use *use = curr->data;
+
+                held_resource(use->resource)->in_use += use->units;
+        }
+
+        if (test->alone) {
+                run->alone = true;
+                if (run->pool != NULL) run->pool->alone = run;
+        }
+        slot->claimed = test;
+}
+
+void release_resources(uc_run run, struct slot *slot) {
+        struct test *test = slot->claimed;
+
+        if (test == NULL) return;
+
+        for (GList *curr = test->uses; curr != NULL; curr = curr->next) {
+                struct resource_use *use = curr->data;
+
+                held_resource(use->resource)->in_use -= use->units;
+        }
+
+        if (test->alone) {
+                run->alone = false;
+                if (run->pool != NULL) run->pool->alone = NULL;
+        }
+        slot->claimed = NULL;
+}
+
+void pass_over_test(struct test *test, const bool run_failed) {
+        test->started = true;
+        test->finished = true;
+        if (run_failed) test->run_failed = true;
+}
+
+struct resource *find_resource(uc_suite suite, const char *name) {
+        struct resource *resource;
+
+        for (GList *curr = suite->resources; curr != NULL;
+             curr = curr->next) {
+                resource = curr->data;
+                if (strcmp(resource->name, name) == 0) return resource;
+        }
+
+        resource = malloc(sizeof(struct resource));
+        if (resource == NULL) return NULL;
+
+        ALLOC_STRING(name, resource->name, { free(resource); return NULL; });
+        resource->capacity = 1;
+        resource->in_use = 0;
+        resource->pooled = NULL;
+        suite->resources = g_list_prepend(suite->resources, resource);
+
+        return resource;
+}
+
+void struct_resource_free(void *data) {
+        struct resource *resource = data;
+
+        free(resource->name);
+        free(resource);
+}
+
+bool start_batch(uc_run run, struct slot *slot, GList *entry,
+                 const unsigned int length) {
+        uc_suite suite = run->suite;
+        int ipc_pipe[2], output_pipe[2] = { -1, -1 };
+        struct epoll_event event;
+        struct test_fds fds;
+        uint64_t spawn_start = 0;
+
+        if (pipe(ipc_pipe) == -1) {
+                fputs("uc_run_tests: cannot create pipe,"
+                      "not running test.\n", stderr);
+                return false;
+        }
+
+        if (suite->options & UC_OPT_CAPTURE_OUTPUT &&
+            pipe(output_pipe) == -1) {
+                fputs("uc_run_tests: cannot create pipe, not "
+                      "capturing output.\n", stderr);
+                output_pipe[R] = output_pipe[WR] = -1;
+        }
+
+        fds.results = ipc_pipe[WR];
+        fds.output = output_pipe[WR];
+
+        if (run->trace != NULL) spawn_start = monotonic_ns();
+        if (!spawn_test(suite, entry, length, slot - run->slots, &fds,
+                        &slot->pid)) {
+                fputs("uc_run_tests: cannot create process.\n", stderr);
+                close(ipc_pipe[R]);
+                close(ipc_pipe[WR]);
+                if (output_pipe[R] != -1) {
+                        close(output_pipe[R]);
+                        close(output_pipe[WR]);
+                }
+                slot->pid = -1;
+                return false;
+        }
+
+        /* Close the write ends so a test process which dies early is seen
+         * as end of file.
+         */
+        if (close(ipc_pipe[WR]) == -1) {
+                fputs("uc_run_tests: cannot close write end of pipe.\n",
+                      stderr);
+        }
+        if (output_pipe[WR] != -1) close(output_pipe[WR]);
+
+        slot->results_fd = ipc_pipe[R];
+        slot->output_fd = output_pipe[R];
+        if (run->pool != NULL) ++run->pool->busy;
+        if (run->trace != NULL) {
+                char args[32];
+
+                snprintf(args, sizeof(args), "\"tests\":%u", length);
+                trace_span(run, slot, false, "Spawn", spawn_start,
+                           monotonic_ns(), args);
+                trace_counter(run, "In-flight children", "children",
+                              ++run->trace_children);
+        }
+        slot->next = entry;
+        slot->remaining = length;
+        slot->last = NULL;
+        slot->last_done = true;
+        slot->invalid = false;
+
+        /* Read as the test process writes: it blocks once a pipe is full. */
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = slot;
+        fcntl(slot->results_fd, F_SETFL, O_NONBLOCK);
+        epoll_ctl(run->poll_fd, EPOLL_CTL_ADD, slot->results_fd, &event);
+        if (slot->output_fd != -1) {
+                fcntl(slot->output_fd, F_SETFL, O_NONBLOCK);
+                epoll_ctl(run->poll_fd, EPOLL_CTL_ADD, slot->output_fd,
+                          &event);
+        }
+
+        return true;
+}
+
+void service_slot(uc_run run, struct slot *slot) {
+        size_t len = slot->results.len;
+        bool open;
+
+        if (slot->reaping) {
+                reap_slot(run, slot);
+                return;
+        }
+
+        /* A test's output is written before its results. */
+        drain_output(run, slot);
+        open = fill_results(&slot->results, slot->results_fd);
+        if (run->trace != NULL && slot->results.len > len) {
+                run->trace_bytes += slot->results.len - len;
+                trace_counter(run, "Bytes received", "bytes",
+                              run->trace_bytes);
+        }
+        parse_results(run, slot);
+
+        if (!open || slot->invalid) finish_slot(run, slot, slot->invalid);
+}
+
+void parse_results(uc_run run, struct slot *slot) {
+        uc_suite suite = run->suite;
+        struct results_buf *buf = &slot->results;
+
+        while (!slot->invalid) {
+                enum results_status status;
+                size_t start;
+
+                if (slot->last_done) {
+                        char start_char;
+
+                        if (slot->remaining == 0 ||
+                            !take_results(buf, &start_char, sizeof(char))) {
+                                break;
+                        }
+
+                        if (start_char == '\0') {
+                                slot->invalid = true;
+                                break;
+                        }
+
+                        /* The process moved on: nothing can change the
+                         * results of its last test now.
+                         */
+                        if (slot->last != NULL) {
+                                ((struct test *)slot->last->data)->finished =
+                                        true;
+                        }
+                        slot->last = slot->next;
+                        slot->last_done = false;
+                        slot->next = slot->next->prev;
+                        --slot->remaining;
+                        ((struct test *)slot->last->data)->owner =
+                                pthread_self();
+                }
+
+                /* Only record results once they have all arrived. */
+                suite->curr_test = slot->last;
+                start = buf->pos;
+                status = read_test_results(suite, buf, true);
+                buf->pos = start;
+                if (status == RESULTS_OK) {
+                        status = read_test_results(suite, buf, false);
+                }
+                suite->curr_test = g_list_last(suite->tests);
+
+                if (status == RESULTS_INCOMPLETE) break;
+                if (status == RESULTS_INVALID) {
+                        slot->invalid = true;
+                        break;
+                }
+
+                slot->last_done = true;
+                attach_output(run, slot, slot->last->data);
+                if (run->trace != NULL) {
+                        trace_test(run, slot, slot->last->data,
+                                   buf->pos - start);
+                }
+        }
+
+        /* Keep only what is left to parse. */
+        if (buf->pos > 0) {
+                memmove(buf->data, buf->data + buf->pos, buf->len - buf->pos);
+                buf->len -= buf->pos;
+                buf->pos = 0;
+        }
+}
+
+void finish_slot(uc_run run, struct slot *slot, const bool kill_first) {
+        if (kill_first) kill(slot->pid, SIGKILL);
+
+        slot->reap_entry = slot->last;
+        slot->reap_read_ok = slot->last != NULL && slot->last_done &&
+                             !slot->invalid;
+        /* Nothing started: don't retry the same test forever. */
+        if (slot->reap_entry == NULL) {
+                slot->reap_entry = slot->next;
+                slot->next = slot->next->prev;
+                --slot->remaining;
+        }
+
+        /* The process may still be exiting, e.g. running atexit handlers. */
+        slot->reaping = true;
+        slot->reap_start = run->trace != NULL ? monotonic_ns() : 0;
+        close_slot_fds(run, slot);
+        reap_slot(run, slot);
+}
+
+void reap_slot(uc_run run, struct slot *slot) {
+        uc_suite suite = run->suite;
+        struct test *test = slot->reap_entry->data;
+        enum reap_status status;
+        int wstatus = 0;
+
+        status = reap_test(suite, slot->pid, &wstatus, false);
+        if (status == REAP_PENDING && suite->zygote == -1 &&
+            slot->pid_fd == -1) {
+                struct epoll_event event;
+
+#ifdef SYS_pidfd_open
+                slot->pid_fd = syscall(SYS_pidfd_open, slot->pid, 0);
+#endif
+                memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN;
+                event.data.ptr = slot;
+                /* Without a pidfd to be woken by, wait for the exit. */
+                if (slot->pid_fd == -1 ||
+                    epoll_ctl(run->poll_fd, EPOLL_CTL_ADD, slot->pid_fd,
+                              &event) == -1) {
+                        status = reap_test(suite, slot->pid, &wstatus, true);
+                }
+        }
+        if (status == REAP_PENDING) return;
+
+        slot->reaping = false;
+        if (run->trace != NULL) {
+                trace_span(run, slot, false, "Reap", slot->reap_start,
+                           monotonic_ns(), NULL);
+        }
+
+        if (status == REAP_FAILED) {
+                fputs("uc_run_tests: error creating process.\n", stderr);
+                clear_test_results(suite, test);
+        } else if (slot->reap_read_ok && test->crash != NULL) {
+                /* The test sent all it had before crashing. */
+                fprintf(stderr, "uc_run_tests: test crashed: %s.\n",
+                        strsignal(test->crash->signal));
+                for (int i = 0; i < test->crash->num_frames; ++i) {
+                        fprintf(stderr, "%s%s\n", INDENTATION,
+                                test->crash->backtrace[i]);
+                }
+                test->run_failed = true;
+        } else if (WIFSIGNALED(wstatus) || !slot->reap_read_ok) {
+                /* Information may be incomplete. Delete it all. */
+                fputs("uc_run_tests: test failed to run.\n", stderr);
+                clear_test_results(suite, test);
+        }
+
+        /* What the failed test wrote last is most useful. */
+        if (test->run_failed) attach_output(run, slot, test);
+        test->finished = true;
+        close_slot(run, slot);
+
+        if (slot->repeat_entry != NULL) {
+                fold_run(run, slot->repeat_entry->data, &slot->scratch,
+                         slot->iteration);
+                slot->repeat_entry = NULL;
+        }
+
+        /* The rest of the batch is run by a new process. */
+        while (slot->remaining > 0) {
+                GList *next = slot->next;
+                unsigned int remaining = slot->remaining;
+
+                if (start_batch(run, slot, next, remaining)) break;
+
+                slot->next = next->prev;
+                slot->remaining = remaining - 1;
+        }
+}
+
+void close_slot_fds(uc_run run, struct slot *slot) {
+        if (slot->results_fd != -1) {
+                epoll_ctl(run->poll_fd, EPOLL_CTL_DEL, slot->results_fd,
+                          NULL);
+                if (close(slot->results_fd) == -1) {
+                        fputs("uc_run_tests: cannot close read end of "
+                              "pipe.\n", stderr);
+                }
+        }
+
+        if (slot->output_fd != -1) {
+                epoll_ctl(run->poll_fd, EPOLL_CTL_DEL, slot->output_fd, NULL);
+                close(slot->output_fd);
+        }
+
+        if (slot->pid_fd != -1) {
+                epoll_ctl(run->poll_fd, EPOLL_CTL_DEL, slot->pid_fd, NULL);
+                close(slot->pid_fd);
+        }
+
+        slot->results_fd = -1;
+        slot->output_fd = -1;
+        slot->pid_fd = -1;
+}
+
+void close_slot(uc_run run, struct slot *slot) {
+        close_slot_fds(run, slot);
+
+        if (run->pool != NULL) {
+                --run->pool->busy;
+                ++run->pool->changes;
+        }
+        release_resources(run, slot);
+        if (run->trace != NULL) {
+                trace_counter(run, "In-flight children", "children",
+                              --run->trace_children);
+        }
+
+        slot->pid = -1;
+        slot->reaping = false;
+        slot->results.len = 0;
+        slot->results.pos = 0;
+        /* Ids are only meaningful to the process which gave them. */
+        if (slot->results.comments != NULL) {
+                g_ptr_array_free(slot->results.comments, TRUE);
+                slot->results.comments = NULL;
+        }
+        slot->output_ring.start = 0;
+        slot->output_ring.len = 0;
+        slot->output_ring.dropped = 0;
+}
+
+bool slot_busy(const struct slot *slot) {
+        return slot->pid != -1;
+}
+
+bool run_busy(uc_run run) {
+        if (run->segment_running) return true;
+
+        for (unsigned int i = 0; i < run->num_slots; ++i) {
+                if (slot_busy(&run->slots[i])) return true;
+        }
+
+        return false;
+}
+
+void finish_run(uc_run run) {
+        uc_suite suite = run->suite;
+
+        if (suite->zygote != -1) {
+                stop_zygote(suite);
+        } else if (run->prev_group != NULL) {
+                run_parent_hook(suite, run->prev_group->teardown);
+        }
+
+        run_parent_hook(suite, suite->teardown);
+
+        if (suite->coverage_dir != NULL) update_coverage_map(suite);
+        if (suite->profile_dir != NULL) write_profiles(suite);
+        if (run->all_tests != NULL) {
+                g_list_free(suite->tests);
+                suite->tests = run->all_tests;
+                run->all_tests = NULL;
+        }
+
+        /* Reset curr_test to account for "dangling checks". */
+        suite->curr_test = g_list_last(suite->tests);
+        if (run->trace != NULL) finish_trace(run);
+        if (run->pool != NULL && run->pool->alone == run) {
+                run->pool->alone = NULL;
+                ++run->pool->changes;
+        }
+        run->done = true;
+}
+
+bool pool_full(const struct process_pool *pool) {
+        return pool != NULL && pool->busy >= pool->size;
+}
+
+bool pool_idle(const struct process_pool *pool) {
+        return pool == NULL || (pool->busy == 0 && pool->alone == NULL);
+}
+
+bool alone_waits(uc_run run) {
+        return run_busy(run) || (run->pool != NULL && run->pool->busy > 0);
+}
+
+void start_trace(uc_run run) {
+        uc_suite suite = run->suite;
+
+        run->trace = fopen(suite->trace_path, "w");
+        if (run->trace == NULL) {
+                fputs("uc_run_tests: cannot open trace.\n", stderr);
+                return;
+        }
+
+        run->trace_start = monotonic_ns();
+        run->trace_pid = getpid();
+        for (unsigned int i = 0; i < run->num_slots; ++i) {
+                run->slots[i].trace_ends[0] = run->trace_start;
+                run->slots[i].trace_ends[1] = run->trace_start;
+        }
+        run->trace_children = 0;
+        run->trace_bytes = 0;
+
+        /* Trace event format, as read by chrome://tracing and Perfetto. */
+        fprintf(run->trace, "{\"traceEvents\":[\n{\"name\":\"process_name\","
+                "\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":",
+                (int)run->trace_pid);
+        output_json_string(run->trace,
+                           suite->name != NULL ? suite->name :
+                                                 DEFAULT_SUITE_NAME);
+        fputs("}}", run->trace);
+
+        /* Lanes are numbered from 1, results lanes after the others. */
+        for (unsigned int i = 0; i < run->num_slots * 2; ++i) {
+                unsigned int slot = i % run->num_slots + 1;
+
+                fprintf(run->trace, ",\n{\"name\":\"thread_name\","
+                        "\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                        "\"args\":{\"name\":\"Slot %u%s\"}}",
+                        (int)run->trace_pid, i + 1, slot,
+                        i < run->num_slots ? "" : " results");
+                fprintf(run->trace, ",\n{\"name\":\"thread_sort_index\","
+                        "\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                        "\"args\":{\"sort_index\":%u}}",
+                        (int)run->trace_pid, i + 1,
+                        slot * 2 + (i < run->num_slots ? 0 : 1));
+        }
+}
+
+void finish_trace(uc_run run) {
+        fputs("\n]}\n", run->trace);
+        if (fclose(run->trace) != 0) {
+                fputs("uc_run_tests: cannot write trace.\n", stderr);
+        }
+        run->trace = NULL;
+}
+
+void trace_span(uc_run run, struct slot *slot, const bool results,
+                const char *name, uint64_t start, uint64_t end,
+                const char *args) {
+        unsigned int lane = slot - run->slots + 1;
+        double ts, dur;
+
+        if (start < slot->trace_ends[results]) {
+                start = slot->trace_ends[results];
+        }
+        if (end < start) end = start;
+        slot->trace_ends[results] = end;
+        ts = (start - run->trace_start) / 1e3;
+        dur = (end - start) / 1e3;
+
+        fputs(",\n{\"name\":", run->trace);
+        output_json_string(run->trace, name);
+        fprintf(run->trace, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f", (int)run->trace_pid,
+                results ? lane + run->num_slots : lane, ts, dur);
+        if (args != NULL) fprintf(run->trace, ",\"args\":{%s}", args);
+        fputc('}', run->trace);
+}
+
+void trace_counter(uc_run run, const char *name, const char *series,
+                   const unsigned long long value) {
+        uint64_t now = monotonic_ns();
+
+        fprintf(run->trace, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":%d,"
+                "\"ts\":%.3f,\"args\":{\"%s\":%llu}}", name,
+                (int)run->trace_pid, (now - run->trace_start) / 1e3, series,
+                value);
+}
+
+void trace_test(uc_run run, struct slot *slot, const struct test *test,
+                const size_t bytes) {
+        /* A repeated test's runs are read into the slot's scratch test. */
+        const struct test *named = slot->repeat_entry != NULL ?
+                                   slot->repeat_entry->data : test;
+        char args[64], buf[32];
+
+        if (!test->has_span) return;
+
+        snprintf(args, sizeof(args), "\"checks\":%u,\"passed\":%u",
+                 test->num_checks, test->num_succ);
+        trace_span(run, slot, false, test_key(named, buf),
+                   test->span.start, test->span.end, args);
+
+        snprintf(args, sizeof(args), "\"bytes\":%zu", bytes);
+        trace_span(run, slot, true, "Transfer", test->span.end,
+                   monotonic_ns(), args);
+}
+
+void trace_kept_run(uc_run run, const struct test *test) {
+        char buf[32];
+
+        if (!test->has_span || !test->has_repeat) return;
+
+        fputs(",\n{\"name\":", run->trace);
+        output_json_string(run->trace, test_key(test, buf));
+        fprintf(run->trace, ",\"ph\":\"i\",\"s\":\"p\",\"pid\":%d,"
+                "\"tid\":0,\"ts\":%.3f,\"args\":{\"kept_run\":%u,"
+                "\"checks\":%u,\"passed\":%u}}", (int)run->trace_pid,
+                (test->span.end - run->trace_start) / 1e3,
+                test->repeat.kept_run, test->num_checks, test->num_succ);
+}
+
+void output_json_string(FILE *out, const char *string) {
+        fputc('"', out);
+        for (const char *c = string; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                        fprintf(out, "\\%c", *c);
+                } else if ((unsigned char)*c < 0x20) {
+                        fprintf(out, "\\u%04x", (unsigned int)*c);
+                } else {
+                        fputc(*c, out);
+                }
+        }
+        fputc('"', out);
+}
+
+uint64_t monotonic_ns(void) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void struct_run_free(uc_run run) {
+        if (run->slots != NULL) {
+                for (unsigned int i = 0; i < run->num_slots; ++i) {
+                        struct slot *slot = &run->slots[i];
+
+                        if (slot->output_ring.data != NULL) {
+                                free(slot->output_ring.data);
+                        }
+                        if (slot->results.data != NULL) {
+                                free(slot->results.data);
+                        }
+                }
+                free(run->slots);
+        }
+
+        if (run->event_fd != -1) close(run->event_fd);
+        if (run->poll_fd != -1) close(run->poll_fd);
+
+        free(run);
+}
+
+bool repeating(uc_suite suite) {
+        return !(suite->options & UC_OPT_THREADS) &&
+               (suite->repeat_times != 1 || suite->repeat_seconds > 0);
+}
+
+bool repeat_done(uc_run run) {
+        uc_suite suite = run->suite;
+        struct timespec now;
+
+        if (run->repeat_stop) return true;
+        if (suite->repeat_times != 0 &&
+            run->iteration >= suite->repeat_times) {
+                return true;
+        }
+        if (suite->repeat_seconds <= 0 || run->iteration == 0) return false;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return seconds_between(&run->repeat_start, &now) >=
+               suite->repeat_seconds;
+}
+
+void start_iteration(uc_run run, struct slot *slot, GList *entry,
+                     const unsigned int iteration) {
+        init_run_test(&slot->scratch, entry->data);
+
+        if (!start_batch(run, slot, entry, 1)) {
+                clear_test_results(run->suite, &slot->scratch);
+                fold_run(run, entry->data, &slot->scratch, iteration);
+                return;
+        }
+
+        /* Results are read into scratch, not the test itself. */
+        slot->repeat_entry = entry;
+        slot->iteration = iteration;
+        slot->scratch_entry.data = &slot->scratch;
+        slot->scratch_entry.next = NULL;
+        slot->scratch_entry.prev = NULL;
+        slot->next = &slot->scratch_entry;
+}
+
+void init_test(struct test *test, void (*test_func)(uc_suite),
+               const unsigned int test_num, struct group *group) {
+        test->test_func = test_func;
+        test->num_succ = 0;
+        test->num_checks = 0;
+        test->test_num = test_num;
+        test->group = group;
+        test->checks = NULL;
+        test->output = NULL;
+        test->output_len = 0;
+        test->output_dropped = 0;
+        test->run_failed = false;
+        test->crash = NULL;
+        test->has_heap = false;
+        test->has_perf = false;
+        test->has_placement = false;
+        test->has_run_time = false;
+        test->has_span = false;
+        test->profile = NULL;
+        test->profile_len = 0;
+        test->profiled = false;
+        test->has_repeat = false;
+        test->described = false;
+        test->fuzz = NULL;
+        test->load = NULL;
+        test->has_load = false;
+        test->skipped = false;
+        test->uses = NULL;
+        test->prerequisites = NULL;
+        test->alone = false;
+        test->started = false;
+        test->finished = false;
+        test->blocked_by = NULL;
+        test->owner = pthread_self();
+        pthread_mutex_init(&test->buffers_lock, NULL);
+        test->buffers = NULL;
+        test->buffers_gen = ATOMIC_ADD(buffers_gen_counter, 1) + 1;
+}
+
+int compare_described_tests(const void *a, const void *b) {
+        const struct uc_test_desc *desc_a = ((struct described_test *)a)->desc;
+        const struct uc_test_desc *desc_b = ((struct described_test *)b)->desc;
+        int files = strcmp(desc_a->file, desc_b->file);
+
+        if (files != 0) return files;
+        return (desc_a->line > desc_b->line) - (desc_a->line < desc_b->line);
+}
+
+void init_run_test(struct test *run_test, const struct test *test) {
+        init_test(run_test, test->test_func, test->test_num, test->group);
+        run_test->name = test->name;
+        run_test->comment = test->comment;
+        run_test->fuzz = test->fuzz;
+        run_test->load = test->load;
+}
+
+void fold_run(uc_run run, struct test *test, struct test *run_test,
+              const unsigned int iteration) {
+        uc_suite suite = run->suite;
+        struct repeat_stats *stats = &test->repeat;
+        bool failed = run_test->run_failed ||
+                      run_test->num_succ != run_test->num_checks;
+        bool kept_failed = test->run_failed ||
+                           test->num_succ != test->num_checks;
+
+        if (!test->has_repeat) {
+                memset(stats, 0, sizeof(struct repeat_stats));
+                test->has_repeat = true;
+        }
+
+        ++stats->runs;
+        stats->num_checks += run_test->num_checks;
+        stats->num_succ += run_test->num_succ;
+        if (!failed) {
+                ++stats->passed;
+        } else if (stats->first_failure == 0 ||
+                   iteration < stats->first_failure) {
+                stats->first_failure = iteration;
+        }
+
+        if (run_test->has_run_time) {
+                if (stats->timed_runs == 0 ||
+                    run_test->run_time < stats->min_time) {
+                        stats->min_time = run_test->run_time;
+                }
+                if (run_test->run_time > stats->max_time) {
+                        stats->max_time = run_test->run_time;
+                }
+                stats->total_time += run_test->run_time;
+                ++stats->timed_runs;
+        }
+
+        if (stats->kept_run == 0 ||
+            (failed != kept_failed ? failed : iteration < stats->kept_run)) {
+                swap_results(test, run_test);
+                stats->kept_run = iteration;
+        }
+
+        if (failed && suite->options & UC_OPT_REPEAT_UNTIL_FAILURE) {
+                run->repeat_stop = true;
+        }
+
+        /* run_test now holds the results which are not kept. */
+        suite->num_checks -= run_test->num_checks;
+        suite->num_succ -= run_test->num_succ;
+        g_list_free_full(run_test->checks, &struct_check_free);
+        if (run_test->output != NULL) free(run_test->output);
+        if (run_test->crash != NULL) struct_crash_free(run_test->crash);
+        if (run_test->profile != NULL) free(run_test->profile);
+        pthread_mutex_destroy(&run_test->buffers_lock);
+}
+
+void swap_results(struct test *a, struct test *b) {
+        struct test tmp = *a;
+
+        a->checks = b->checks;
+        a->num_succ = b->num_succ;
+        a->num_checks = b->num_checks;
+        a->output = b->output;
+        a->output_len = b->output_len;
+        a->output_dropped = b->output_dropped;
+        a->run_failed = b->run_failed;
+        a->crash = b->crash;
+        a->heap = b->heap;
+        a->has_heap = b->has_heap;
+        a->perf = b->perf;
+        a->has_perf = b->has_perf;
+        a->placement = b->placement;
+        a->has_placement = b->has_placement;
+        a->run_time = b->run_time;
+        a->has_run_time = b->has_run_time;
+        a->span = b->span;
+        a->has_span = b->has_span;
+        a->profile = b->profile;
+        a->profile_len = b->profile_len;
+        a->load_stats = b->load_stats;
+        a->has_load = b->has_load;
+
+        b->checks = tmp.checks;
+        b->num_succ = tmp.num_succ;
+        b->num_checks = tmp.num_checks;
+        b->output = tmp.output;
+        b->output_len = tmp.output_len;
+        b->output_dropped = tmp.output_dropped;
+        b->run_failed = tmp.run_failed;
+        b->crash = tmp.crash;
+        b->heap = tmp.heap;
+        b->has_heap = tmp.has_heap;
+        b->perf = tmp.perf;
+        b->has_perf = tmp.has_perf;
+        b->placement = tmp.placement;
+        b->has_placement = tmp.has_placement;
+        b->run_time = tmp.run_time;
+        b->has_run_time = tmp.has_run_time;
+        b->span = tmp.span;
+        b->has_span = tmp.has_span;
+        b->profile = tmp.profile;
+        b->profile_len = tmp.profile_len;
+        b->load_stats = tmp.load_stats;
+        b->has_load = tmp.has_load;
+}
+
+double seconds_between(const struct timespec *start,
+                       const struct timespec *end) {
+        return (end->tv_sec - start->tv_sec) +
+               (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+GList *run_thread_segment(uc_suite suite, GList *entry) {
+        struct group *group = ((struct test *)entry->data)->group;
+        unsigned int num_workers = suite->jobs;
+        unsigned int num_tests = 0;
+        GList **entries;
+        GList *next;
+
+        if (num_workers == 0) {
+                long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                num_workers = num_cpus > 0 ? num_cpus : 1;
+        }
+
+        /* Group fixtures are set up while all their tests run. */
+        for (next = entry; next != NULL; next = next->prev) {
+                if (((struct test *)next->data)->group != group) break;
+                ++num_tests;
+        }
+
+        entries = malloc(sizeof(GList *) * num_tests);
+        if (entries == NULL) {
+                fputs("uc_run_tests: cannot allocate thread pool, not "
+                      "running tests.\n", stderr);
+                return next;
+        }
+
+        for (unsigned int i = 0; i < num_tests; ++i) {
+                entries[i] = entry;
+                entry = entry->prev;
+        }
+
+        if (group != NULL) run_parent_hook(suite, group->setup);
+        run_thread_pool(suite, entries, num_tests,
+                        num_workers < num_tests ? num_workers : num_tests);
+        if (group != NULL) run_parent_hook(suite, group->teardown);
+
+        free(entries);
+
+        return next;
+}
+
+void *segment_main(void *arg) {
+        uc_run run = arg;
+
+        run->segment_next = run_thread_segment(run->suite, run->next);
+        __atomic_store_n(&run->segment_done, true, __ATOMIC_RELEASE);
+        eventfd_write(run->event_fd, 1);
+
+        return NULL;
+}
+
+void start_segment(uc_run run) {
+        run->segment_done = false;
+        if (pthread_create(&run->segment_thread, NULL, &segment_main,
+                           run) != 0) {
+                fputs("uc_run_tests: cannot create thread, running tests in "
+                      "the calling thread.\n", stderr);
+                run->next = run_thread_segment(run->suite, run->next);
+                return;
+        }
+
+        run->segment_running = true;
+}
+
+void join_segment(uc_run run) {
+        if (!run->segment_running) return;
+
+        pthread_join(run->segment_thread, NULL);
+        run->segment_running = false;
+        run->next = run->segment_next;
+}
+
+void run_thread_pool(uc_suite suite, GList **entries,
+                     const unsigned int num_tests,
+                     const unsigned int num_workers) {
+        struct thread_pool pool;
+        pthread_t threads[num_workers];
+        struct pool_worker workers[num_workers];
+        struct work_deque deques[num_workers];
+        /* The calling thread's own affinity, restored once done. */
+        cpu_set_t caller_cpus;
+        bool pinned = suite->num_cpus > 0 &&
+                      pthread_getaffinity_np(pthread_self(),
+                                             sizeof(caller_cpus),
+                                             &caller_cpus) == 0;
+
+        pool.suite = suite;
+        pool.deques = deques;
+        pool.num_workers = num_workers;
+
+        /* Give each worker an even, contiguous share of the tests. */
+        for (unsigned int i = 0; i < num_workers; ++i) {
+                pthread_mutex_init(&deques[i].lock, NULL);
+                deques[i].entries = entries;
+                deques[i].front = (unsigned long)num_tests * i / num_workers;
+                deques[i].back = (unsigned long)num_tests * (i + 1) /
+                                 num_workers;
+
+                workers[i].pool = &pool;
+                workers[i].id = i;
+                workers[i].cpu = pinned ? suite->cpus[i % suite->num_cpus] :
+                                          -1;
+        }
+
+        /* The calling thread is worker 0. A worker which cannot be started
+         * just leaves its tests to be stolen.
+         */
+        for (unsigned int i = 1; i < num_workers; ++i) {
+                if (pthread_create(&threads[i], NULL, &pool_worker_main,
+                                   &workers[i]) != 0) {
+                        fputs("uc_run_tests: cannot create thread.\n", stderr);
+                        workers[i].pool = NULL;
+                }
+        }
+
+        pool_worker_main(&workers[0]);
+
+        for (unsigned int i = 1; i < num_workers; ++i) {
+                if (workers[i].pool != NULL) pthread_join(threads[i], NULL);
+        }
+
+        if (pinned) {
+                pthread_setaffinity_np(pthread_self(), sizeof(caller_cpus),
+                                       &caller_cpus);
+        }
+
+        for (unsigned int i = 0; i < num_workers; ++i) {
+                pthread_mutex_destroy(&deques[i].lock);
+        }
+}
+
+void *pool_worker_main(void *arg) {
+        struct pool_worker *worker = arg;
+        struct thread_pool *pool = worker->pool;
+        uc_suite suite = pool->suite;
+        GList *entry;
+
+        thread_suite = suite;
+
+        if (worker->cpu != -1) {
+                cpu_set_t set;
+
+                CPU_ZERO(&set);
+                CPU_SET(worker->cpu, &set);
+                if (pthread_setaffinity_np(pthread_self(), sizeof(set),
+                                           &set) != 0) {
+                        fprintf(stderr, "uc_run_tests: cannot pin thread to "
+                                "CPU %d.\n", worker->cpu);
+                        worker->cpu = -1;
+                }
+        }
+
+        while ((entry = take_test(pool, worker->id)) != NULL) {
+                struct test *test = entry->data;
+
+                thread_test = entry;
+                test->owner = pthread_self();
+                if (worker->cpu != -1) {
+                        test->placement.cpu = worker->cpu;
+                        test->placement.policy = -1;
+                        test->placement.priority = 0;
+                        test->has_placement = true;
+                }
+
+                if (suite->test_setup != NULL) suite->test_setup(suite);
+                if (test->test_func != NULL) test->test_func(suite);
+                if (suite->test_teardown != NULL) suite->test_teardown(suite);
+
+                merge_check_buffers(test);
+
+                /* uc_check only counts towards the test in the pool. */
+                ATOMIC_ADD(suite->num_checks, test->num_checks);
+                ATOMIC_ADD(suite->num_succ, test->num_succ);
+        }
+
+        thread_suite = NULL;
+        thread_test = NULL;
+
+        return NULL;
+}
+
+GList *take_test(struct thread_pool *pool, const unsigned int id) {
+        GList *entry = NULL;
+
+        /* Own tests are taken in order from the front... */
+        pthread_mutex_lock(&pool->deques[id].lock);
+        if (pool->deques[id].front < pool->deques[id].back) {
+                entry = pool->deques[id].entries[pool->deques[id].front++];
+        }
+        pthread_mutex_unlock(&pool->deques[id].lock);
+
+        /* ...and others' stolen from the back. Nothing adds tests, so once
+         * every deque is empty the worker is done.
+         */
+        for (unsigned int i = 1; entry == NULL && i < pool->num_workers; ++i) {
+                struct work_deque *victim;
+
+                victim = &pool->deques[(id + i) % pool->num_workers];
+                pthread_mutex_lock(&victim->lock);
+                if (victim->front < victim->back) {
+                        entry = victim->entries[--victim->back];
+                }
+                pthread_mutex_unlock(&victim->lock);
+        }
+
+        return entry;
+}
+
+bool uc_all_tests_passed(uc_suite suite) {
+        if (suite == NULL) return false;
+
+        for (GList *curr = suite->tests; curr != NULL; curr = curr->next) {
+                if (!test_passed(curr->data)) return false;
+        }
+
+        return true;
+}
+
+bool test_passed(const struct test *test) {
+        return test->num_succ == test->num_checks && !test->run_failed;
+}
+
+void uc_watch(uc_suite suite, void (*report)(uc_suite),
+              const char *const *paths, const size_t num_paths) {
+        const char *state_env = getenv("UC_WATCH_FD");
+        char exe[PATH_MAX];
+        char **argv;
+        struct watched_path *watched;
+        size_t num_watched = 0;
+        GHashTable *state;
+        GList *tests;
+        ssize_t exe_len;
+        int inotify_fd, state_fd = -1;
+        bool watching;
+
+        if (suite == NULL) return;
+
+        /* Read first, /proc/self/exe is marked deleted once rebuilt. */
+        exe_len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        argv = read_cmdline();
+        inotify_fd = inotify_init1(IN_CLOEXEC);
+        watched = malloc(sizeof(struct watched_path) * (num_paths + 1));
+        watching = exe_len != -1 && argv != NULL && inotify_fd != -1 &&
+                   watched != NULL;
+
+        if (watching) {
+                exe[exe_len] = '\0';
+                watching = add_watch(inotify_fd, exe, &watched[num_watched++]);
+        }
+        for (size_t i = 0; watching && i < num_paths; ++i) {
+                watching = add_watch(inotify_fd, paths[i],
+                                     &watched[num_watched++]);
+        }
+
+        /* The state is kept in a file inherited across restarts. */
+        if (watching && state_env != NULL) state_fd = atoi(state_env);
+        if (watching && (state_fd <= STDERR_FILENO ||
+                         fcntl(state_fd, F_GETFD) == -1)) {
+                char env[32];
+
+                state_fd = memfd_create("uc_watch", 0);
+                sprintf(env, "%d", state_fd);
+                watching = state_fd != -1 && setenv("UC_WATCH_FD", env, 1) == 0;
+        }
+
+        if (!watching) {
+                fputs("uc_watch: cannot watch for changes.\n", stderr);
+        } else {
+                state = read_watch_state(state_fd);
+
+                /* Reordered for the run only, reports keep the order tests
+                 * were added in.
+                 */
+                tests = suite->tests;
+                suite->tests = failing_first(tests, state);
+                suite->curr_test = g_list_last(suite->tests);
+                uc_run_tests(suite);
+                g_list_free(suite->tests);
+                suite->tests = tests;
+                suite->curr_test = g_list_last(suite->tests);
+
+                if (report != NULL) report(suite);
+                output_watch_diff(suite, state);
+                write_watch_state(suite, state_fd);
+                g_hash_table_destroy(state);
+
+                puts("Watching for changes.");
+                fflush(stdout);
+
+                while (wait_for_change(inotify_fd, watched, num_watched)) {
+                        fflush(stdout);
+                        execv(exe, argv);
+                        /* e.g. the binary is missing after a failed build. */
+                        fputs("uc_watch: cannot restart, waiting for the next "
+                              "change.\n", stderr);
+                }
+                fputs("uc_watch: cannot wait for changes.\n", stderr);
+        }
+
+        for (size_t i = 0; i < num_watched; ++i) free(watched[i].name);
+        free(watched);
+        if (inotify_fd != -1) close(inotify_fd);
+        if (argv != NULL) free(argv[0]);
+        free(argv);
+}
+
+uc_registry uc_registry_init(void) {
+        uc_registry registry = malloc(sizeof(struct uc_registry));
+        if (registry == NULL) return NULL;
+
+        registry->suites = NULL;
+        registry->jobs = 0;
+
+        return registry;
+}
+
+void uc_registry_free(uc_registry registry) {
+        if (registry == NULL) return;
+
+        g_list_free_full(registry->suites, &struct_registry_entry_free);
+        free(registry);
+}
+
+void struct_registry_entry_free(void *data) {
+        struct registry_entry *entry = data;
+
+        g_list_free_full(entry->children, &struct_registry_entry_free);
+        uc_free(entry->suite);
+        free(entry);
+}
+
+bool uc_registry_add(uc_registry registry, uc_suite suite, uc_suite parent) {
+        struct registry_entry *entry, *parent_entry = NULL;
+
+        if (registry == NULL || suite == NULL) return false;
+        if (find_entry(registry->suites, suite) != NULL) return false;
+        if (parent != NULL) {
+                parent_entry = find_entry(registry->suites, parent);
+                if (parent_entry == NULL) return false;
+        }
+
+        entry = malloc(sizeof(struct registry_entry));
+        if (entry == NULL) return false;
+
+        entry->suite = suite;
+        entry->children = NULL;
+        if (parent_entry != NULL) {
+                parent_entry->children = g_list_prepend(parent_entry->children,
+                                                        entry);
+        } else {
+                registry->suites = g_list_prepend(registry->suites, entry);
+        }
+
+        return true;
+}
+
+struct registry_entry *find_entry(GList *entries, uc_suite suite) {
+        for (GList *curr = entries; curr != NULL; curr = curr->next) {
+                struct registry_entry *entry = curr->data;
+                struct registry_entry *found;
+
+                if (entry->suite == suite) return entry;
+
+                found = find_entry(entry->children, suite);
+                if (found != NULL) return found;
+        }
+
+        return NULL;
+}
+
+void uc_registry_set_jobs(uc_registry registry, const unsigned int jobs) {
+        if (registry == NULL) return;
+        registry->jobs = jobs;
+}
+
+void uc_registry_run(uc_registry registry) {
+        struct process_pool pool;
+        struct epoll_event events[16];
+        GList *suites, *runs = NULL;
+        int poll_fd;
+
+        if (registry == NULL) return;
+
+        pool.size = registry->jobs;
+        if (pool.size == 0) {
+                long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                pool.size = num_cpus > 0 ? num_cpus : 1;
+        }
+        pool.busy = 0;
+        pool.alone = NULL;
+        pool.resources = NULL;
+        pool.changes = 0;
+
+        poll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (poll_fd == -1) {
+                fputs("uc_registry_run: cannot start running tests.\n",
+                      stderr);
+                return;
+        }
+
+        /* Every suite is started, its processes come from the pool. */
+        suites = flatten_entries(registry->suites, NULL);
+        for (GList *curr = g_list_last(suites); curr != NULL;
+             curr = curr->prev) {
+                struct epoll_event event;
+                uc_run run = start_run(curr->data, &pool);
+
+                if (run == NULL) {
+                        fputs("uc_registry_run: cannot start running a "
+                              "suite.\n", stderr);
+                        continue;
+                }
+
+                memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN;
+                event.data.ptr = run;
+                epoll_ctl(poll_fd, EPOLL_CTL_ADD, run->poll_fd, &event);
+                runs = g_list_prepend(runs, run);
+        }
+        g_list_free(suites);
+
+        /* Stepped in the order suites were added in. */
+        while (runs != NULL) {
+                /* Changes of the pool when the first run left idle was. */
+                unsigned long changes = 0;
+                bool idle = false;
+
+                for (GList *curr = g_list_last(runs), *prev; curr != NULL;
+                     curr = prev) {
+                        uc_run run = curr->data;
+
+                        prev = curr->prev;
+                        if (uc_run_step(run)) {
+                                if (!idle && !run_busy(run)) {
+                                        idle = true;
+                                        changes = pool.changes;
+                                }
+                                continue;
+                        }
+
+                        epoll_ctl(poll_fd, EPOLL_CTL_DEL, run->poll_fd, NULL);
+                        struct_run_free(run);
+                        runs = g_list_delete_link(runs, curr);
+                }
+
+                /* Runs left waiting for a process, resource or the pool
+                 * to empty, given back later in the pass, go again.
+                 */
+                if (runs == NULL || (idle && pool.changes != changes)) {
+                        continue;
+                }
+
+                if (epoll_wait(poll_fd, events, 16, -1) == -1 &&
+                    errno != EINTR) {
+                        fputs("uc_registry_run: cannot wait for tests.\n",
+                              stderr);
+                        for (GList *curr = runs; curr != NULL;
+                             curr = curr->next) {
+                                uc_run_cancel(curr->data);
+                        }
+                        g_list_free(runs);
+                        runs = NULL;
+                }
+        }
+
+        g_list_free_full(pool.resources, &struct_resource_free);
+        close(poll_fd);
+}
+
+GList *flatten_entries(GList *entries, GList *suites) {
+        for (GList *curr = g_list_last(entries); curr != NULL;
+             curr = curr->prev) {
+                struct registry_entry *entry = curr->data;
+
+                suites = g_list_prepend(suites, entry->suite);
+                suites = flatten_entries(entry->children, suites);
+        }
+
+        return suites;
+}
+
+bool uc_registry_all_passed(uc_registry registry) {
+        GList *suites;
+        bool passed = true;
+
+        if (registry == NULL) return false;
+
+        suites = flatten_entries(registry->suites, NULL);
+        for (GList *curr = suites; curr != NULL && passed; curr = curr->next) {
+                passed = uc_all_tests_passed(curr->data);
+        }
+        g_list_free(suites);
+
+        return passed;
+}
+
+const char *test_key(const struct test *test, char *buf) {
+        if (test->name != NULL) return test->name;
+
+        sprintf(buf, "Test #%u", test->test_num);
+        return buf;
+}
+
+GHashTable *read_watch_state(const int fd) {
+        GHashTable *state = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                  free, NULL);
+        struct stat info;
+        char *data, *line, *end;
+
+        if (fstat(fd, &info) == -1 || info.st_size == 0) return state;
+
+        data = malloc(info.st_size + 1);
+        if (data == NULL) return state;
+
+        if (lseek(fd, 0, SEEK_SET) == -1 ||
+            !read_full(fd, data, info.st_size)) {
+                free(data);
+                return state;
+        }
+        data[info.st_size] = '\0';
+
+        for (line = data; *line != '\0'; line = end + 1) {
+                char *key;
+
+                end = strchr(line, '\n');
+                if (end == NULL) break;
+                *end = '\0';
+
+                if ((line[0] != 'P' && line[0] != 'F') || line[1] != ' ') {
+                        continue;
+                }
+                key = strdup(line + 2);
+                if (key == NULL) break;
+                g_hash_table_insert(state, key, GINT_TO_POINTER(line[0]));
+        }
+
+        free(data);
+        return state;
+}
+
+void write_watch_state(uc_suite suite, const int fd) {
+        if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1) return;
+
+        /* Guaranteed to have at least one element from uc_init. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                char buf[32];
+
+                dprintf(fd, "%c %s\n", test_passed(curr->data) ? 'P' : 'F',
+                        test_key(curr->data, buf));
+        }
+}
+
+GList *failing_first(GList *tests, GHashTable *state) {
+        GList *last = g_list_last(tests);
+        GList *failing = NULL, *rest = NULL;
+
+        /* Walked in order of addition, so prepending reverses each part. */
+        for (GList *curr = last->prev; curr != NULL; curr = curr->prev) {
+                char buf[32];
+                const char *key = test_key(curr->data, buf);
+
+                if (GPOINTER_TO_INT(g_hash_table_lookup(state, key)) == 'F') {
+                        failing = g_list_prepend(failing, curr->data);
+                } else {
+                        rest = g_list_prepend(rest, curr->data);
+                }
+        }
+
+        failing = g_list_concat(failing, g_list_prepend(NULL, last->data));
+        return g_list_concat(rest, failing);
+}
+
+void output_watch_diff(uc_suite suite, GHashTable *state) {
+        unsigned int num_passed = 0, num_tests = 0;
+
+        /* Guaranteed to have at least one element from uc_init. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                ++num_tests;
+                if (test_passed(curr->data)) ++num_passed;
+        }
+
+        puts("");
+        printf("Watch: %u/%u tests passed.\n", num_passed, num_tests);
+
+        /* Nothing to compare with on the first run. */
+        if (g_hash_table_size(state) == 0) return;
+
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                char buf[32];
+                const char *key = test_key(curr->data, buf);
+                bool failed_before =
+                        GPOINTER_TO_INT(g_hash_table_lookup(state, key)) == 'F';
+
+                if (test_passed(curr->data) == !failed_before) continue;
+
+                output_indent(1);
+                printf("%s: %s\n", failed_before ? "Now passing" : "Now failing",
+                       key);
+        }
+}
+
+bool add_watch(const int inotify_fd, const char *path,
+               struct watched_path *watched) {
+        const char *slash;
+        char dir[PATH_MAX];
+        struct stat info;
+
+        watched->name = NULL;
+        if (stat(path, &info) == -1) return false;
+
+        if (S_ISDIR(info.st_mode)) {
+                watched->wd = inotify_add_watch(inotify_fd, path, WATCH_EVENTS);
+                return watched->wd != -1;
+        }
+
+        /* Files are replaced rather than written to by linkers and many
+         * editors, so their directory is watched.
+         */
+        slash = strrchr(path, '/');
+        if (slash == NULL) {
+                strcpy(dir, ".");
+        } else if (slash == path) {
+                strcpy(dir, "/");
+        } else if (slash - path < PATH_MAX) {
+                memcpy(dir, path, slash - path);
+                dir[slash - path] = '\0';
+        } else {
+                return false;
+        }
+
+        ALLOC_STRING(slash == NULL ? path : slash + 1, watched->name,
+                     return false;);
+        watched->wd = inotify_add_watch(inotify_fd, dir, WATCH_EVENTS);
+        return watched->wd != -1;
+}
+
+bool wait_for_change(const int inotify_fd, const struct watched_path *watched,
+                     const size_t num_watched) {
+        char buf[4096]
+                __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool changed = false;
+
+        for (;;) {
+                struct pollfd fds;
+                ssize_t len;
+                int ready;
+
+                fds.fd = inotify_fd;
+                fds.events = POLLIN;
+                ready = poll(&fds, 1, changed ? WATCH_SETTLE_MS : -1);
+                if (ready == -1 && errno == EINTR) continue;
+                if (ready == -1) return false;
+                if (ready == 0) return true;
+
+                len = read(inotify_fd, buf, sizeof(buf));
+                if (len == -1 && errno == EINTR) continue;
+                if (len <= 0) return false;
+
+                for (char *curr = buf; curr < buf + len;
+                     curr += sizeof(struct inotify_event) +
+                             ((struct inotify_event *)curr)->len) {
+                        struct inotify_event *event = (void *)curr;
+
+                        if (event->mask & IN_Q_OVERFLOW) changed = true;
+
+                        for (size_t i = 0; i < num_watched; ++i) {
+                                if (event->wd != watched[i].wd) continue;
+                                if (watched[i].name == NULL ||
+                                    (event->len > 0 &&
+                                     strcmp(event->name,
+                                            watched[i].name) == 0)) {
+                                        changed = true;
+                                }
+                        }
+                }
+        }
+}
+
+char **read_cmdline(void) {
+        char *data = NULL, **argv;
+        size_t len = 0, capacity = 0, argc = 0;
+        ssize_t got;
+        int fd = open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1) return NULL;
+
+        do {
+                if (len == capacity) {
+                        char *grown;
+
+                        capacity = capacity == 0 ? 4096 : capacity * 2;
+                        grown = realloc(data, capacity);
+                        if (grown == NULL) break;
+                        data = grown;
+                }
+
+                got = read(fd, data + len, capacity - len);
+                if (got > 0) len += got;
+        } while (got > 0 || (got == -1 && errno == EINTR));
+        close(fd);
+
+        if (data == NULL || len == 0 || data[len - 1] != '\0') {
+                free(data);
+                return NULL;
+        }
+
+        for (size_t i = 0; i < len; ++i) argc += data[i] == '\0';
+
+        argv = malloc(sizeof(char *) * (argc + 1));
+        if (argv == NULL) {
+                free(data);
+                return NULL;
+        }
+
+        argc = 0;
+        for (size_t i = 0; i < len; i += strlen(data + i) + 1) {
+                argv[argc++] = data + i;
+        }
+        argv[argc] = NULL;
+
+        return argv;
+}
+
+void uc_report_basic(uc_suite suite) {
+        if (suite == NULL) return;
+
+        output_main_header(suite);
+
+        /* Guaranteed to have at least one element from uc_init. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                output_test_common(curr->data, 1);
+        }
+}
+
+void uc_report_standard(uc_suite suite) {
+        GList *main_test;
+        if (suite == NULL) return;
+
+        main_test = g_list_last(suite->tests);
+
+        output_main_header(suite);
+        output_test_failures(main_test->data, 1);
+
+        /* Guaranteed to have at least one element from uc_init. */
+        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
+             curr = curr->prev) {
+                output_test_common(curr->data, 1);
+                output_test_skipped(curr->data, 2);
+                output_test_failures(curr->data, 2);
+                output_test_repeat(curr->data, 2);
+                output_test_load(curr->data, 2);
+                output_test_heap(curr->data, 2);
+                output_test_perf(curr->data, 2);
+                output_test_placement(curr->data, 2);
+                output_test_crash(curr->data, 2);
+                output_test_output(curr->data, 2);
+        }
+}
+
+void uc_report_registry(uc_registry registry) {
+        unsigned int num_succ = 0, num_checks = 0;
+        unsigned int num_passed = 0, num_tests = 0;
+        GList *suites;
+
+        if (registry == NULL) return;
+
+        suites = flatten_entries(registry->suites, NULL);
+        for (GList *curr = suites; curr != NULL; curr = curr->next) {
+                uc_suite suite = curr->data;
+
+                num_succ += suite->num_succ;
+                num_checks += suite->num_checks;
+                /* Guaranteed to have at least one element from uc_init. */
+                for (GList *test = g_list_last(suite->tests)->prev;
+                     test != NULL; test = test->prev) {
+                        ++num_tests;
+                        if (test_passed(test->data)) ++num_passed;
+                }
+        }
+        g_list_free(suites);
+
+        puts("All suites");
+        printf("Total successful checks: %u/%u.\n", num_succ, num_checks);
+        printf("Tests passed: %u/%u.\n", num_passed, num_tests);
+
+        output_registry_entries(registry->suites, 1);
+}
+
+void output_registry_entries(GList *entries, const unsigned int indent) {
+        for (GList *curr = g_list_last(entries); curr != NULL;
+             curr = curr->prev) {
+                struct registry_entry *entry = curr->data;
+                uc_suite suite = entry->suite;
+                unsigned int num_passed = 0, num_tests = 0;
+
+                for (GList *test = g_list_last(suite->tests)->prev;
+                     test != NULL; test = test->prev) {
+                        ++num_tests;
+                        if (test_passed(test->data)) ++num_passed;
+                }
+
+                puts("");
+                output_indent(indent);
+                puts(suite->name != NULL ? suite->name : DEFAULT_SUITE_NAME);
+                output_checks_fraction(suite->num_succ, suite->num_checks,
+                                       indent + 1);
+                output_indent(indent + 1);
+                printf("Tests passed: %u/%u.\n", num_passed, num_tests);
+
+                output_registry_entries(entry->children, indent + 1);
+        }
+}
+
+void output_indent(const unsigned int level) {
+        for (unsigned int i = 0; i < level; ++i) printf(INDENTATION);
+}
+
+void output_checks_fraction(const unsigned int succ, const unsigned int total,
+                            const unsigned int indent) {
+        output_indent(indent);
+        printf("Successful checks: %u/%u.\n", succ, total);
+}
+
+void output_test_common(struct test *test, const unsigned int indent) {
+        if (test == NULL) return;
+
+        puts("");
+
+        output_indent(indent);
+        test->name != NULL ? puts(test->name) :
+                             printf("Test #%u\n", test->test_num);
+
+        if (test->comment != NULL) {
+                output_indent(indent);
+                puts(test->comment);
+        }
+
+        output_checks_fraction(test->num_succ, test->num_checks, indent + 1);
+}
+
+void output_test_failures(struct test *test, const unsigned int indent) {
+        if (test == NULL) return;
+
+        merge_check_buffers(test);
+
+        for (GList *curr = g_list_last(test->checks); curr != NULL;
+             curr = curr->prev) {
+                struct check *check;
+                char *comment;
+
+                check = curr->data;
+                /* Print nothing for successful checks. */
+                if (check->result) continue;
+
+                comment = check->comment;
+
+                output_indent(indent);
+                if (comment != NULL) {
+                        printf("Check failed: %s\n", comment);
+                } else {
+                        printf("Check failed: Check #%u.\n", check->check_num);
+                }
+        }
+}
+
+void output_test_heap(struct test *test, const unsigned int indent) {
+        if (test == NULL || !test->has_heap) return;
+
+        output_indent(indent);
+        printf("Heap: %zu allocation%s, %zu bytes, peak %ld bytes.\n",
+               test->heap.allocs, test->heap.allocs == 1 ? "" : "s",
+               test->heap.bytes, test->heap.peak_bytes);
+
+        if (test->heap.live_blocks > 0) {
+                output_indent(indent);
+                printf("Unfreed: %ld bytes in %ld block%s.\n",
+                       test->heap.live_bytes, test->heap.live_blocks,
+                       test->heap.live_blocks == 1 ? "" : "s");
+        }
+}
+
+void output_test_perf(struct test *test, const unsigned int indent) {
+        bool first = true;
+
+        if (test == NULL || !test->has_perf || test->perf.available == 0) {
+                return;
+        }
+
+        output_indent(indent);
+        printf("Counters:");
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+                if (!(test->perf.available & 1u << i)) continue;
+
+                printf("%s %s ", first ? "" : ",", perf_counters[i].name);
+                if (i == COUNTER_TASK_CLOCK) {
+                        /* Nanoseconds. */
+                        printf("%.3f ms", test->perf.values[i] / 1e6);
+                } else {
+                        printf("%" PRIu64, test->perf.values[i]);
+                }
+
+                first = false;
+        }
+        puts(".");
+}
+
+void output_test_placement(struct test *test, const unsigned int indent) {
+        struct placement *placement;
+
+        if (test == NULL || !test->has_placement) return;
+        placement = &test->placement;
+
+        output_indent(indent);
+        printf("Placement:");
+        if (placement->cpu != -1) {
+                printf(" CPU %d", placement->cpu);
+                if (placement->policy != -1) printf(",");
+        }
+
+        if (placement->policy == SCHED_FIFO) {
+                printf(" SCHED_FIFO priority %d", placement->priority);
+        } else if (placement->policy == SCHED_OTHER) {
+                printf(" nice %d", placement->priority);
+        } else if (placement->cpu == -1) {
+                printf(" none");
+        }
+        puts(".");
+}
+
+void output_test_repeat(struct test *test, const unsigned int indent) {
+        const struct repeat_stats *stats;
+        if (test == NULL || !test->has_repeat) return;
+
+        stats = &test->repeat;
+
+        output_indent(indent);
+        printf("Runs: %u/%u passed (%.1f%%)", stats->passed, stats->runs,
+               100.0 * stats->passed / stats->runs);
+        if (stats->first_failure != 0) {
+                printf(", first failure in run %u", stats->first_failure);
+        }
+        puts(".");
+
+        output_indent(indent);
+        printf("Checks over all runs: %lu/%lu.\n", stats->num_succ,
+               stats->num_checks);
+
+        if (stats->timed_runs > 0) {
+                output_indent(indent);
+                printf("Run time: min %.3f ms, mean %.3f ms, max %.3f ms.\n",
+                       stats->min_time * 1e3,
+                       stats->total_time / stats->timed_runs * 1e3,
+                       stats->max_time * 1e3);
+        }
+}
+
+void output_test_load(struct test *test, const unsigned int indent) {
+        const struct load_stats *stats;
+        if (test == NULL || !test->has_load) return;
+
+        stats = &test->load_stats;
+
+        output_indent(indent);
+        printf("Load: %lu calls from %u caller%s in %.3f s (%.1f calls/s), "
+               "%lu failed (%.2f%%).\n", stats->calls, stats->callers,
+               stats->callers == 1 ? "" : "s", stats->seconds,
+               stats->seconds > 0 ? stats->calls / stats->seconds : 0,
+               stats->errors,
+               stats->calls > 0 ? 100.0 * stats->errors / stats->calls : 0);
+
+        output_indent(indent);
+        printf("Latency: p50 %.3f us, p99 %.3f us, p99.9 %.3f us, "
+               "max %.3f us.\n", stats->p50 * 1e6, stats->p99 * 1e6,
+               stats->p999 * 1e6, stats->max * 1e6);
+}
+
+void output_test_skipped(struct test *test, const unsigned int indent) {
+        char buf[32];
+
+        if (test == NULL) return;
+
+        if (test->skipped) {
+                output_indent(indent);
+                puts("Not run: covers none of the changes.");
+        } else if (test->blocked_by != NULL) {
+                output_indent(indent);
+                printf("Not run: prerequisite %s did not pass.\n",
+                       test_key(test->blocked_by, buf));
+        }
+}
+
+void output_test_crash(struct test *test, const unsigned int indent) {
+        struct crash *crash;
+
+        /* Tests passed over are reported by output_test_skipped. */
+        if (test == NULL || !test->run_failed || test->blocked_by != NULL) {
+                return;
+        }
+
+        crash = test->crash;
+        if (crash == NULL) {
+                output_indent(indent);
+                puts("Failed to run.");
+                return;
+        }
+
+        output_indent(indent);
+        printf("Crashed: %s (signal %d)", strsignal(crash->signal),
+               crash->signal);
+        /* Only faults have a meaningful address. */
+        if (crash->signal == SIGSEGV || crash->signal == SIGBUS ||
+            crash->signal == SIGFPE || crash->signal == SIGILL) {
+                printf(" at %#" PRIxPTR, crash->address);
+        }
+        puts(".");
+
+        if (crash->check_num > 0) {
+                output_indent(indent);
+                if (crash->check_comment != NULL) {
+                        printf("Last check: %s\n", crash->check_comment);
+                } else {
+                        printf("Last check: Check #%u.\n", crash->check_num);
+                }
+        }
+}
+
+void output_test_output(struct test *test, const unsigned int indent) {
+        const char *line, *end;
+
+        if (test == NULL || test->output == NULL) return;
+        if (!test->run_failed && test->num_succ == test->num_checks) return;
+
+        output_indent(indent);
+        if (test->output_dropped > 0) {
+                printf("Output (first %zu bytes dropped):\n",
+                       test->output_dropped);
+        } else {
+                puts("Output:");
+        }
+
+        /* Written with fwrite() so NUL bytes don't cut the output short. */
+        end = test->output + test->output_len;
+        for (line = test->output; line < end;) {
+                const char *eol = memchr(line, '\n', end - line);
+                size_t len = eol != NULL ? (size_t)(eol - line) :
+                                           (size_t)(end - line);
+
+                output_indent(indent + 1);
+                fwrite(line, 1, len, stdout);
+                putchar('\n');
+
+                line += eol != NULL ? len + 1 : len;
+        }
+}
+
+void output_main_header(uc_suite suite) {
+        struct test *curr_test;
+
+        if (suite == NULL) return;
+
+        puts(suite->name != NULL ? suite->name : DEFAULT_SUITE_NAME);
+        if (suite->comment != NULL) puts(suite->comment);
+
+        printf("Total successful checks: %u/%u.\n", suite->num_succ,
+               suite->num_checks);
+
+        curr_test = suite->curr_test->data;
+        output_checks_fraction(curr_test->num_succ, curr_test->num_checks, 1);
+}
+
+void write_test_results(const struct test *test, const int wr_fd) {
+        static const char heap_tag = RECORD_HEAP;
+        static const char perf_tag = RECORD_PERF;
+        static const char placement_tag = RECORD_PLACEMENT;
+        static const char run_time_tag = RECORD_RUN_TIME;
+        static const char span_tag = RECORD_SPAN;
+        static const char profile_tag = RECORD_PROFILE;
+        static const char load_tag = RECORD_LOAD;
+        static const char end = RECORD_END;
+
+        /* Format is defined above prototype. */
+        in_write_results = 1;
+        for (GList *curr = g_list_last(test->checks); curr != NULL;
+             curr = curr->prev) {
+                if (!write_check(curr->data, wr_fd, true)) abort();
+        }
+
+        if (test->has_heap) {
+                TRY_RW(write, wr_fd, &heap_tag, sizeof(char), { abort(); });
+                TRY_RW(write, wr_fd, &test->heap, sizeof(struct heap_stats),
+                       { abort(); });
+        }
+
+        if (test->has_perf) {
+                TRY_RW(write, wr_fd, &perf_tag, sizeof(char), { abort(); });
+                TRY_RW(write, wr_fd, &test->perf, sizeof(struct perf_counts),
+                       { abort(); });
+        }
+
+        if (test->has_placement) {
+                TRY_RW(write, wr_fd, &placement_tag, sizeof(char),
+                       { abort(); });
+                TRY_RW(write, wr_fd, &test->placement,
+                       sizeof(struct placement), { abort(); });
+        }
+
+        if (test->has_run_time) {
+                TRY_RW(write, wr_fd, &run_time_tag, sizeof(char),
+                       { abort(); });
+                TRY_RW(write, wr_fd, &test->run_time, sizeof(double),
+                       { abort(); });
+        }
+
+        if (test->has_span) {
+                TRY_RW(write, wr_fd, &span_tag, sizeof(char), { abort(); });
+                TRY_RW(write, wr_fd, &test->span, sizeof(struct test_span),
+                       { abort(); });
+        }
+
+        if (test->profiled) {
+                TRY_RW(write, wr_fd, &profile_tag, sizeof(char),
+                       { abort(); });
+                if (!write_profile(wr_fd)) abort();
+        }
+
+        if (test->has_load) {
+                TRY_RW(write, wr_fd, &load_tag, sizeof(char), { abort(); });
+                TRY_RW(write, wr_fd, &test->load_stats,
+                       sizeof(struct load_stats), { abort(); });
+        }
+
+        /* No more checks to write. */
+        TRY_RW(write, wr_fd, &end, sizeof(char), { abort(); });
+        in_write_results = 0;
+}
+
+bool write_check(const struct check *check, const int wr_fd,
+                 const bool intern) {
+        static const char tag = RECORD_CHECK;
+
+        TRY_RW(write, wr_fd, &tag, sizeof(char), { return false; });
+        TRY_RW(write, wr_fd, &check->result, sizeof(bool), { return false; });
+
+        return write_comment(check->comment, wr_fd, intern);
+}
+
+bool write_comment(const char *comment, const int wr_fd,
+                   const bool intern) {
+        static const char none = COMMENT_NONE;
+        static const char inline_tag = COMMENT_INLINE;
+        static const char new_tag = COMMENT_NEW;
+        static const char sent_tag = COMMENT_SENT;
+        size_t comment_len;
+
+        if (comment == NULL) {
+                TRY_RW(write, wr_fd, &none, sizeof(char), { return false; });
+                return true;
+        }
+
+        if (intern && sent_comments == NULL) {
+                sent_comments = g_hash_table_new(&g_str_hash, &g_str_equal);
+        }
+
+        if (intern && sent_comments != NULL) {
+                /* Keys are the checks' comments, kept until exit. */
+                uint32_t id = GPOINTER_TO_UINT(g_hash_table_lookup(
+                                      sent_comments, comment));
+
+                if (id != 0) {
+                        --id;
+                        TRY_RW(write, wr_fd, &sent_tag, sizeof(char),
+                               { return false; });
+                        TRY_RW(write, wr_fd, &id, sizeof(uint32_t),
+                               { return false; });
+                        return true;
+                }
+
+                id = num_sent_comments++;
+                g_hash_table_insert(sent_comments, (gpointer)comment,
+                                    GUINT_TO_POINTER(id + 1));
+                TRY_RW(write, wr_fd, &new_tag, sizeof(char),
+                       { return false; });
+                TRY_RW(write, wr_fd, &id, sizeof(uint32_t), { return false; });
+        } else {
+                TRY_RW(write, wr_fd, &inline_tag, sizeof(char),
+                       { return false; });
+        }
+
+        comment_len = strlen(comment);
+        TRY_RW(write, wr_fd, &comment_len, sizeof(size_t), { return false; });
+        TRY_RW(write, wr_fd, comment, sizeof(char) * (comment_len + 1),
+               { return false; });
+
+        return true;
+}
+
+void write_test_start(const int wr_fd) {
+        static const char non_null = 'X';
+        TRY_RW(write, wr_fd, &non_null, sizeof(char), { abort(); });
+}
+
+enum results_status read_test_results(uc_suite suite,
+                                      struct results_buf *buf,
+                                      const bool dry_run) {
+        struct test *test = suite->curr_test->data;
+        /* Determines what to read next. */
+        char tag;
+
+        /* Format is defined above write_test_results' protoype. */
+        TAKE(buf, &tag, sizeof(char));
+        while (tag != RECORD_END) {
+                enum results_status status = RESULTS_OK;
+
+                if (tag == RECORD_CHECK) {
+                        const char *comment = NULL;
+                        bool result;
+
+                        TAKE(buf, &result, sizeof(bool));
+                        status = read_comment(suite, buf,
+                                              dry_run ? NULL : &comment);
+                        /* The suite owns the interned comment. */
+                        if (status == RESULTS_OK && !dry_run) {
+                                add_check(suite, result, comment, true);
+                        }
+                } else if (tag == RECORD_CRASH) {
+                        status = read_crash_record(suite, buf, dry_run);
+                } else if (tag == RECORD_HEAP) {
+                        struct heap_stats heap;
+
+                        TAKE(buf, &heap, sizeof(struct heap_stats));
+                        if (!dry_run) {
+                                test->heap = heap;
+                                test->has_heap = true;
+                        }
+                } else if (tag == RECORD_PERF) {
+                        struct perf_counts perf;
+
+                        TAKE(buf, &perf, sizeof(struct perf_counts));
+                        if (!dry_run) {
+                                test->perf = perf;
+                                test->has_perf = true;
+                        }
+                } else if (tag == RECORD_PLACEMENT) {
+                        struct placement placement;
+
+                        TAKE(buf, &placement, sizeof(struct placement));
+                        if (!dry_run) {
+                                test->placement = placement;
+                                test->has_placement = true;
+                        }
+                } else if (tag == RECORD_RUN_TIME) {
+                        double run_time;
+
+                        TAKE(buf, &run_time, sizeof(double));
+                        if (!dry_run) {
+                                test->run_time = run_time;
+                                test->has_run_time = true;
+                        }
+                } else if (tag == RECORD_SPAN) {
+                        struct test_span span;
+
+                        TAKE(buf, &span, sizeof(struct test_span));
+                        if (!dry_run) {
+                                test->span = span;
+                                test->has_span = true;
+                        }
+                } else if (tag == RECORD_PROFILE) {
+                        status = read_profile_record(suite, buf, dry_run);
+                } else if (tag == RECORD_LOAD) {
+                        struct load_stats load;
+
+                        TAKE(buf, &load, sizeof(struct load_stats));
+                        if (!dry_run) {
+                                test->load_stats = load;
+                                test->has_load = true;
+                        }
+                } else {
+                        return RESULTS_INVALID;
+                }
+
+                if (status != RESULTS_OK) return status;
+                TAKE(buf, &tag, sizeof(char));
+        }
+
+        return RESULTS_OK;
+}
+
+enum results_status read_comment(uc_suite suite, struct results_buf *buf,
+                                 const char **comment) {
+        const char *text;
+        size_t comment_len;
+        uint32_t id = 0;
+        char kind;
+
+        if (comment != NULL) *comment = NULL;
+
+        TAKE(buf, &kind, sizeof(char));
+        if (kind == COMMENT_NONE) return RESULTS_OK;
+
+        if (kind == COMMENT_SENT) {
+                TAKE(buf, &id, sizeof(uint32_t));
+                if (comment == NULL) return RESULTS_OK;
+
+                if (buf->comments == NULL || id >= buf->comments->len) {
+                        return RESULTS_INVALID;
+                }
+                *comment = g_ptr_array_index(buf->comments, id);
+                return RESULTS_OK;
+        }
+
+        if (kind == COMMENT_NEW) {
+                TAKE(buf, &id, sizeof(uint32_t));
+        } else if (kind != COMMENT_INLINE) {
+                return RESULTS_INVALID;
+        }
+
+        TAKE(buf, &comment_len, sizeof(size_t));
+        if (comment_len == SIZE_MAX) return RESULTS_INVALID;
+        if (comment_len + 1 > buf->len - buf->pos) return RESULTS_INCOMPLETE;
+
+        text = buf->data + buf->pos;
+        if (text[comment_len] != '\0') return RESULTS_INVALID;
+        buf->pos += comment_len + 1;
+
+        /* Skipped. */
+        if (comment == NULL) return RESULTS_OK;
+
+        *comment = intern_comment(suite, text);
+        if (*comment == NULL) {
+                fputs("uc_run_tests: cannot save a comment.\n", stderr);
+                return RESULTS_INVALID;
+        }
+
+        if (kind == COMMENT_NEW) {
+                /* Ids are given in order. */
+                if (buf->comments == NULL) {
+                        buf->comments = g_ptr_array_new();
+                }
+                if (buf->comments == NULL || id != buf->comments->len) {
+                        return RESULTS_INVALID;
+                }
+                g_ptr_array_add(buf->comments, (gpointer)*comment);
+        }
+
+        return RESULTS_OK;
+}
+
+const char *intern_comment(uc_suite suite, const char *comment) {
+        char *interned;
+
+        if (suite->comments == NULL) {
+                suite->comments = g_hash_table_new_full(&g_str_hash,
+                                                        &g_str_equal, &free,
+                                                        NULL);
+                if (suite->comments == NULL) return NULL;
+        }
+
+        interned = g_hash_table_lookup(suite->comments, comment);
+        if (interned != NULL) return interned;
+
+        ALLOC_STRING(comment, interned, { return NULL; });
+        g_hash_table_insert(suite->comments, interned, interned);
+
+        return interned;
+}
+
+enum results_status read_crash_record(uc_suite suite,
+                                      struct results_buf *buf,
+                                      const bool dry_run) {
+        struct test *test = suite->curr_test->data;
+        void *frames[MAX_CRASH_FRAMES];
+        enum results_status status;
+        const char *check_comment = NULL;
+        unsigned int check_num;
+        struct crash *crash;
+        uintptr_t address;
+        int signal, num_frames;
+
+        TAKE(buf, &signal, sizeof(int));
+        TAKE(buf, &address, sizeof(uintptr_t));
+        TAKE(buf, &check_num, sizeof(unsigned int));
+        status = read_comment(suite, buf, dry_run ? NULL : &check_comment);
+        if (status != RESULTS_OK) return status;
+
+        TAKE(buf, &num_frames, sizeof(int));
+        if (num_frames < 0 || num_frames > MAX_CRASH_FRAMES) {
+                return RESULTS_INVALID;
+        }
+        TAKE(buf, frames, sizeof(void *) * num_frames);
+
+        if (dry_run) return RESULTS_OK;
+
+        crash = malloc(sizeof(struct crash));
+        if (crash == NULL) return RESULTS_INVALID;
+
+        crash->signal = signal;
+        crash->address = address;
+        crash->check_num = check_num;
+        crash->check_comment = check_comment;
+        crash->backtrace = NULL;
+        crash->num_frames = 0;
+
+        if (num_frames > 0) {
+                /* The test process was forked from this one, so its code is
+                 * at the same addresses here.
+                 */
+                crash->backtrace = backtrace_symbols(frames, num_frames);
+                if (crash->backtrace != NULL) crash->num_frames = num_frames;
+        }
+
+        if (test->crash != NULL) struct_crash_free(test->crash);
+        test->crash = crash;
+
+        return RESULTS_OK;
+}
+
+bool take_results(struct results_buf *buf, void *dst, const size_t count) {
+        if (count > buf->len - buf->pos) return false;
+
+        if (dst != NULL) memcpy(dst, buf->data + buf->pos, count);
+        buf->pos += count;
+
+        return true;
+}
+
+bool fill_results(struct results_buf *buf, const int fd) {
+        for (;;) {
+                ssize_t n;
+
+                if (buf->capacity - buf->len < RESULTS_CHUNK) {
+                        size_t capacity = buf->capacity * 2 + RESULTS_CHUNK;
+                        char *data = realloc(buf->data, capacity);
+
+                        if (data == NULL) return false;
+                        buf->data = data;
+                        buf->capacity = capacity;
+                }
+
+                n = read(fd, buf->data + buf->len, buf->capacity - buf->len);
+                if (n == 0) return false;
+                if (n == -1) {
+                        if (errno == EINTR) continue;
+                        /* EAGAIN: nothing more for now. */
+                        return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+
+                buf->len += n;
+        }
+}
+
+void run_parent_hook(uc_suite suite, void (*hook)(uc_suite)) {
+        if (hook == NULL) return;
+
+        suite->curr_test = g_list_last(suite->tests);
+        hook(suite);
+}
+
+unsigned int batch_length(uc_suite suite, GList *entry) {
+        struct group *group = ((struct test *)entry->data)->group;
+        unsigned int length = 1;
+
+        for (entry = entry->prev; entry != NULL; entry = entry->prev) {
+                struct test *test = entry->data;
+
+                if (length == suite->batch_size) break;
+                if (test->group != group) break;
+                if (test->started || test_constrained(test)) break;
+                ++length;
+        }
+
+        return length;
+}
+
+void run_test_child(uc_suite suite, GList *entry, const unsigned int length,
+                    const unsigned int slot, const struct test_fds *fds) {
+        const int wr_fd = fds->results;
+        const bool timed = repeating(suite);
+        const bool traced = suite->trace_path != NULL;
+        bool profiling = false;
+        int perf_fds[NUM_COUNTERS];
+        struct placement placement;
+        bool placed;
+
+        crash_fd = wr_fd;
+        install_crash_handlers();
+        /* Before output is captured so errors reach the terminal. */
+        placed = place_test_process(suite, slot, &placement);
+
+        if (suite->options & UC_OPT_PERF_COUNTERS) {
+                open_perf_counters(perf_fds);
+        }
+
+        if (suite->profile_dir != NULL) {
+                profiling = init_profile();
+                if (!profiling) {
+                        fputs("uc_run_tests: cannot profile tests.\n",
+                              stderr);
+                }
+        }
+
+        if (fds->output != -1) {
+                if (dup2(fds->output, STDOUT_FILENO) == -1 ||
+                    dup2(fds->output, STDERR_FILENO) == -1) {
+                        fputs("uc_run_tests: cannot capture output.\n",
+                              stderr);
+                }
+                close(fds->output);
+        }
+
+        for (unsigned int i = 0; i < length; ++i, entry = entry->prev) {
+                struct test *test = entry->data;
+                struct timespec start, end;
+
+                suite->curr_test = entry;
+                test->owner = pthread_self();
+                /* A repeated test holds the checks of an earlier run. */
+                if (test->has_repeat) {
+                        g_list_free_full(test->checks, &struct_check_free);
+                        test->checks = NULL;
+                        test->num_succ = 0;
+                        test->num_checks = 0;
+                }
+                write_test_start(wr_fd);
+                if (traced) test->span.start = monotonic_ns();
+                crash_test = test;
+                test->placement = placement;
+                test->has_placement = placed;
+                if (suite->options & UC_OPT_HEAP_STATS) heap_start();
+
+                if (suite->coverage_dir != NULL) suite->coverage_reset();
+                if (suite->test_setup != NULL) suite->test_setup(suite);
+                if (suite->options & UC_OPT_PERF_COUNTERS) {
+                        start_perf_counters(perf_fds);
+                }
+                if (timed || profiling) {
+                        clock_gettime(CLOCK_MONOTONIC, &start);
+                }
+                if (profiling) start_profile();
+                if (test->test_func != NULL) test->test_func(suite);
+                if (profiling) stop_profile();
+                if (timed || profiling) {
+                        clock_gettime(CLOCK_MONOTONIC, &end);
+                }
+                if (timed) {
+                        test->run_time = seconds_between(&start, &end);
+                        test->has_run_time = true;
+                }
+                /* Fast tests are left out. */
+                test->profiled = profiling &&
+                                 seconds_between(&start, &end) >=
+                                 suite->profile_min_seconds;
+                if (suite->options & UC_OPT_PERF_COUNTERS) {
+                        stop_perf_counters(perf_fds, &test->perf);
+                        test->has_perf = true;
+                }
+                if (suite->test_teardown != NULL) suite->test_teardown(suite);
+
+                if (suite->options & UC_OPT_HEAP_STATS) {
+                        __atomic_store_n(&heap_counting, false,
+                                         __ATOMIC_RELAXED);
+                        test->heap = heap_stats;
+                        test->has_heap = true;
+                }
+
+                if (suite->coverage_dir != NULL) {
+                        dump_test_coverage(suite, test);
+                }
+
+                if (suite->options & UC_OPT_FAIL_ON_LEAK &&
+                    test->has_heap && test->heap.live_blocks > 0) {
+                        char comment[80];
+
+                        snprintf(comment, sizeof(comment),
+                                 "Leaked %ld bytes in %ld block%s.",
+                                 test->heap.live_bytes,
+                                 test->heap.live_blocks,
+                                 test->heap.live_blocks == 1 ? "" : "s");
+                        uc_check(suite, false, comment);
+                }
+
+                merge_check_buffers(test);
+                /* Output must reach the pipe before the results do. */
+                fflush(stdout);
+                fflush(stderr);
+                if (traced) {
+                        test->span.end = monotonic_ns();
+                        test->has_span = true;
+                }
+                write_test_results(test, wr_fd);
+        }
+
+        if (suite->options & UC_OPT_PERF_COUNTERS) {
+                for (int i = 0; i < NUM_COUNTERS; ++i) {
+                        if (perf_fds[i] != -1) close(perf_fds[i]);
+                }
+        }
+
+        if (profiling) free_profile();
+        uc_free(suite);
+        close(wr_fd);
+        exit(EXIT_SUCCESS);
+}
+
+bool spawn_test(uc_suite suite, GList *entry, const unsigned int length,
+                const unsigned int slot, const struct test_fds *fds,
+                pid_t *pid) {
+        if (suite->zygote != -1) {
+                /* The zygote is a fork of this process so entry is just as
+                 * valid there.
+                 */
+                char control[CMSG_SPACE(sizeof(struct test_fds))];
+                /* Output is optional. */
+                size_t fds_size = fds->output == -1 ? sizeof(int) :
+                                                      sizeof(struct test_fds);
+                struct zygote_request request;
+                struct zygote_reply reply;
+                struct iovec iov;
+                struct msghdr msg;
+                struct cmsghdr *cmsg;
+
+                request.entry = entry;
+                request.length = length;
+                request.slot = slot;
+
+                memset(control, 0, sizeof(control));
+                memset(&msg, 0, sizeof(msg));
+                iov.iov_base = &request;
+                iov.iov_len = sizeof(request);
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = CMSG_SPACE(fds_size);
+
+                cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(fds_size);
+                memcpy(CMSG_DATA(cmsg), fds, fds_size);
+
+                if (sendmsg(suite->zygote_fd, &msg, 0) == -1) return false;
+
+                /* The zygote replies with the process's pid, -1 if it could
+                 * not fork.
+                 */
+                if (!read_zygote_reply(suite, 0, &reply)) return false;
+                *pid = reply.pid;
+                return *pid != -1;
+        }
+
+        /* Don't let the test process inherit buffered output. */
+        fflush(NULL);
+
+        *pid = fork();
+        if (*pid == -1) return false;
+        if (*pid == 0) run_test_child(suite, entry, length, slot, fds);
+
+        return true;
+}
+
+enum reap_status reap_test(uc_suite suite, const pid_t pid, int *wstatus,
+                           const bool wait) {
+        if (suite->zygote != -1) {
+                struct zygote_reply reply;
+
+                if (!wait && !read_zygote_exits(suite)) return REAP_FAILED;
+
+                /* The exit may have been read while waiting for another. */
+                for (GList *curr = suite->zygote_exits; curr != NULL;
+                     curr = curr->next) {
+                        struct zygote_reply *exit = curr->data;
+
+                        if (exit->pid != pid) continue;
+
+                        *wstatus = exit->wstatus;
+                        suite->zygote_exits =
+                                g_list_delete_link(suite->zygote_exits, curr);
+                        free(exit);
+                        return REAP_DONE;
+                }
+
+                if (!wait) return REAP_PENDING;
+                if (!read_zygote_reply(suite, pid, &reply)) return REAP_FAILED;
+
+                *wstatus = reply.wstatus;
+                return REAP_DONE;
+        }
+
+        for (;;) {
+                pid_t reaped = waitpid(pid, wstatus, wait ? 0 : WNOHANG);
+
+                if (reaped == pid) return REAP_DONE;
+                if (reaped == 0) return REAP_PENDING;
+                if (errno != EINTR) return REAP_FAILED;
+        }
+}
+
+bool start_zygote(uc_suite suite) {
+        sigset_t sigchld;
+        int ctl[2], sig_fd;
+
+        /* Read by the zygote, which blocks SIGCHLD. */
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sig_fd = signalfd(-1, &sigchld, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (sig_fd == -1) return false;
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctl) == -1) {
+                close(sig_fd);
+                return false;
+        }
+
+        /* Don't let the zygote inherit buffered output. */
+        fflush(NULL);
+
+        suite->zygote = fork();
+        if (suite->zygote == -1) {
+                close(ctl[R]);
+                close(ctl[WR]);
+                close(sig_fd);
+                return false;
+        } else if (suite->zygote == 0) {
+                close(ctl[R]);
+                zygote_loop(suite, ctl[WR], sig_fd);
+        }
+
+        close(ctl[WR]);
+        close(sig_fd);
+        suite->zygote_fd = ctl[R];
+
+        return true;
+}
+
+void stop_zygote(uc_suite suite) {
+        /* The zygote exits once it sees the end of its control socket. */
+        if (close(suite->zygote_fd) == -1) {
+                fputs("uc_run_tests: cannot close zygote socket.\n", stderr);
+        }
+
+        if (waitpid(suite->zygote, NULL, 0) == -1) {
+                fputs("uc_run_tests: cannot wait for zygote.\n", stderr);
+        }
+
+        g_list_free_full(suite->zygote_exits, &free);
+        suite->zygote_exits = NULL;
+        suite->zygote = -1;
+        suite->zygote_fd = -1;
+}
+
+void zygote_loop(uc_suite suite, const int ctl_fd, const int sig_fd) {
+        struct group *prev_group = NULL;
+        sigset_t sigchld, orig_mask;
+
+        /* Exits are read from sig_fd instead. */
+        sigemptyset(&sigchld);
+        sigaddset(&sigchld, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &sigchld, &orig_mask);
+
+        for (;;) {
+                char control[CMSG_SPACE(sizeof(struct test_fds))];
+                struct pollfd ready[2];
+                struct zygote_request request;
+                struct zygote_reply reply;
+                struct iovec iov;
+                struct msghdr msg;
+                struct cmsghdr *cmsg;
+                struct test *test;
+                struct test_fds fds;
+                ssize_t received;
+                pid_t pid;
+
+                /* Several test processes may run at once. */
+                ready[0].fd = ctl_fd;
+                ready[0].events = POLLIN;
+                ready[1].fd = sig_fd;
+                ready[1].events = POLLIN;
+                if (poll(ready, 2, -1) == -1) {
+                        if (errno == EINTR) continue;
+                        break;
+                }
+
+                if (ready[1].revents & POLLIN) {
+                        struct signalfd_siginfo info;
+
+                        while (read(sig_fd, &info, sizeof(info)) > 0);
+                        if (!send_exits(ctl_fd)) break;
+                }
+
+                if (ready[0].revents == 0) continue;
+
+                memset(&msg, 0, sizeof(msg));
+                iov.iov_base = &request;
+                iov.iov_len = sizeof(request);
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+
+                received = recvmsg(ctl_fd, &msg, 0);
+                if (received <= 0) break;
+
+                cmsg = CMSG_FIRSTHDR(&msg);
+                if (received != sizeof(request) || cmsg == NULL ||
+                    cmsg->cmsg_type != SCM_RIGHTS) {
+                        break;
+                }
+
+                fds.output = -1;
+                memcpy(&fds, CMSG_DATA(cmsg), cmsg->cmsg_len - CMSG_LEN(0));
+
+                test = request.entry->data;
+                if (test->group != prev_group) {
+                        if (prev_group != NULL) {
+                                run_parent_hook(suite, prev_group->teardown);
+                        }
+
+                        if (test->group != NULL) {
+                                run_parent_hook(suite, test->group->setup);
+                        }
+
+                        prev_group = test->group;
+                }
+
+                fflush(NULL);
+                pid = fork();
+                if (pid == 0) {
+                        close(ctl_fd);
+                        close(sig_fd);
+                        sigprocmask(SIG_SETMASK, &orig_mask, NULL);
+                        run_test_child(suite, request.entry, request.length,
+                                       request.slot, &fds);
+                }
+
+                close(fds.results);
+                if (fds.output != -1) close(fds.output);
+
+                reply.pid = pid;
+                reply.exited = false;
+                reply.wstatus = 0;
+                if (!write_full(ctl_fd, &reply, sizeof(reply))) break;
+        }
+
+        if (prev_group != NULL) run_parent_hook(suite, prev_group->teardown);
+
+        close(ctl_fd);
+        uc_free(suite);
+        exit(EXIT_SUCCESS);
+}
+
+bool send_exits(const int ctl_fd) {
+        struct zygote_reply reply;
+
+        reply.exited = true;
+        while ((reply.pid = waitpid(-1, &reply.wstatus, WNOHANG)) > 0) {
+                if (!write_full(ctl_fd, &reply, sizeof(reply))) return false;
+        }
+
+        return true;
+}
+
+bool read_zygote_exits(uc_suite suite) {
+        struct pollfd ready;
+
+        ready.fd = suite->zygote_fd;
+        ready.events = POLLIN;
+        while (poll(&ready, 1, 0) > 0) {
+                struct zygote_reply reply, *exit;
+
+                /* Replies are written whole, so one can be read at once. */
+                if (!read_full(suite->zygote_fd, &reply, sizeof(reply))) {
+                        return false;
+                }
+                if (!reply.exited) continue;
+
+                exit = malloc(sizeof(struct zygote_reply));
+                if (exit == NULL) return false;
+                *exit = reply;
+                suite->zygote_exits = g_list_prepend(suite->zygote_exits,
+                                                     exit);
+        }
+
+        return true;
+}
+
+bool read_zygote_reply(uc_suite suite, const pid_t pid,
+                       struct zygote_reply *reply) {
+        for (;;) {
+                struct zygote_reply *exit;
+
+                if (!read_full(suite->zygote_fd, reply,
+                               sizeof(struct zygote_reply))) {
+                        return false;
+                }
+
+                if (!reply->exited) return pid == 0;
+                if (reply->pid == pid) return true;
+
+                exit = malloc(sizeof(struct zygote_reply));
+                if (exit == NULL) return false;
+                *exit = *reply;
+                suite->zygote_exits = g_list_prepend(suite->zygote_exits,
+                                                     exit);
+        }
+}
+
+void clear_test_results(uc_suite suite, struct test *test) {
+        merge_check_buffers(test);
+        test->run_failed = true;
+
+        suite->num_checks -= test->num_checks;
+        suite->num_succ -= test->num_succ;
+
+        g_list_free_full(test->checks, &struct_check_free);
+        test->checks = NULL;
+        test->num_succ = 0;
+        test->num_checks = 0;
+        test->has_heap = false;
+        test->has_perf = false;
+        test->has_placement = false;
+        test->has_load = false;
+        if (test->profile != NULL) free(test->profile);
+        test->profile = NULL;
+}
+
+bool read_full(const int fd, void *buf, size_t count) {
+        char *pos = buf;
+
+        while (count > 0) {
+                ssize_t n = read(fd, pos, count);
+                if (n == 0) return false;
+                if (n == -1) {
+                        if (errno == EINTR) continue;
+                        return false;
+                }
+
+                pos += n;
+                count -= n;
+        }
+
+        return true;
+}
+
+bool write_full(const int fd, const void *buf, size_t count) {
+        const char *pos = buf;
+
+        while (count > 0) {
+                ssize_t n = write(fd, pos, count);
+                if (n == -1) {
+                        if (errno == EINTR) continue;
+                        return false;
+                }
+
+                pos += n;
+                count -= n;
+        }
+
+        return true;
+}
+
+struct check_buffer *lock_check_buffer(struct test *test) {
+        unsigned long gen;
+        struct check_buffer *buffer;
+
+        pthread_mutex_lock(&test->buffers_lock);
+        gen = test->buffers_gen;
+        if (thread_buffer_test == test && thread_buffer_gen == gen) {
+                return thread_buffer;
+        }
+
+        buffer = malloc(sizeof(struct check_buffer));
+        if (buffer == NULL) {
+                pthread_mutex_unlock(&test->buffers_lock);
+                return NULL;
+        }
+        buffer->checks = NULL;
+        buffer->next = test->buffers;
+        test->buffers = buffer;
+
+        thread_buffer = buffer;
+        thread_buffer_test = test;
+        thread_buffer_gen = gen;
+
+        return buffer;
+}
+
+void merge_check_buffers(struct test *test) {
+        struct check_buffer *buffer;
+
+        pthread_mutex_lock(&test->buffers_lock);
+        buffer = test->buffers;
+        test->buffers = NULL;
+        if (buffer != NULL) {
+                /* Invalidate the buffers kept by threads. */
+                test->buffers_gen = ATOMIC_ADD(buffers_gen_counter, 1) + 1;
+        }
+        pthread_mutex_unlock(&test->buffers_lock);
+
+        if (buffer == NULL) return;
+
+        while (buffer != NULL) {
+                struct check_buffer *next = buffer->next;
+
+                test->checks = g_list_concat(buffer->checks, test->checks);
+                free(buffer);
+                buffer = next;
+        }
+
+        test->checks = g_list_sort(test->checks, &compare_checks);
+}
+
+gint compare_checks(gconstpointer a, gconstpointer b) {
+        const struct check *check_a = a, *check_b = b;
+
+        if (check_a->check_num == check_b->check_num) return 0;
+        return check_a->check_num > check_b->check_num ? -1 : 1;
+}
+
+void drain_output(uc_run run, struct slot *slot) {
+        char buf[4096];
+        ssize_t n;
+
+        if (slot->output_fd == -1) return;
+
+        while ((n = read(slot->output_fd, buf, sizeof(buf))) != 0) {
+                if (n == -1) {
+                        if (errno == EINTR) continue;
+                        /* EAGAIN: nothing more for now. */
+                        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                        break;
+                }
+
+                output_ring_append(&slot->output_ring, buf, n);
+        }
+
+        epoll_ctl(run->poll_fd, EPOLL_CTL_DEL, slot->output_fd, NULL);
+        close(slot->output_fd);
+        slot->output_fd = -1;
+}
+
+void attach_output(uc_run run, struct slot *slot, struct test *test) {
+        struct output_ring *ring = &slot->output_ring;
+        bool passed;
+
+        drain_output(run, slot);
+
+        passed = !test->run_failed && test->num_succ == test->num_checks;
+        if (ring->len > 0 &&
+            !(passed &&
+              run->suite->options & UC_OPT_DISCARD_PASSING_OUTPUT)) {
+                size_t first;
+
+                if (test->output != NULL) free(test->output);
+                test->output = malloc(ring->len + 1);
+                if (test->output == NULL) {
+                        fputs("uc_run_tests: cannot save output.\n", stderr);
+                } else {
+                        /* The ring may wrap around. */
+                        first = ring->capacity - ring->start;
+                        if (first > ring->len) first = ring->len;
+                        memcpy(test->output, ring->data + ring->start, first);
+                        memcpy(test->output + first, ring->data,
+                               ring->len - first);
+                        test->output[ring->len] = '\0';
+                        test->output_len = ring->len;
+                        test->output_dropped = ring->dropped;
+                }
+        }
+
+        ring->start = 0;
+        ring->len = 0;
+        ring->dropped = 0;
+}
+
+void output_ring_append(struct output_ring *ring, const char *buf,
+                        size_t len) {
+        if (ring->capacity == 0) {
+                ring->dropped += len;
+                return;
+        }
+
+        if (ring->data == NULL) {
+                ring->data = malloc(ring->capacity);
+                if (ring->data == NULL) {
+                        ring->dropped += len;
+                        return;
+                }
+        }
+
+        /* Only the last capacity bytes of buf can be kept. */
+        if (len > ring->capacity) {
+                ring->dropped += ring->len + len - ring->capacity;
+                buf += len - ring->capacity;
+                len = ring->capacity;
+                ring->start = 0;
+                ring->len = 0;
+        }
+
+        while (len > 0) {
+                size_t end = (ring->start + ring->len) % ring->capacity;
+                size_t chunk = ring->capacity - end;
+
+                if (chunk > len) chunk = len;
+                memcpy(ring->data + end, buf, chunk);
+
+                if (ring->len + chunk > ring->capacity) {
+                        size_t overflow = ring->len + chunk - ring->capacity;
+
+                        ring->start = (ring->start + overflow) %
+                                      ring->capacity;
+                        ring->len -= overflow;
+                        ring->dropped += overflow;
+                }
+
+                ring->len += chunk;
+                buf += chunk;
+                len -= chunk;
+        }
+}
+
+void install_crash_handlers(void) {
+        static char stack[CRASH_STACK_SIZE];
+        struct sigaction action;
+        stack_t alt_stack;
+        void *frame;
+
+        /* The first call may load libgcc, which is not async-signal-safe. */
+        backtrace(&frame, 1);
+
+        /* Stack overflows need a stack of their own. */
+        alt_stack.ss_sp = stack;
+        alt_stack.ss_size = sizeof(stack);
+        alt_stack.ss_flags = 0;
+        sigaltstack(&alt_stack, NULL);
+
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = &crash_handler;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+
+        for (size_t i = 0; i < NUM_CRASH_SIGNALS; ++i) {
+                sigaction(crash_signals[i], &action, NULL);
+        }
+}
+
+void reset_crash_handlers(void) {
+        for (size_t i = 0; i < NUM_CRASH_SIGNALS; ++i) {
+                signal(crash_signals[i], SIG_DFL);
+        }
+}
+
+void crash_handler(int signal, siginfo_t *info, void *context) {
+        static const char crash_tag = RECORD_CRASH;
+        static const char end = RECORD_END;
+        struct test *test = crash_test;
+        void *frames[MAX_CRASH_FRAMES];
+        struct check *last_check;
+        uintptr_t address;
+        int num_frames;
+        int fd = crash_fd;
+
+        (void)context;
+
+        /* The default action is restored (SA_RESETHAND) - raise the signal
+         * again once done.
+         */
+        if (test == NULL || fd == -1 || in_write_results) {
+                raise(signal);
+                return;
+        }
+
+        /* Keep the checks made so far. Errors don't matter any more. */
+        for (GList *curr = g_list_last(test->checks); curr != NULL;
+             curr = curr->prev) {
+                if (!write_check(curr->data, fd, false)) break;
+        }
+
+        address = (uintptr_t)info->si_addr;
+        last_check = test->checks != NULL ? test->checks->data : NULL;
+
+        /* Leave out this handler and the signal trampoline. */
+        num_frames = backtrace(frames, MAX_CRASH_FRAMES);
+        if (num_frames > 2) {
+                num_frames -= 2;
+                memmove(frames, frames + 2, sizeof(void *) * num_frames);
+        }
+
+        if (write_full(fd, &crash_tag, sizeof(char)) &&
+            write_full(fd, &signal, sizeof(int)) &&
+            write_full(fd, &address, sizeof(uintptr_t)) &&
+            write_full(fd, &test->num_checks, sizeof(unsigned int)) &&
+            write_comment(last_check != NULL ? last_check->comment : NULL,
+                          fd, false) &&
+            write_full(fd, &num_frames, sizeof(int)) &&
+            write_full(fd, frames, sizeof(void *) * num_frames)) {
+                write_full(fd, &end, sizeof(char));
+        }
+
+        raise(signal);
+}
+
+bool init_profile(void) {
+        profile_frames = malloc(sizeof(void *) * MAX_PROFILE_SAMPLES *
+                                MAX_PROFILE_FRAMES);
+        profile_depths = malloc(sizeof(int) * MAX_PROFILE_SAMPLES);
+        if (profile_frames == NULL || profile_depths == NULL) {
+                free_profile();
+                return false;
+        }
+
+        /* Also loads libgcc, as backtrace is not async-signal-safe until
+         * it has.
+         */
+        profile_base_depth = backtrace(profile_base, MAX_PROFILE_FRAMES);
+
+        return true;
+}
+
+void free_profile(void) {
+        free(profile_frames);
+        free(profile_depths);
+        profile_frames = NULL;
+        profile_depths = NULL;
+}
+
+void start_profile(void) {
+        struct itimerval timer;
+        struct sigaction action;
+
+        profile_next = 0;
+
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = &profile_handler;
+        /* Don't interrupt the test's system calls. */
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, NULL);
+
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = PROFILE_INTERVAL_US;
+        timer.it_value = timer.it_interval;
+        setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+void stop_profile(void) {
+        struct itimerval timer;
+
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, NULL);
+        /* Discards a sample already pending. */
+        signal(SIGPROF, SIG_IGN);
+}
+
+void profile_handler(int signal) {
+        int saved_errno = errno;
+        /* Threads of the test may take samples at once. */
+        unsigned long i = ATOMIC_ADD(profile_next, 1);
+
+        (void)signal;
+
+        if (i < MAX_PROFILE_SAMPLES) {
+                profile_depths[i] = backtrace(profile_frames +
+                                              i * MAX_PROFILE_FRAMES,
+                                              MAX_PROFILE_FRAMES);
+        }
+
+        errno = saved_errno;
+}
+
+bool write_profile(const int wr_fd) {
+        unsigned long num_samples = profile_next;
+        uint32_t num_kept = num_samples < MAX_PROFILE_SAMPLES ?
+                            num_samples : MAX_PROFILE_SAMPLES;
+        uint32_t num_stacks = 0, *order;
+        order = malloc(sizeof(uint32_t) * (num_kept > 0 ? num_kept : 1));
+        if (order == NULL) return false;
+
+        for (uint32_t i = 0; i < num_kept; ++i) {
+                void **frames = profile_frames + i * MAX_PROFILE_FRAMES;
+                int depth = profile_depths[i];
+
+                /* Leave out the handler and the signal trampoline. */
+                depth = depth > 2 ? depth - 2 : 0;
+                memmove(frames, frames + 2, sizeof(void *) * depth);
+
+                /* And run_test_child and its callers, unless the sample is
+                 * of another thread or was cut short.
+                 */
+                if (profile_depths[i] < MAX_PROFILE_FRAMES) {
+                        int num_callers = 0;
+
+                        while (num_callers < depth &&
+                               num_callers < profile_base_depth &&
+                               frames[depth - 1 - num_callers] ==
+                               profile_base[profile_base_depth - 1 -
+                                            num_callers]) {
+                                ++num_callers;
+                        }
+                        if (num_callers > 0 && depth > num_callers + 1) {
+                                depth -= num_callers + 1;
+                        }
+                }
+
+                profile_depths[i] = depth;
+                order[i] = i;
+        }
+
+        /* Identical stacks are sent once. */
+        qsort(order, num_kept, sizeof(uint32_t), &compare_samples);
+        for (uint32_t i = 0; i < num_kept; ++i) {
+                if (i == 0 || compare_samples(&order[i - 1], &order[i]) != 0) {
+                        ++num_stacks;
+                }
+        }
+
+        TRY_RW(write, wr_fd, &num_samples, sizeof(unsigned long),
+               { free(order); return false; });
+        TRY_RW(write, wr_fd, &num_stacks, sizeof(uint32_t),
+               { free(order); return false; });
+        for (uint32_t i = 0, count; i < num_kept; i += count) {
+                int depth = profile_depths[order[i]];
+
+                count = 1;
+                while (i + count < num_kept &&
+                       compare_samples(&order[i], &order[i + count]) == 0) {
+                        ++count;
+                }
+
+                TRY_RW(write, wr_fd, &count, sizeof(uint32_t),
+                       { free(order); return false; });
+                TRY_RW(write, wr_fd, &depth, sizeof(int),
+                       { free(order); return false; });
+                TRY_RW(write, wr_fd,
+                       profile_frames + order[i] * MAX_PROFILE_FRAMES,
+                       sizeof(void *) * depth, { free(order); return false; });
+        }
+
+        free(order);
+        return true;
+}
+
+int compare_samples(const void *a, const void *b) {
+        uint32_t i = *(const uint32_t *)a, j = *(const uint32_t *)b;
+
+        if (profile_depths[i] != profile_depths[j]) {
+                return profile_depths[i] < profile_depths[j] ? -1 : 1;
+        }
+
+        return memcmp(profile_frames + i * MAX_PROFILE_FRAMES,
+                      profile_frames + j * MAX_PROFILE_FRAMES,
+                      sizeof(void *) * profile_depths[i]);
+}
+
+enum results_status read_profile_record(uc_suite suite,
+                                        struct results_buf *buf,
+                                        const bool dry_run) {
+        struct test *test = suite->curr_test->data;
+        void *frames[MAX_PROFILE_FRAMES];
+        struct folded_stack *stacks = NULL;
+        unsigned long num_samples;
+        uint32_t num_stacks, num_folded = 0;
+        FILE *out;
+        char *text = NULL;
+        size_t len = 0;
+
+        TAKE(buf, &num_samples, sizeof(unsigned long));
+        TAKE(buf, &num_stacks, sizeof(uint32_t));
+
+        if (!dry_run) {
+                stacks = malloc(sizeof(struct folded_stack) *
+                                (num_stacks > 0 ? num_stacks : 1));
+                if (stacks == NULL) return RESULTS_INVALID;
+        }
 
-        ALLOC_STRING(name, suite->name, { uc_free(suite); return NULL; });
-        ALLOC_STRING(comment, suite->comment, { uc_free(suite); return NULL; });
+        /* Only the dry run can find the record incomplete or invalid. */
+        for (uint32_t i = 0; i < num_stacks; ++i) {
+                struct folded_stack *stack;
+                char **symbols;
+                size_t frames_len;
+                uint32_t count;
+                int depth;
 
-        /* Add a test for all checks made outside a test. */
-        uc_add_test(suite, NULL, NULL, NULL);
-        suite->curr_test = g_list_last(suite->tests);
+                TAKE(buf, &count, sizeof(uint32_t));
+                TAKE(buf, &depth, sizeof(int));
+                if (depth < 0 || depth > MAX_PROFILE_FRAMES) {
+                        return RESULTS_INVALID;
+                }
+                TAKE(buf, frames, sizeof(void *) * depth);
+                if (dry_run) continue;
 
-        return suite;
+                stack = &stacks[num_folded];
+                stack->count = count;
+                out = open_memstream(&stack->frames, &frames_len);
+                if (out == NULL) continue;
+
+                /* The test process was forked from this one, so its code is
+                 * at the same addresses here.
+                 */
+                symbols = depth > 0 ? backtrace_symbols(frames, depth) : NULL;
+                for (int j = depth - 1; j >= 0; --j) {
+                        if (symbols != NULL) {
+                                output_frame(out, symbols[j]);
+                        } else {
+                                fprintf(out, "%p", frames[j]);
+                        }
+                        if (j > 0) fputc(';', out);
+                }
+                if (depth == 0) fputs("[unknown]", out);
+                if (symbols != NULL) free(symbols);
+
+                if (fclose(out) == 0) ++num_folded;
+        }
+
+        if (dry_run) return RESULTS_OK;
+
+        qsort(stacks, num_folded, sizeof(struct folded_stack),
+              &compare_folded_stacks);
+        out = open_memstream(&text, &len);
+        for (uint32_t i = 0, j; i < num_folded; i = j) {
+                unsigned long count = 0;
+
+                for (j = i; j < num_folded &&
+                            strcmp(stacks[i].frames, stacks[j].frames) == 0;
+                     ++j) {
+                        count += stacks[j].count;
+                }
+                if (out != NULL) {
+                        fprintf(out, "%s %lu\n", stacks[i].frames, count);
+                }
+        }
+        if (out != NULL && num_samples > MAX_PROFILE_SAMPLES) {
+                fprintf(out, "[dropped] %lu\n",
+                        num_samples - MAX_PROFILE_SAMPLES);
+        }
+
+        for (uint32_t i = 0; i < num_folded; ++i) free(stacks[i].frames);
+        free(stacks);
+
+        if (out == NULL || fclose(out) != 0) {
+                free(text);
+                return RESULTS_INVALID;
+        }
+
+        if (test->profile != NULL) free(test->profile);
+        test->profile = text;
+        test->profile_len = len;
+
+        return RESULTS_OK;
 }
 
-void uc_free(uc_suite suite) {
-        if (suite == NULL) return;
-        if (suite->name != NULL) free(suite->name);
-        if (suite->comment != NULL) free(suite->comment);
+int compare_folded_stacks(const void *a, const void *b) {
+        return strcmp(((const struct folded_stack *)a)->frames,
+                      ((const struct folded_stack *)b)->frames);
+}
 
-        g_list_free_full(suite->tests, &struct_test_free);
+void output_frame(FILE *out, const char *symbol) {
+        /* Of the form "module(function+offset) [address]". */
+        const char *open = strchr(symbol, '(');
+        const char *close = open != NULL ? strchr(open, ')') : NULL;
+        const char *start = symbol, *end = symbol + strlen(symbol);
 
-        free(suite);
+        if (open != NULL && close != NULL) {
+                const char *plus = memchr(open, '+', close - open);
+                const char *name_end = plus != NULL ? plus : close;
+
+                if (name_end > open + 1) {
+                        start = open + 1;
+                        end = name_end;
+                } else {
+                        /* No name: the module and offset, for addr2line. */
+                        const char *base = symbol;
+
+                        for (const char *c = symbol; c < open; ++c) {
+                                if (*c == '/') base = c + 1;
+                        }
+                        for (const char *c = base; c < open; ++c) {
+                                fputc(*c == ' ' || *c == ';' ? '_' : *c, out);
+                        }
+                        start = open + 1;
+                        end = close;
+                }
+        }
+
+        /* Spaces and semicolons separate folded stacks' fields. */
+        for (const char *c = start; c < end; ++c) {
+                fputc(*c == ' ' || *c == ';' ? '_' : *c, out);
+        }
 }
 
-void uc_check(uc_suite suite, const bool cond, const char *comment) {
-        if (suite == NULL) return;
-        struct check *check;
-        struct test *curr_test;
+void write_profiles(uc_suite suite) {
+        if (mkdir(suite->profile_dir, 0777) == -1 && errno != EEXIST) {
+                fprintf(stderr, "uc_run_tests: cannot create %s.\n",
+                        suite->profile_dir);
+        }
 
-        curr_test = (struct test *)suite->curr_test->data;
+        for (GList *curr = suite->tests; curr != NULL; curr = curr->next) {
+                struct test *test = curr->data;
+                char path[PATH_MAX], buf[32];
+                const char *key;
+                size_t len;
 
-        check = malloc(sizeof(struct check));
-        if (check == NULL) {
-                fprintf(stderr, "uc_check: failure to check: %s\n",
-                        comment == NULL ? "no comment provided." : comment);
-                return;
+                if (test->profile == NULL) continue;
+
+                key = test_key(test, buf);
+                len = snprintf(path, sizeof(path), "%s/",
+                               suite->profile_dir);
+                /* Test names are not all valid file names. */
+                for (const char *c = key; *c != '\0' && len < PATH_MAX - 8;
+                     ++c) {
+                        path[len++] = isalnum((unsigned char)*c) ||
+                                      *c == '-' || *c == '.' ? *c : '_';
+                }
+                strcpy(path + len, ".folded");
+
+                if (!write_snapshot(test->profile, test->profile_len, path)) {
+                        fprintf(stderr, "uc_run_tests: cannot write %s.\n",
+                                path);
+                }
+
+                free(test->profile);
+                test->profile = NULL;
         }
+}
+
+void open_perf_counters(int fds[NUM_COUNTERS]) {
+        struct perf_event_attr attr;
 
-        ++suite->num_checks;
-        ++curr_test->num_checks;
-        if (cond) {
-                ++suite->num_succ;
-                ++curr_test->num_succ;
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = perf_counters[i].type;
+                attr.config = perf_counters[i].config;
+                attr.disabled = 1;
+                /* Count threads the test creates too. */
+                attr.inherit = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                 PERF_FLAG_FD_CLOEXEC);
+                if (fds[i] == -1 && (errno == EACCES || errno == EPERM)) {
+                        /* Unprivileged processes may only count user
+                         * space.
+                         */
+                        attr.exclude_kernel = 1;
+                        fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1,
+                                         -1, PERF_FLAG_FD_CLOEXEC);
+                }
         }
+}
 
-        ALLOC_STRING(comment, check->comment,
-                     { fprintf(stderr,
-                               "uc_check: failure to save comment: %s\n",
-                               comment); });
+void start_perf_counters(const int fds[NUM_COUNTERS]) {
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+                if (fds[i] == -1) continue;
+                ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
 
-        check->result = cond;
-        check->check_num = curr_test->num_checks;
+void stop_perf_counters(const int fds[NUM_COUNTERS],
+                        struct perf_counts *counts) {
+        counts->available = 0;
+
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+                /* Value, time enabled and time running. */
+                uint64_t read_buf[3];
+
+                counts->values[i] = 0;
+                if (fds[i] == -1) continue;
 
-        curr_test->checks = g_list_prepend(curr_test->checks, check);
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                if (!read_full(fds[i], read_buf, sizeof(read_buf))) continue;
+                /* Never scheduled onto the PMU. */
+                if (read_buf[2] == 0) continue;
+
+                /* Scale up counts multiplexed with other events. */
+                counts->values[i] = read_buf[2] == read_buf[1] ? read_buf[0] :
+                        (uint64_t)((double)read_buf[0] * read_buf[1] /
+                                   read_buf[2]);
+                counts->available |= 1u << i;
+        }
 }
 
-void uc_add_test(uc_suite suite, void (*test_func)(uc_suite suite),
-                 const char *name, const char *comment) {
-        struct test *test;
-        test = malloc(sizeof(struct test));
-        if (test == NULL) {
-                fprintf(stderr, "uc_add_test: failure to add test: %s\n",
-                        comment == NULL ? "no name provided." : name);
+void resolve_cpus(uc_suite suite) {
+        cpu_set_t allowed;
+        int cpus[CPU_SETSIZE];
+        size_t num_cpus = 0;
+
+        if (!(suite->options & UC_OPT_PIN_CPUS) || suite->num_cpus > 0) {
                 return;
         }
 
-        ALLOC_STRING(name, test->name,
-                     { fprintf(stderr,
-                               "uc_add_test: failure to save name: %s\n",
-                               name); });
-        ALLOC_STRING(comment, test->comment,
-                     { fprintf(stderr,
-                               "uc_add_test: failure to save comment: %s\n",
-                               comment); });
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+                fputs("uc_run_tests: cannot get CPUs, not pinning tests.\n",
+                      stderr);
+                return;
+        }
 
-        test->test_func = test_func;
-        test->num_succ = 0;
-        test->num_checks = 0;
-        test->test_num = suite->num_tests;
-        test->checks = NULL;
+        /* SMT siblings would slow each other's tests down. */
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed) && first_sibling(cpu, &allowed)) {
+                        cpus[num_cpus++] = cpu;
+                }
+        }
 
-        ++suite->num_tests;
-        suite->tests = g_list_prepend(suite->tests, test);
+        uc_set_cpus(suite, cpus, num_cpus);
 }
 
-void uc_run_tests(uc_suite suite) {
-        /* Guaranteed to have at least one element from uc_init. */
-        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
-             curr = curr->prev) {
-                int ipc_pipe[2];
-                struct test *test;
-                pid_t pid;
+bool first_sibling(const int cpu, const cpu_set_t *allowed) {
+        char path[80], list[256];
+        const char *pos = list;
+        FILE *file;
 
-                if (pipe(ipc_pipe) == -1) {
-                        fputs("uc_run_tests: cannot create pipe,"
-                              "not running test.\n", stderr);
-                        continue;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+                 cpu);
+        file = fopen(path, "r");
+        if (file == NULL) return true;
+        if (fgets(list, sizeof(list), file) == NULL) list[0] = '\0';
+        fclose(file);
+
+        /* E.g. "0,4" or "0-1". */
+        while (isdigit((unsigned char)*pos)) {
+                char *end;
+                long first = strtol(pos, &end, 10), last = first;
+
+                if (*end == '-') last = strtol(end + 1, &end, 10);
+                for (long sibling = first; sibling <= last && sibling < cpu;
+                     ++sibling) {
+                        if (CPU_ISSET(sibling, allowed)) return false;
                 }
 
-                suite->curr_test = curr;
-                test = curr->data;
+                if (*end != ',') break;
+                pos = end + 1;
+        }
 
-                pid = fork();
-                if (pid == -1) {
-                        fputs("uc_run_tests: cannot create process.\n", stderr);
-                } else if (pid == 0) {
-                        close(ipc_pipe[R]);
-                        if (test->test_func != NULL) test->test_func(suite);
+        return true;
+}
 
-                        write_test_results(test, ipc_pipe[WR]);
+bool place_test_process(uc_suite suite, const unsigned int slot,
+                        struct placement *placement) {
+        placement->cpu = -1;
+        placement->policy = -1;
+        placement->priority = 0;
 
-                        uc_free(suite);
-                        close(ipc_pipe[WR]);
-                        exit(EXIT_SUCCESS);
-                } else {
-                        int wstatus;
-                        if (waitpid(pid, &wstatus, 0) == -1) {
-                                fputs("uc_run_tests: error creating process.\n",
-                                      stderr);
-                                continue;
-                        } else if (WIFSIGNALED(wstatus)) {
-                                /* The writing process called abort(). Don't
-                                 * even try to read.
-                                 */
-                                fputs("uc_run_tests: test failed to run.\n",
-                                      stderr);
-                        } else {
-                                if (!read_test_results(suite, ipc_pipe[R])) {
-                                        /* Information may be incomplete.
-                                         * Delete it all.
-                                         */
-                                        fputs("uc_run_tests: test failed to run"
-                                              ".\n", stderr);
-                                        g_list_free_full(test->checks,
-                                                        &struct_check_free);
-                                        test->checks = NULL;
-                                        test->num_succ = 0;
-                                        test->num_checks = 0;
-                                }
-                        }
+        if (suite->num_cpus == 0 && suite->rt_priority <= 0 &&
+            !suite->has_nice) {
+                return false;
+        }
+
+        if (suite->num_cpus > 0) {
+                /* Processes running at once are in different slots. */
+                int cpu = suite->cpus[slot % suite->num_cpus];
+                cpu_set_t set;
 
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+                        placement->cpu = cpu;
+                } else {
+                        fprintf(stderr, "uc_run_tests: cannot pin test to "
+                                "CPU %d.\n", cpu);
                 }
+        }
 
-                /* child process which closes these will never reach here. */
-                if (close(ipc_pipe[R]) == -1) {
-                        fputs("uc_run_tests: cannot close read end of pipe.\n",
+        if (suite->rt_priority > 0) {
+                struct sched_param param;
+
+                memset(&param, 0, sizeof(param));
+                param.sched_priority = suite->rt_priority;
+                if (sched_setscheduler(0, SCHED_FIFO, &param) == 0) {
+                        placement->policy = SCHED_FIFO;
+                        placement->priority = suite->rt_priority;
+                } else {
+                        fputs("uc_run_tests: cannot use SCHED_FIFO.\n",
                               stderr);
                 }
-
-                if (close(ipc_pipe[WR]) == -1) {
-                        fputs("uc_run_tests: cannot close write end of pipe.\n",
+        } else if (suite->has_nice) {
+                if (setpriority(PRIO_PROCESS, 0, suite->nice) == 0) {
+                        placement->policy = SCHED_OTHER;
+                        placement->priority = suite->nice;
+                } else {
+                        fputs("uc_run_tests: cannot set nice level.\n",
                               stderr);
                 }
         }
 
-        /* Reset curr_test to account for "dangling checks". */
-        suite->curr_test = g_list_last(suite->tests);
+        return true;
 }
 
-bool uc_all_tests_passed(uc_suite suite) {
-        if (suite == NULL) return false;
+bool heap_counted(void) {
+        /* Checked first so threads outside tests never touch heap_paused. */
+        return __atomic_load_n(&heap_counting, __ATOMIC_RELAXED) &&
+               !heap_paused;
+}
 
-        for (GList *curr = suite->tests; curr != NULL; curr = curr->next) {
-                struct test *test = curr->data;
-                if (test->num_succ != test->num_checks) return false;
+void heap_start(void) {
+        memset(&heap_stats, 0, sizeof(heap_stats));
+        pthread_mutex_lock(&heap_blocks_lock);
+        if (heap_blocks != NULL) {
+                memset(heap_blocks, 0,
+                       heap_blocks_size * sizeof(struct heap_block));
         }
+        heap_blocks_used = 0;
+        heap_blocks_live = 0;
+        pthread_mutex_unlock(&heap_blocks_lock);
+        __atomic_store_n(&heap_counting, true, __ATOMIC_RELAXED);
+}
 
-        return true;
+void heap_count_alloc(void *ptr, const size_t size, const bool resized,
+                      const size_t old_size) {
+        long live_bytes, peak_bytes, delta = (long)size - (long)old_size;
+
+        if (ptr == NULL || !add_heap_block(ptr, size)) return;
+
+        ATOMIC_ADD(heap_stats.allocs, 1);
+        if (!resized) ATOMIC_ADD(heap_stats.live_blocks, 1);
+        ATOMIC_ADD(heap_stats.bytes, size);
+        live_bytes = ATOMIC_ADD(heap_stats.live_bytes, delta) + delta;
+
+        peak_bytes = __atomic_load_n(&heap_stats.peak_bytes, __ATOMIC_RELAXED);
+        while (live_bytes > peak_bytes &&
+               !__atomic_compare_exchange_n(&heap_stats.peak_bytes,
+                                            &peak_bytes, live_bytes, true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED));
 }
 
-void uc_report_basic(uc_suite suite) {
-        if (suite == NULL) return;
+void heap_count_free(void *ptr) {
+        size_t size;
 
-        output_main_header(suite);
+        if (ptr == NULL || !remove_heap_block(ptr, &size)) return;
 
-        /* Guaranteed to have at least one element from uc_init. */
-        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
-             curr = curr->prev) {
-                output_test_common(curr->data, 1);
-        }
+        ATOMIC_ADD(heap_stats.live_blocks, -1);
+        ATOMIC_ADD(heap_stats.live_bytes, -(long)size);
 }
 
-void uc_report_standard(uc_suite suite) {
-        GList *main_test;
-        if (suite == NULL) return;
+bool add_heap_block(void *ptr, const size_t size) {
+        bool added = false;
 
-        main_test = g_list_last(suite->tests);
+        pthread_mutex_lock(&heap_blocks_lock);
+        /* Kept at most half full, rehashed without the deleted slots. */
+        if ((heap_blocks_used + 1) * 2 > heap_blocks_size) {
+                struct heap_block *old_blocks = heap_blocks;
+                size_t old_size = heap_blocks_size;
+                size_t new_size = MIN_HEAP_BLOCKS;
+                struct heap_block *blocks;
 
-        output_main_header(suite);
-        output_test_failures(main_test->data, 1);
+                while (new_size < (heap_blocks_live + 1) * 4) new_size *= 2;
+                blocks = mmap(NULL, new_size * sizeof(struct heap_block),
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (blocks != MAP_FAILED) {
+                        heap_blocks = blocks;
+                        heap_blocks_size = new_size;
+                        heap_blocks_used = heap_blocks_live;
+                        for (size_t i = 0; i < old_size; ++i) {
+                                if (old_blocks[i].ptr <= HEAP_BLOCK_DELETED) {
+                                        continue;
+                                }
+                                blocks[find_heap_block(old_blocks[i].ptr)] =
+                                        old_blocks[i];
+                        }
+                        if (old_blocks != NULL) {
+                                munmap(old_blocks, old_size *
+                                                   sizeof(struct heap_block));
+                        }
+                }
+        }
 
-        /* Guaranteed to have at least one element from uc_init. */
-        for (GList *curr = g_list_last(suite->tests)->prev; curr != NULL;
-             curr = curr->prev) {
-                output_test_common(curr->data, 1);
-                output_test_failures(curr->data, 2);
+        if ((heap_blocks_used + 1) * 2 <= heap_blocks_size) {
+                size_t slot = find_heap_block((uintptr_t)ptr);
+
+                if (heap_blocks[slot].ptr == HEAP_BLOCK_FREE) {
+                        heap_blocks[slot].ptr = (uintptr_t)ptr;
+                        ++heap_blocks_used;
+                        ++heap_blocks_live;
+                }
+                heap_blocks[slot].size = size;
+                added = true;
         }
-}
+        pthread_mutex_unlock(&heap_blocks_lock);
 
-void output_indent(const unsigned int level) {
-        for (unsigned int i = 0; i < level; ++i) printf(INDENTATION);
+        return added;
 }
 
-void output_checks_fraction(const unsigned int succ, const unsigned int total,
-                            const unsigned int indent) {
-        output_indent(indent);
-        printf("Successful checks: %u/%u.\n", succ, total);
-}
+bool remove_heap_block(void *ptr, size_t *size) {
+        bool found = false;
 
-void output_test_common(struct test *test, const unsigned int indent) {
-        if (test == NULL) return;
+        pthread_mutex_lock(&heap_blocks_lock);
+        if (heap_blocks != NULL) {
+                size_t slot = find_heap_block((uintptr_t)ptr);
 
-        puts("");
+                if (heap_blocks[slot].ptr == (uintptr_t)ptr) {
+                        heap_blocks[slot].ptr = HEAP_BLOCK_DELETED;
+                        *size = heap_blocks[slot].size;
+                        --heap_blocks_live;
+                        found = true;
+                }
+        }
+        pthread_mutex_unlock(&heap_blocks_lock);
 
-        output_indent(indent);
-        test->name != NULL ? puts(test->name) :
-                             printf("Test #%u\n", test->test_num);
+        return found;
+}
 
-        if (test->comment != NULL) {
-                output_indent(indent);
-                puts(test->comment);
+size_t find_heap_block(const uintptr_t ptr) {
+        size_t mask = heap_blocks_size - 1;
+        /* Blocks are 16 byte aligned, so the low bits say nothing. */
+        size_t slot = (size_t)(((uint64_t)ptr >> 4) *
+                               UINT64_C(0x9e3779b97f4a7c15) >> 32) & mask;
+
+        while (heap_blocks[slot].ptr != ptr &&
+               heap_blocks[slot].ptr != HEAP_BLOCK_FREE) {
+                slot = (slot + 1) & mask;
         }
 
-        output_checks_fraction(test->num_succ, test->num_checks, indent + 1);
+        return slot;
 }
 
-void output_test_failures(struct test *test, const unsigned int indent) {
-        if (test == NULL) return;
+/* The allocator seen by the whole process. Each function forwards to the C
+ * library's, counting for UC_OPT_HEAP_STATS.
+ */
 
-        for (GList *curr = g_list_last(test->checks); curr != NULL;
-             curr = curr->prev) {
-                struct check *check;
-                char *comment;
+void *malloc(size_t size) {
+        void *ptr = __libc_malloc(size);
 
-                check = curr->data;
-                /* Print nothing for successful checks. */
-                if (check->result) continue;
+        if (heap_counted()) heap_count_alloc(ptr, size, false, 0);
 
-                comment = check->comment;
+        return ptr;
+}
 
-                output_indent(indent);
-                if (comment != NULL) {
-                        printf("Check failed: %s\n", comment);
-                } else {
-                        printf("Check failed: Check #%u.\n", check->check_num);
-                }
-        }
+void *calloc(size_t num, size_t size) {
+        void *ptr = __libc_calloc(num, size);
+
+        /* num * size didn't overflow if ptr isn't NULL. */
+        if (heap_counted()) heap_count_alloc(ptr, num * size, false, 0);
+
+        return ptr;
 }
 
-void output_main_header(uc_suite suite) {
-        struct test *curr_test;
+void *realloc(void *ptr, size_t size) {
+        bool counted = heap_counted();
+        size_t old_size = 0;
+        void *new_ptr;
 
-        if (suite == NULL) return;
+        /* Resizing a block allocated before counting started counts for
+         * nothing. It is removed before the C library can hand its address
+         * to another thread.
+         */
+        if (counted && ptr != NULL && !remove_heap_block(ptr, &old_size)) {
+                counted = false;
+        }
 
-        puts(suite->name != NULL ? suite->name : DEFAULT_SUITE_NAME);
-        if (suite->comment != NULL) puts(suite->comment);
+        new_ptr = __libc_realloc(ptr, size);
+        if (!counted) return new_ptr;
 
-        printf("Total successful checks: %u/%u.\n", suite->num_succ,
-               suite->num_checks);
+        if (ptr == NULL) {
+                heap_count_alloc(new_ptr, size, false, 0);
+        } else if (new_ptr != NULL) {
+                heap_count_alloc(new_ptr, size, true, old_size);
+        } else if (size == 0) {
+                /* realloc(ptr, 0) frees ptr. */
+                ATOMIC_ADD(heap_stats.live_blocks, -1);
+                ATOMIC_ADD(heap_stats.live_bytes, -(long)old_size);
+        } else {
+                /* ptr is left as it was. */
+                add_heap_block(ptr, old_size);
+        }
 
-        curr_test = suite->curr_test->data;
-        output_checks_fraction(curr_test->num_succ, curr_test->num_checks, 1);
+        return new_ptr;
 }
 
-void write_test_results(const struct test *test, const int wr_fd) {
-        static const char non_null = 'X';
-        static const char null = '\0';
+void free(void *ptr) {
+        if (heap_counted()) heap_count_free(ptr);
+        __libc_free(ptr);
+}
 
-        /* Format is defined above prototype. */
-        for (GList *curr = g_list_last(test->checks); curr != NULL;
-             curr = curr->prev) {
-                size_t comment_len;
-                struct check *check;
+void *memalign(size_t alignment, size_t size) {
+        void *ptr = __libc_memalign(alignment, size);
 
-                /* There are still checks to write. */
-                TRY_RW(write, wr_fd, &non_null, sizeof(char), { abort(); });
+        if (heap_counted()) heap_count_alloc(ptr, size, false, 0);
 
-                check = curr->data;
-                TRY_RW(write, wr_fd, &check->result, sizeof(bool),
-                       { abort(); });
+        return ptr;
+}
 
-                if (check->comment != NULL) {
-                        /* Indicate a comment exists. */
-                        TRY_RW(write, wr_fd, &non_null, sizeof(char),
-                               { abort(); });
-                        comment_len = strlen(check->comment);
+void *aligned_alloc(size_t alignment, size_t size) {
+        return memalign(alignment, size);
+}
 
-                        TRY_RW(write, wr_fd, &comment_len, sizeof(size_t),
-                               { abort(); });
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+        void *mem;
 
-                        TRY_RW(write, wr_fd, check->comment,
-                               sizeof(char) * (comment_len + 1), { abort(); });
-                } else TRY_RW(write, wr_fd, &null, sizeof(char), { abort(); });
+        if (alignment % sizeof(void *) != 0 ||
+            (alignment & (alignment - 1)) != 0) {
+                return EINVAL;
         }
 
-        /* No more checks to write. */
-        TRY_RW(write, wr_fd, &null, sizeof(char), { abort(); });
+        mem = memalign(alignment, size);
+        if (mem == NULL) return ENOMEM;
+
+        *ptr = mem;
+        return 0;
 }
 
-bool read_test_results(uc_suite suite, const int r_fd) {
-#define RET_FALSE { return false; }
-        /* Determines whether to continue reading or not. */
-        char check_char;
+void *valloc(size_t size) {
+        void *ptr = __libc_valloc(size);
 
-        /* Format is defined above write_test_results' protoype. */
-        TRY_RW(read, r_fd, &check_char, sizeof(char), RET_FALSE);
-        while (check_char != '\0') {
-                bool result;
-                char *comment, comment_check;
-
-                TRY_RW(read, r_fd, &result, sizeof(bool), RET_FALSE);
-                TRY_RW(read, r_fd, &comment_check, sizeof(char), RET_FALSE);
-
-                if (comment_check == '\0') comment = NULL;
-                else {
-                        size_t comment_len;
-
-                        TRY_RW(read, r_fd, &comment_len, sizeof(size_t),
-                               RET_FALSE);
-
-                        comment = malloc(sizeof(char) * (comment_len + 1));
-                        if (comment != NULL) {
-                                TRY_RW(read, r_fd, comment,
-                                       sizeof(char) * (comment_len + 1),
-                                       { free(comment); return false; });
-                        } else {
-                                char comment_char;
-                                fprintf(stderr, "Cannot save a comment.");
-                                /* Read the comment one char at a time
-                                 * anyway to sync.
-                                 */
-                                TRY_RW(read, r_fd, &comment_char, sizeof(char),
-                                       RET_FALSE);
-                                while (comment_char != '\0') {
-                                        TRY_RW(read, r_fd, &comment_char,
-                                               sizeof(char), RET_FALSE);
-                                }
-                        }
-                }
+        if (heap_counted()) heap_count_alloc(ptr, size, false, 0);
 
-                uc_check(suite, result, comment);
-                if (comment != NULL) free(comment);
+        return ptr;
+}
 
-                TRY_RW(read, r_fd, &check_char, sizeof(char), RET_FALSE);
-        }
+void *pvalloc(size_t size) {
+        void *ptr = __libc_pvalloc(size);
 
-        return true;
-#undef RET_FALSE
+        if (heap_counted()) heap_count_alloc(ptr, size, false, 0);
+
+        return ptr;
 }
 
 void struct_check_free(void *data) {
@@ -509,20 +8821,44 @@ void struct_check_free(void *data) {
 
         check = data;
 
-        if (check->comment != NULL) free(check->comment);
+        if (check->comment != NULL && !check->borrowed) free(check->comment);
 
         free(check);
 }
 
+void struct_crash_free(struct crash *crash) {
+        /* backtrace_symbols returns a single allocation. */
+        if (crash->backtrace != NULL) free(crash->backtrace);
+
+        free(crash);
+}
+
 void struct_test_free(void *data) {
         struct test *test;
         if (data == NULL) return;
 
         test = data;
 
-        if (test->name != NULL) free(test->name);
-        if (test->comment != NULL) free(test->comment);
+        /* A described test's name, comment and memory are not its own. */
+        if (!test->described) {
+                if (test->name != NULL) free(test->name);
+                if (test->comment != NULL) free(test->comment);
+        }
+        if (test->fuzz != NULL) {
+                if (test->fuzz->corpus_dir != NULL) {
+                        free(test->fuzz->corpus_dir);
+                }
+                free(test->fuzz);
+        }
+        if (test->load != NULL) free(test->load);
+        merge_check_buffers(test);
         g_list_free_full(test->checks, &struct_check_free);
+        if (test->output != NULL) free(test->output);
+        if (test->crash != NULL) struct_crash_free(test->crash);
+        if (test->profile != NULL) free(test->profile);
+        g_list_free_full(test->uses, &free);
+        g_list_free(test->prerequisites);
+        pthread_mutex_destroy(&test->buffers_lock);
 
-        free(test);
+        if (!test->described) free(test);
 }
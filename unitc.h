@@ -5,6 +5,7 @@
 #ifndef UNITC_H
 #define UNITC_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -12,6 +13,64 @@
   */
 /**@{*/
 #define UC_OPT_NONE (0) /**< No options set. */
+/** Spawn test processes from a zygote forked at the start of uc_run_tests
+  * rather than from the calling process, so the cost of spawning a test
+  * does not grow with the caller's heap. Group fixtures then run in the
+  * zygote and their checks are not recorded.
+  */
+#define UC_OPT_ZYGOTE (1 << 0)
+/** Run tests on a pool of threads in the calling process instead of in their
+  * own processes. Only for tests which cannot crash or corrupt global state:
+  * tests are not isolated and run at the same time (see uc_set_jobs). The
+  * suite fixture, group fixtures and the per-test fixture are still run.
+  */
+#define UC_OPT_THREADS (1 << 1)
+/** Capture what each test writes to stdout and stderr instead of letting it
+  * reach the terminal. The last bytes of it (see uc_set_output_limit) are
+  * kept and shown by uc_report_standard for failed tests. Ignored with
+  * UC_OPT_THREADS.
+  */
+#define UC_OPT_CAPTURE_OUTPUT (1 << 2)
+/** With UC_OPT_CAPTURE_OUTPUT, don't keep the output of tests which passed.
+  */
+#define UC_OPT_DISCARD_PASSING_OUTPUT (1 << 3)
+/** Count each test's heap use: allocations, bytes allocated, peak live bytes
+  * and blocks left unfreed once the test (and its per-test fixture) returns.
+  * uc_report_standard shows them. For this, libunitc provides malloc, calloc,
+  * realloc, free and the aligned allocation functions; they forward to the C
+  * library's and only count in test processes of suites with this option.
+  * Only blocks allocated while a test runs count: freeing or resizing one
+  * allocated before it started does not. Bytes are those asked for, not
+  * what the allocator rounds them up to. Memory the C library keeps for
+  * itself (e.g. stdio buffers) counts as the test's. Ignored with
+  * UC_OPT_THREADS.
+  */
+#define UC_OPT_HEAP_STATS (1 << 4)
+/** With UC_OPT_HEAP_STATS, add a failed check to tests which leave blocks
+  * unfreed.
+  */
+#define UC_OPT_FAIL_ON_LEAK (1 << 5)
+/** Count task-clock, page-faults, context-switches and cpu-migrations, and
+  * instructions, cycles and cache-misses where the CPU allows, around each
+  * test function with perf_event_open. uc_report_standard shows the counts.
+  * Counters which cannot be opened (no PMU, not permitted) are left out.
+  * Ignored with UC_OPT_THREADS.
+  */
+#define UC_OPT_PERF_COUNTERS (1 << 6)
+/** Pin each test process to one CPU, as uc_set_cpus does, over one CPU of
+  * each core the calling process may run on (SMT siblings are left out),
+  * unless uc_set_cpus gives the CPUs.
+  */
+#define UC_OPT_PIN_CPUS (1 << 7)
+/** With uc_set_repeat, stop repeating a test once one of its runs fails.
+  */
+#define UC_OPT_REPEAT_UNTIL_FAILURE (1 << 8)
+/** Run as many test processes at the same time as uc_set_jobs allows,
+  * starting tests in the order they were added as far as the resources they
+  * use (uc_test_uses) and the tests they run after (uc_test_after) allow.
+  * Ignored with UC_OPT_THREADS.
+  */
+#define UC_OPT_PARALLEL (1 << 9)
 /**@}*/
 
 /** A uc_suite carries specified options, tests, successes/failures, and
@@ -19,6 +78,18 @@
   */
 typedef struct uc_suite *uc_suite;
 
+/** A uc_run is a run of a suite's tests started by uc_run_tests_async. */
+typedef struct uc_run *uc_run;
+
+/** A uc_prop is a case of a property being checked by uc_check_property,
+  * from which the property generates its inputs.
+  */
+typedef struct uc_prop *uc_prop;
+
+/** A uc_registry holds test suites, and their sub-suites, whose tests are
+  * run together by uc_registry_run.
+  */
+typedef struct uc_registry *uc_registry;
 
 /** Create a test suite with the specified options.
   *
@@ -30,7 +101,7 @@ typedef struct uc_suite *uc_suite;
   *
   * @return A uc_suite with options specified by options or NULL on error.
   */
-uc_suite uc_init(const uint_least8_t options, const char *name,
+uc_suite uc_init(const uint_least32_t options, const char *name,
                  const char *comment);
 
 /** Free a test suite. Using suite after this call results in undefined
@@ -49,9 +120,109 @@ void uc_free(uc_suite suite);
   * @param comment Information about what is being checked. No other
   *                information about a check is available in (applicable)
   *                reports. Can be omitted by passing NULL.
+  *
+  * Tests may call uc_check from several threads at once. Checks made by
+  * threads other than the one running the test are numbered in the order
+  * they were made. With UC_OPT_THREADS, such checks count as dangling checks.
   */
 void uc_check(uc_suite suite, const bool cond, const char *comment);
 
+/** Like uc_check, but comment is used in place rather than copied, so it must
+  * stay valid and unchanged for as long as suite is used - normally a string
+  * literal. Meant for checks made in loops.
+  *
+  * Whichever is used, test processes send each distinct comment once and the
+  * suite keeps one copy of it however many checks share it.
+  *
+  * @param suite   Test suite in which the check belongs to.
+  * @param cond    The condition to check.
+  * @param comment Information about what is being checked, or NULL.
+  */
+void uc_check_borrowed(uc_suite suite, const bool cond, const char *comment);
+
+/** Check that len bytes of buf are the same as the golden file at path.
+  *
+  * Files are mapped and compared a chunk at a time, so large ones are cheap.
+  * If they differ, the failed check's comment gives the first differing byte
+  * and its line, with the text around it in both. If the environment
+  * variable UC_UPDATE_SNAPSHOTS is 1, the golden file is replaced by buf
+  * instead, and the check passes.
+  *
+  * @param suite Test suite in which the check belongs to.
+  * @param buf   Output to check.
+  * @param len   Number of bytes of buf.
+  * @param path  Path of the golden file.
+  * @return Whether buf matched (or the golden file was replaced).
+  */
+bool uc_check_snapshot(uc_suite suite, const void *buf, const size_t len,
+                       const char *path);
+
+/** Like uc_check_snapshot, for the contents of the file at path.
+  *
+  * @param suite       Test suite in which the check belongs to.
+  * @param path        Path of the file to check.
+  * @param golden_path Path of the golden file.
+  * @return Whether the file matched (or the golden file was replaced).
+  */
+bool uc_check_snapshot_file(uc_suite suite, const char *path,
+                            const char *golden_path);
+
+/** Check that property holds for many generated inputs, as one check.
+  *
+  * property is called once per case, in a loop in the calling process, and
+  * draws its inputs from prop with the uc_gen_ functions. Cases are generated
+  * from the suite's seed (uc_set_property_seed), so the same seed gives the
+  * same cases. The first case property returns false for is shrunk, by
+  * replaying simpler choices, to a minimal counterexample, and the failed
+  * check's comment gives the seed, the failing case, and the generated
+  * values of the counterexample. Shrinking stops at a property that crashes.
+  *
+  * @param suite    Test suite in which the check belongs to.
+  * @param property Returns whether the property holds for the inputs it
+  *                 generates from prop. Must not keep prop or the buffers it
+  *                 returns past the call.
+  * @param data     Passed to property as is.
+  * @param comment  Information about what is being checked, or NULL.
+  * @return Whether property held for every case.
+  */
+bool uc_check_property(uc_suite suite, bool (*property)(uc_prop prop,
+                                                        void *data),
+                       void *data, const char *comment);
+
+/** Generate an integer in [min, max], shrinking towards the one closest to 0.
+  *
+  * @param prop Case to generate from.
+  * @param min  Least value.
+  * @param max  Greatest value.
+  */
+int64_t uc_gen_int(uc_prop prop, const int64_t min, const int64_t max);
+
+/** Generate a double in [min, max], shrinking towards the one closest to 0.
+  *
+  * @param prop Case to generate from.
+  * @param min  Least value.
+  * @param max  Greatest value.
+  */
+double uc_gen_double(uc_prop prop, const double min, const double max);
+
+/** Generate up to max_len bytes, shrinking towards fewer and smaller ones.
+  *
+  * @param prop    Case to generate from.
+  * @param max_len Greatest number of bytes.
+  * @param len     Set to the number of bytes.
+  * @return The bytes, valid until the property returns, or NULL on failure.
+  */
+const uint8_t *uc_gen_bytes(uc_prop prop, const size_t max_len, size_t *len);
+
+/** Generate a string of up to max_len printable ASCII characters, shrinking
+  * towards shorter ones made of 'a's.
+  *
+  * @param prop    Case to generate from.
+  * @param max_len Greatest length.
+  * @return The string, valid until the property returns, or NULL on failure.
+  */
+const char *uc_gen_string(uc_prop prop, const size_t max_len);
+
 /** Add a test to suite to be executed when run_test is called on the same
   * suite.
   *
@@ -68,20 +239,624 @@ void uc_check(uc_suite suite, const bool cond, const char *comment);
 void uc_add_test(uc_suite suite, void (*test_func)(uc_suite suite),
                  const char *name, const char *comment);
 
+/** Add a test to suite which fuzzes func: calls it on inputs mutated from
+  * the files in corpus_dir (or from an empty input) until the limits set by
+  * uc_set_fuzz_limits are reached.
+  *
+  * The test's process forks a worker which calls func in a loop, and forks
+  * another only if one crashes. Each crashing input is minimised, by
+  * deleting and zeroing bytes while it still crashes the same way, and
+  * reported as a failed check. So is each input func spends longer than
+  * uc_set_fuzz_timeout on, after killing the worker, but without minimising
+  * it. Mutations are seeded like properties
+  * (uc_set_property_seed).
+  *
+  * If the tests are built with -fsanitize-coverage=trace-pc-guard (or
+  * trace-pc with GCC), inputs reaching new code, or running it a new number
+  * of times, are added to the corpus, and written to the directory set by
+  * uc_set_fuzz_output if any. corpus_dir is only read.
+  *
+  * @param suite      Test suite to add the test to.
+  * @param func       Function to fuzz. Must not keep data past the call.
+  * @param name       Name of the test, as for uc_add_test.
+  * @param corpus_dir Directory of inputs to start from, or NULL.
+  */
+void uc_add_fuzz(uc_suite suite, void (*func)(const uint8_t *data,
+                                              size_t size),
+                 const char *name, const char *corpus_dir);
+
+/** How a test added by uc_add_load_test calls its function, and the
+  * objectives it must meet. Fields left 0 take their default or set no
+  * objective.
+  */
+struct uc_load_options {
+        /* Threads calling the function in each caller process, 1 if 0. */
+        unsigned int threads;
+        /* Processes forked to call the function, or 0 to call it from the
+         * test's process only.
+         */
+        unsigned int processes;
+        /* How long to call the function for in seconds, and how many calls
+         * to make in all. Calls stop at whichever comes first; if both are
+         * 0, they stop after a second.
+         */
+        double seconds;
+        unsigned long calls;
+        /* Highest latencies in seconds allowed at the 50th, 99th and 99.9th
+         * percentiles and of any call.
+         */
+        double max_p50;
+        double max_p99;
+        double max_p999;
+        double max_latency;
+        /* Fewest calls per second allowed. */
+        double min_throughput;
+        /* Highest fraction of calls allowed to fail. */
+        double max_error_rate;
+};
+
+/** Add a test to suite which load tests func: calls it repeatedly from many
+  * callers at once, as set by options, and times each call.
+  *
+  * Latencies are counted in a histogram per caller with buckets at most
+  * 1/64 of their value wide, merged once all callers are done. The test
+  * makes a check per objective in options, and one that no more than
+  * max_error_rate of calls failed. uc_report_standard shows the
+  * throughput, error rate and the 50th, 99th and 99.9th percentile and
+  * highest latencies.
+  *
+  * @param suite   Test suite to add the test to.
+  * @param func    Function to call. Takes the number of the caller calling
+  *                it, from 0, and returns false if the call failed. Must be
+  *                safe to call from many threads if options sets threads.
+  * @param name    Name of the test, as for uc_add_test.
+  * @param comment Description of the test, as for uc_add_test.
+  * @param options How to call func and the objectives to meet, or NULL for
+  *                a second of calls from one caller with no objectives but
+  *                no failed calls.
+  */
+void uc_add_load_test(uc_suite suite, bool (*func)(unsigned int caller),
+                      const char *name, const char *comment,
+                      const struct uc_load_options *options);
+
+/** Describes a test defined with UC_TEST. Descriptors are constant and kept in
+  * the uc_tests section of the program (or shared library) defining them.
+  */
+struct uc_test_desc {
+        void (*test_func)(uc_suite suite);
+        const char *name;
+        const char *comment;
+        /* Where the test is defined, to order tests by. */
+        const char *file;
+        int line;
+};
+
+/** Define a test function called name, taking a uc_suite called suite, whose
+  * body follows the macro. The test is registered at compile time and added
+  * by uc_add_defined_tests, so it cannot be forgotten. Its name in reports is
+  * name. For example:
+  *
+  * UC_TEST(test_parse, "Parsing valid input.") {
+  *         uc_check(suite, parse("1") == 1, NULL);
+  * }
+  *
+  * @param name    Name of the test function and of the test.
+  * @param comment A description of the test - to appear in reports. Can be
+  *                omitted by passing NULL. Must be a constant.
+  */
+#define UC_TEST(name, comment)\
+        static void name(uc_suite suite);\
+        static const struct uc_test_desc uc_test_desc_##name\
+                __attribute__((section("uc_tests"), used,\
+                               aligned(sizeof(void *)))) =\
+                { &name, #name, comment, __FILE__, __LINE__ };\
+        static void name(uc_suite suite)
+
+/** Bounds of the uc_tests section, defined by the linker. Weak so they are
+  * NULL if no test was defined with UC_TEST.
+  */
+extern const struct uc_test_desc __start_uc_tests[] __attribute__((weak));
+extern const struct uc_test_desc __stop_uc_tests[] __attribute__((weak));
+
+/** Add the tests of the descriptors from start up to (not including) stop to
+  * suite, like uc_add_test, ordered by the file and line they are defined at.
+  * Names and comments are used in place rather than copied, and one block is
+  * allocated for all the tests. Does nothing if suite is NULL or there are no
+  * descriptors.
+  *
+  * @param suite Test suite to add the tests to.
+  * @param start First descriptor.
+  * @param stop  End of the descriptors.
+  */
+void uc_add_test_descs(uc_suite suite, const struct uc_test_desc *start,
+                       const struct uc_test_desc *stop);
+
+/** Add every test defined with UC_TEST in the calling program (or shared
+  * library) to suite with uc_add_test_descs.
+  *
+  * @param suite Test suite to add the tests to.
+  */
+#define uc_add_defined_tests(suite)\
+        uc_add_test_descs((suite), __start_uc_tests, __stop_uc_tests)
+
+/** Set the suite fixture. setup is called in the calling process once, before
+  * uc_run_tests creates any test processes, and teardown once after all of
+  * them have finished. Since every test runs in a child of the calling
+  * process, anything built by setup is inherited by the tests (copy-on-write)
+  * without being rebuilt per test. Either can be NULL. Does nothing if suite
+  * is NULL.
+  *
+  * Checks made by setup or teardown count as dangling checks.
+  *
+  * @param suite    Test suite to set the fixture for.
+  * @param setup    Called before the first test is run.
+  * @param teardown Called after the last test has run.
+  */
+void uc_set_suite_fixture(uc_suite suite, void (*setup)(uc_suite suite),
+                          void (*teardown)(uc_suite suite));
+
+/** Start a group of tests. Tests added by uc_add_test until uc_end_group (or
+  * the next uc_begin_group) belong to the group. Like the suite fixture, setup
+  * and teardown are called in the calling process of uc_run_tests: setup just
+  * before the first test of the group is run and teardown just after the last
+  * test of the group has run. Groups do not nest. Either hook can be NULL.
+  * Does nothing if suite is NULL.
+  *
+  * Checks made by setup or teardown count as dangling checks.
+  *
+  * @param suite    Test suite to start the group in.
+  * @param setup    Called before the first test of the group is run.
+  * @param teardown Called after the last test of the group has run.
+  */
+void uc_begin_group(uc_suite suite, void (*setup)(uc_suite suite),
+                    void (*teardown)(uc_suite suite));
+
+/** End the group started by uc_begin_group. Tests added after this call do
+  * not belong to a group. Does nothing if suite is NULL or no group has been
+  * started.
+  *
+  * @param suite Test suite to end the group in.
+  */
+void uc_end_group(uc_suite suite);
+
+/** Set the per-test fixture. Unlike the suite and group fixtures, setup and
+  * teardown are called inside each test's own process, immediately before and
+  * after its test function. Checks made by them count towards the test.
+  * Either can be NULL. Does nothing if suite is NULL.
+  *
+  * @param suite    Test suite to set the fixture for.
+  * @param setup    Called before every test function.
+  * @param teardown Called after every test function.
+  */
+void uc_set_test_fixture(uc_suite suite, void (*setup)(uc_suite suite),
+                         void (*teardown)(uc_suite suite));
+
+/** Declare a resource of suite's tests which capacity units of are
+  * available, e.g. 1 for a port only one test may bind at a time, or the
+  * number of test databases. Tests take units of it with uc_test_uses and
+  * only run while the units they take are free. Declaring a resource again
+  * changes its capacity. The suites run by uc_registry_run share resources of
+  * the same name, with the smallest capacity any of them declares. Does
+  * nothing if suite or name is NULL, or capacity is 0.
+  *
+  * @param suite    Test suite to declare the resource for.
+  * @param name     Name of the resource.
+  * @param capacity Units of the resource.
+  */
+void uc_add_resource(uc_suite suite, const char *name,
+                     const unsigned int capacity);
+
+/** Make the test last added to suite take units of resource while it runs,
+  * so tests using more of it than is available never run at the same time.
+  * Resources not declared with uc_add_resource have 1 unit: tests using them
+  * run one at a time. A NULL resource makes the test run with no other test
+  * at all, of any suite run by the same uc_registry_run, e.g. as it needs
+  * the whole machine; once it is the first test left to start, no other
+  * starts ahead of it. A test which uses resources always runs in a process
+  * of its own (see uc_set_batch_size). Ignored with UC_OPT_THREADS or
+  * uc_set_repeat.
+  *
+  * Example:
+  * uc_add_test(suite, &test_server, "Server", NULL);
+  * uc_test_uses(suite, "port 8080", 1);
+  *
+  * @param suite    Test suite whose last test uses the resource.
+  * @param resource Name of the resource, NULL for the whole machine.
+  * @param units    Units of the resource the test takes.
+  *
+  * @return true if the test uses the resource, false if suite is NULL or has
+  *         no tests, units is more than the resource's capacity, or memory
+  *         cannot be allocated.
+  */
+bool uc_test_uses(uc_suite suite, const char *resource,
+                  const unsigned int units);
+
+/** Make the test last added to suite start only after the test named
+  * prerequisite has finished, and not run at all (being reported as failed
+  * to run) if it did not pass. The prerequisite must have been added before
+  * the test, and tests left out by uc_select_tests count as passed. A test
+  * with prerequisites always runs in a process of its own (see
+  * uc_set_batch_size). Ignored with UC_OPT_THREADS or uc_set_repeat.
+  *
+  * @param suite        Test suite whose last test runs after the other.
+  * @param prerequisite Name of the test to run after.
+  *
+  * @return true if the test runs after the prerequisite, false if suite is
+  *         NULL or has no tests, no test named prerequisite was added
+  *         before, or memory cannot be allocated.
+  */
+bool uc_test_after(uc_suite suite, const char *prerequisite);
+
+/** Set how many consecutive tests uc_run_tests runs in one process (1 by
+  * default, 0 is treated as 1). Larger batches spend less time creating
+  * processes but tests in a batch are not isolated from each other. A batch
+  * never spans more than one group. If a test crashes, it alone fails and the
+  * rest of its batch is run in a new process. Does nothing if suite is NULL.
+  *
+  * @param suite      Test suite to set the batch size of.
+  * @param batch_size Maximum number of tests run by one process.
+  */
+void uc_set_batch_size(uc_suite suite, const unsigned int batch_size);
+
+/** Set how many tests uc_run_tests runs at the same time - the number of
+  * threads with UC_OPT_THREADS, or of processes with UC_OPT_PARALLEL or
+  * running a repeated test (see uc_set_repeat); other tests run one process
+  * at a time. 0, the default, runs one per online CPU. Does nothing if suite
+  * is NULL.
+  *
+  * @param suite Test suite to set the number of jobs of.
+  * @param jobs  Number of tests to run at the same time.
+  */
+void uc_set_jobs(uc_suite suite, const unsigned int jobs);
+
+/** Set how many bytes of each test's output are kept with
+  * UC_OPT_CAPTURE_OUTPUT (64 KiB by default). Only the last limit bytes are
+  * kept. Does nothing if suite is NULL.
+  *
+  * @param suite Test suite to set the output limit of.
+  * @param limit Maximum number of bytes of output kept per test.
+  */
+void uc_set_output_limit(uc_suite suite, const size_t limit);
+
+/** Pin each test process to one of cpus, so tests don't migrate between
+  * cores: the process in the i-th of the uc_set_jobs job slots runs on
+  * cpus[i % num_cpus], so tests running at the same time only share a CPU
+  * if there are more jobs than CPUs. With UC_OPT_THREADS, each worker thread
+  * is pinned instead. Passing no CPUs stops pinning (unless UC_OPT_PIN_CPUS
+  * is set). The CPU each test ran on is shown by uc_report_standard. Does
+  * nothing if suite is NULL, cpus is NULL while num_cpus is not 0, or a CPU
+  * is invalid.
+  *
+  * @param suite    Test suite to set the CPUs of.
+  * @param cpus     CPU numbers, as used by sched_setaffinity.
+  * @param num_cpus Number of CPUs in cpus.
+  */
+void uc_set_cpus(uc_suite suite, const int *cpus, const size_t num_cpus);
+
+/** Run each test times times, or for seconds, whichever limit comes first
+  * (0 for no limit; 0 times and 0 seconds is treated as 1 time), to find
+  * intermittent failures. Every run has its own process, and uc_set_jobs of
+  * them run at the same time; the next test starts once all runs of the
+  * previous one have finished. Ignored with UC_OPT_THREADS, and batches are
+  * not used.
+  *
+  * A repeated test counts as one test: it keeps the checks of its first
+  * failed run, or of its first run if none failed, and uc_report_standard
+  * shows its pass rate, first failed run, checks over all runs and the spread
+  * of its test function's run time. Does nothing if suite is NULL.
+  *
+  * @param suite   Test suite to set the repetitions of.
+  * @param times   Maximum number of runs of each test.
+  * @param seconds Maximum time to keep starting runs of each test.
+  */
+void uc_set_repeat(uc_suite suite, const unsigned int times,
+                   const double seconds);
+
+/** Set the nice level of test processes. Ignored with UC_OPT_THREADS or if a
+  * real-time priority is set. Does nothing if suite is NULL.
+  *
+  * @param suite Test suite to set the nice level of.
+  * @param nice  Nice level, as used by setpriority.
+  */
+void uc_set_nice(uc_suite suite, const int nice);
+
+/** Set the number of cases uc_check_property tries, 1000 by default. Does
+  * nothing if suite is NULL or cases is 0.
+  *
+  * @param suite Test suite to set the number of cases of.
+  * @param cases Number of cases per property.
+  */
+void uc_set_property_cases(uc_suite suite, const unsigned long cases);
+
+/** Set the seed uc_check_property generates cases from. By default, each
+  * suite picks its own seed; failed properties report it, so setting it
+  * reproduces their cases. Does nothing if suite is NULL.
+  *
+  * @param suite Test suite to set the seed of.
+  * @param seed  Seed of the cases of every property.
+  */
+void uc_set_property_seed(uc_suite suite, const uint64_t seed);
+
+/** Set how long each test added by uc_add_fuzz fuzzes for: at most runs
+  * inputs (0 for no limit) and at most seconds (0 for no limit). By default,
+  * 100000 inputs. Does nothing if suite is NULL.
+  *
+  * @param suite   Test suite to set the fuzzing limits of.
+  * @param runs    Maximum number of inputs of each fuzz test.
+  * @param seconds Maximum time to fuzz each fuzz test for.
+  */
+void uc_set_fuzz_limits(uc_suite suite, const unsigned long runs,
+                        const double seconds);
+
+/** Set how long a test added by uc_add_fuzz lets func run on one input
+  * before reporting it as a hang, 1 second by default (0 for no limit). Does
+  * nothing if suite is NULL.
+  *
+  * @param suite   Test suite to set the fuzzing timeout of.
+  * @param seconds Longest time func may take on an input.
+  */
+void uc_set_fuzz_timeout(uc_suite suite, const double seconds);
+
+/** Set the directory the tests added by uc_add_fuzz write inputs reaching
+  * new coverage to, each named after a hash of its bytes. By default, and
+  * with a NULL dir, they are only kept for the rest of the test. dir may be
+  * a test's corpus_dir, to grow its corpus from run to run. Does nothing if
+  * suite is NULL.
+  *
+  * @param suite Test suite to set the corpus output of.
+  * @param dir   Existing directory to write inputs to, or NULL.
+  */
+void uc_set_fuzz_output(uc_suite suite, const char *dir);
+
+/** Run test processes under SCHED_FIFO with priority (needs the privilege to
+  * do so), or under the normal policy again if priority is 0. Ignored with
+  * UC_OPT_THREADS. Does nothing if suite is NULL.
+  *
+  * @param suite    Test suite to set the real-time priority of.
+  * @param priority SCHED_FIFO priority, 0 for none.
+  */
+void uc_set_realtime(uc_suite suite, const int priority);
+
+/** Keep a map of the functions each test runs at path, for uc_select_tests,
+  * in a test binary built with --coverage (GCC 12 or later). Pass gcov's
+  * __gcov_dump and __gcov_reset (from <gcov.h>), which only the binary can
+  * reach. After each uc_run_tests, the entries of the tests run are replaced
+  * in the map and the other entries kept. The map is a text file of
+  * "T <test name>" lines, each followed by a "F <start line> <end line>
+  * <function> <file>" line per function the test ran. Tests are told apart
+  * by name (or number if unnamed).
+  *
+  * Test processes then write their coverage to the map rather than the
+  * usual .gcda files. Ignored with UC_OPT_THREADS. Passing a NULL path stops
+  * keeping the map. Does nothing if suite is NULL.
+  *
+  * Example:
+  * uc_set_coverage_map(suite, "coverage.map", &__gcov_dump, &__gcov_reset);
+  *
+  * @param suite Test suite to keep a coverage map for.
+  * @param path  Path of the map, NULL for none.
+  * @param dump  __gcov_dump.
+  * @param reset __gcov_reset.
+  */
+void uc_set_coverage_map(uc_suite suite, const char *path,
+                         void (*dump)(void), void (*reset)(void));
+
+/** Leave the tests which cover none of the changes listed in the file at
+  * changes_path out of the next runs, according to suite's coverage map (see
+  * uc_set_coverage_map). Each line of the file names a changed file,
+  * optionally followed by ":<line>" or ":<first line>-<last line>", e.g.
+  * from git diff -U0. Names match the end of the paths in the map. Tests not
+  * in the map are always run. Tests left out are reported as not run.
+  *
+  * @param suite        Test suite to select tests of.
+  * @param changes_path Path of the list of changes.
+  *
+  * @return true if tests were selected, false if the map or list of changes
+  *         cannot be read (all tests are then run), or suite is NULL or has
+  *         no coverage map.
+  */
+bool uc_select_tests(uc_suite suite, const char *changes_path);
+
+/** Write a timeline of each uc_run_tests to path, replacing it, in the trace
+  * event format read by chrome://tracing and Perfetto. Each slot running a
+  * test process has a lane with, per process, a "Spawn" span (fork, or the
+  * round trip to the zygote) and a "Reap" span (waitpid), and per test a
+  * span named after it (from before its setup to after its teardown). A
+  * second lane per slot has a "Transfer" span per test, from the end of the
+  * test until its results have been read. Spans are clipped so those of a
+  * lane don't overlap. Counter
+  * tracks show the test processes running and the bytes of results
+  * received. For a repeated test (uc_set_repeat), an instant event marks the
+  * end of the run whose results are reported. Ignored with UC_OPT_THREADS.
+  * Passing a NULL path stops tracing. Does nothing if suite is NULL.
+  *
+  * @param suite Test suite to trace runs of.
+  * @param path  Path of the trace, NULL for none.
+  */
+void uc_set_trace(uc_suite suite, const char *path);
+
+/** Profile each test function with stack samples taken every millisecond of
+  * CPU time of its process (SIGPROF), and write them to dir (created if
+  * missing) after each uc_run_tests as "<test name>.folded", in the folded
+  * stack format of flamegraph tools: a line per stack, its functions from
+  * the outermost (the test function) separated by ';', then a space and the
+  * number of samples. Characters of test names other than letters, digits,
+  * '-' and '.' are written as '_'. Functions are named as in crash
+  * backtraces, so the tests have to be linked with -rdynamic; others are
+  * written as "<module>+<offset>" (for addr2line). Only tests whose
+  * function took at least min_seconds are written. Tests must not use
+  * SIGPROF or ITIMER_PROF themselves. Ignored with UC_OPT_THREADS. Passing
+  * a NULL dir stops profiling. Does nothing if suite is NULL.
+  *
+  * Example:
+  * uc_set_profile(suite, "profiles", 0.5);
+  *
+  * @param suite       Test suite to profile tests of.
+  * @param dir         Directory to write profiles to, NULL for none.
+  * @param min_seconds Seconds a test function must take to be written, 0
+  *                    for all.
+  */
+void uc_set_profile(uc_suite suite, const char *dir,
+                    const double min_seconds);
+
 /** Run all tests added by uc_add_test (in order they were added in).
   *
   * @param suite Test suite to run tests for.
   */
 void uc_run_tests(uc_suite suite);
 
+/** Start running all tests added by uc_add_test without waiting for them, for
+  * callers with their own event loop. The run makes progress in uc_run_step,
+  * which is called whenever uc_run_fd is readable. Results land in suite as
+  * with uc_run_tests. The suite fixture's setup is called here. Every run must
+  * be ended by uc_run_wait or uc_run_cancel, and suite must not be used for
+  * anything else in the meantime.
+  *
+  * With UC_OPT_THREADS, a step starts the tests up to the next group (or
+  * between groups), with the group's fixture, on threads of their own and
+  * returns without waiting for them. uc_run_fd becomes readable once they
+  * have finished.
+  *
+  * @param suite Test suite to run tests for.
+  *
+  * @return The run or NULL on error (or if suite is NULL).
+  */
+uc_run uc_run_tests_async(uc_suite suite);
+
+/** Get a file descriptor which becomes readable when run can make progress,
+  * for use with poll, select or epoll.
+  *
+  * @param run Run to get the file descriptor of.
+  *
+  * @return The file descriptor, owned by run, or -1 if run is NULL.
+  */
+int uc_run_fd(uc_run run);
+
+/** Make progress with run: read what test processes have sent, record the
+  * results of finished tests, reap test processes which have exited and
+  * start the next ones. A step never waits for a test: a test process still
+  * exiting once its results are read (e.g. running atexit handlers) is
+  * reaped by a later step, as uc_run_fd becomes readable when it exits
+  * (on kernels without pidfd_open, a test process forked without a zygote
+  * is waited for instead). Starting test processes, and the group fixtures
+  * run before and after their tests, happen within the step and take as
+  * long as they take, except with UC_OPT_THREADS where the group fixtures
+  * run on the thread running their tests.
+  *
+  * @param run Run to make progress with.
+  *
+  * @return false once all tests have run and the suite fixture's teardown has
+  *         been called (or if run is NULL), true otherwise.
+  */
+bool uc_run_step(uc_run run);
+
+/** Wait for all of run's tests to finish and free run. Does nothing if run is
+  * NULL.
+  *
+  * @param run Run to wait for.
+  */
+void uc_run_wait(uc_run run);
+
+/** Kill run's test processes and free run. Tests which had not finished are
+  * reported as failed to run, and tests which had not started are not run.
+  * Group and suite teardowns are still called. Tests running on threads
+  * (UC_OPT_THREADS) cannot be killed and are waited for. Does nothing if run
+  * is NULL.
+  *
+  * @param run Run to cancel.
+  */
+void uc_run_cancel(uc_run run);
+
+/** Run all tests added by uc_add_test, report them, then wait for the test
+  * binary or any of paths (files or directories) to change and start the
+  * binary again with the same arguments, for a test loop alongside an editor
+  * and build. Call in place of uc_run_tests and the report, as the last thing
+  * in main.
+  *
+  * Each run starts with the tests which failed in the run before it, and
+  * ends with the number of tests which passed and the tests which now pass or
+  * fail unlike in the run before it. Tests are told apart by name (or number
+  * if unnamed). Tests are run as by uc_run_tests, in their own processes.
+  *
+  * Returns only if watching cannot be set up (without running any tests) or
+  * fails. Does nothing if suite is NULL.
+  *
+  * @param suite     Test suite to run tests for.
+  * @param report    Called with suite after each run (e.g.
+  *                  uc_report_standard), NULL for none.
+  * @param paths     Further paths to watch, e.g. sources or test data.
+  * @param num_paths Number of paths.
+  */
+void uc_watch(uc_suite suite, void (*report)(uc_suite suite),
+              const char *const *paths, const size_t num_paths);
+
+/** Create an empty registry of test suites.
+  *
+  * @return A uc_registry or NULL on error.
+  */
+uc_registry uc_registry_init(void);
+
+/** Free registry and every suite added to it. Using registry or its suites
+  * after this call results in undefined behaviour. Does nothing if registry
+  * is NULL.
+  *
+  * @param registry Registry to free.
+  */
+void uc_registry_free(uc_registry registry);
+
+/** Add suite to registry, as a sub-suite of parent unless parent is NULL.
+  * registry takes ownership of suite, which is freed by uc_registry_free.
+  * Suites are run and reported in the order they were added in, each
+  * followed by its sub-suites.
+  *
+  * @param registry Registry to add suite to.
+  * @param suite    Test suite to add.
+  * @param parent   Suite already in registry to add suite under, NULL for
+  *                 none.
+  *
+  * @return false if registry or suite is NULL, suite is already in
+  *         registry, parent is not, or on error. true otherwise.
+  */
+bool uc_registry_add(uc_registry registry, uc_suite suite, uc_suite parent);
+
+/** Set the number of test processes uc_registry_run runs at the same time,
+  * or 0 for one per CPU (the default). Does nothing if registry is NULL.
+  *
+  * @param registry Registry to set the number of processes of.
+  * @param jobs     Number of test processes, 0 for one per CPU.
+  */
+void uc_registry_set_jobs(uc_registry registry, const unsigned int jobs);
+
+/** Run the tests of every suite in registry on one pool of test processes
+  * (see uc_registry_set_jobs). Each suite keeps its own results, to be
+  * reported as after uc_run_tests, and its fixtures run as with
+  * uc_run_tests. Tests of the same suite may run at the same time, but never
+  * alongside their group's fixtures. Suites with UC_OPT_THREADS run on their
+  * own thread pools instead. Does nothing if registry is NULL.
+  *
+  * @param registry Registry to run tests for.
+  */
+void uc_registry_run(uc_registry registry);
+
+/** Check if all tests run for every suite in registry have passed (see
+  * uc_all_tests_passed).
+  *
+  * @param registry Registry to check.
+  *
+  * @return true if uc_all_tests_passed is true for every suite in registry,
+  *         false otherwise (or if registry is NULL).
+  */
+bool uc_registry_all_passed(uc_registry registry);
+
 /** Check if all tests run for suite have passed (i.e. all checks
   * were successful).
   *
   * @param suite Test suite to check.
   *
   * @return true if all tests that have been run for suite have passed
-  *         (this includes "dangling" checks), false otherwise. Returns
-  *         true if no tests or checks have been run.
+  *         (this includes "dangling" checks), false otherwise. Tests which
+  *         crashed or failed to run have not passed. Returns true if no
+  *         tests or checks have been run.
   */
 bool uc_all_tests_passed(uc_suite suite);
 
@@ -109,10 +884,40 @@ void uc_report_basic(uc_suite suite);
   * Check failed: Another comment.
   * Check failed: Check #8.
   *
+  * Tests which crashed show the signal and their last check (checks made
+  * before the crash are kept); tests which could not be run show "Failed to
+  * run.". A crash's backtrace is written to stderr when it happens. How the
+  * runs of repeated tests (uc_set_repeat) went, heap use
+  * (UC_OPT_HEAP_STATS), performance counts (UC_OPT_PERF_COUNTERS), placement
+  * (uc_set_cpus, uc_set_nice, uc_set_realtime) and failed tests' output
+  * captured with UC_OPT_CAPTURE_OUTPUT follow.
+  *
   * @param suite Test suite to generate report from.
   */
 void uc_report_standard(uc_suite suite);
 
+/** Outputs a summary of every suite in registry: the number of successful
+  * checks and passed tests across all suites, then for each suite (with its
+  * sub-suites indented under it). Suites are reported on their own by the
+  * other reports. Outputs nothing if registry is NULL.
+  *
+  * Example:
+  * All suites
+  * Total successful checks: 17/20.
+  * Tests passed: 4/6.
+  *
+  *     Suite name
+  *         Successful checks: 12/14.
+  *         Tests passed: 3/4.
+  *
+  *         Sub-suite name
+  *             Successful checks: 5/6.
+  *             Tests passed: 1/2.
+  *
+  * @param registry Registry to generate report from.
+  */
+void uc_report_registry(uc_registry registry);
+
 /** \mainpage notitle
   * See [README](https://github.com/mbarbar/unitc) on the project page
   * or [API documentation](http://mbarbar.github.io/unitc/doc/unitc_8h.html).
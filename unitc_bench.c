@@ -0,0 +1,326 @@
+/** unitc_bench.c
+  * Benchmarks of unitc's own overhead, built against unitc.c in the tree.
+  *
+  * Each measurement is printed as one line of space separated key=value
+  * pairs, starting with bench=<name>, so runs can be compared line by line
+  * (e.g. with diff or awk). Each measurement runs in a process of its own,
+  * so that peak_rss_kb is that measurement's peak resident set size.
+  *
+  * Usage: unitc_bench [max_checks [max_tests]]
+  * Sizes go up by powers of 10 from 1 to max_checks (default 10^7) checks and
+  * max_tests (default 10^5) tests.
+  */
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "unitc.h"
+
+#define DEFAULT_MAX_CHECKS 10000000UL
+#define DEFAULT_MAX_TESTS 100000UL
+
+/** Fewest checks bytes_per_check is printed for: below, malloc's arenas and
+  * the suite's fixed costs swamp the checks.
+  */
+#define MIN_HEAP_CHECKS 1000UL
+
+/** How checks are made by the check benchmarks. */
+enum check_kind {
+        CHECK_NO_COMMENT,
+        CHECK_COMMENT,
+        CHECK_BORROWED,
+        NUM_CHECK_KINDS
+};
+
+static const char *const check_kind_names[NUM_CHECK_KINDS] = {
+        "none", "copied", "borrowed"
+};
+
+/** How tests are run by the test benchmarks. */
+static const struct {
+        const char *name;
+        uint_least32_t options;
+        unsigned int batch_size;
+} test_modes[] = {
+        { "fork", UC_OPT_NONE, 1 },
+        { "batch", UC_OPT_NONE, 64 },
+        { "zygote", UC_OPT_ZYGOTE, 1 },
+        { "threads", UC_OPT_THREADS, 1 }
+};
+
+/* Checks made by check_test, and how. */
+static unsigned long test_checks;
+static enum check_kind test_check_kind;
+
+/** Seconds from start to end. */
+static double seconds_since(const struct timespec *start);
+
+/** Bytes allocated and not yet freed in the process. */
+static size_t heap_in_use(void);
+
+/** Peak resident set size of the process's reaped children, in KiB. */
+static long children_peak_rss_kb(void);
+
+/** Runs measure(variant, n) in a child process, which prints the start of a
+  * line, and ends the line with the child's peak resident set size.
+  */
+static void run_forked(void (*measure)(const int variant,
+                                       const unsigned long n),
+                       const int variant, const unsigned long n);
+
+/** Makes num checks of kind on suite, alternately passing and failing. */
+static void make_checks(uc_suite suite, const unsigned long num,
+                        const enum check_kind kind);
+
+/** Test making test_checks checks of test_check_kind. */
+static void check_test(uc_suite suite);
+
+/** Test making no checks. */
+static void empty_test(uc_suite suite);
+
+/** uc_check throughput and memory, outside of tests. */
+static void bench_checks(const unsigned long max_checks);
+static void measure_checks(const int kind, const unsigned long n);
+
+/** Checks made in a test process, sent to and read by the parent. */
+static void bench_results(const unsigned long max_checks);
+static void measure_results(const int kind, const unsigned long n);
+
+/** Round trips of empty tests for each of test_modes. */
+static void bench_tests(const unsigned long max_tests);
+static void measure_tests(const int mode, const unsigned long n);
+
+/** uc_report_standard rendering failed checks, to /dev/null. */
+static void bench_report(const unsigned long max_checks);
+static void measure_report(const int unused, const unsigned long n);
+
+int main(int argc, char **argv) {
+        unsigned long max_checks = DEFAULT_MAX_CHECKS;
+        unsigned long max_tests = DEFAULT_MAX_TESTS;
+
+        if (argc > 1) max_checks = strtoul(argv[1], NULL, 10);
+        if (argc > 2) max_tests = strtoul(argv[2], NULL, 10);
+
+        bench_checks(max_checks);
+        bench_results(max_checks);
+        bench_tests(max_tests);
+        bench_report(max_checks);
+
+        return EXIT_SUCCESS;
+}
+
+double seconds_since(const struct timespec *start) {
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        return (end.tv_sec - start->tv_sec) +
+               (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+size_t heap_in_use(void) {
+        struct mallinfo2 info = mallinfo2();
+
+        return info.uordblks + info.hblkhd;
+}
+
+long children_peak_rss_kb(void) {
+        struct rusage usage;
+
+        getrusage(RUSAGE_CHILDREN, &usage);
+        return usage.ru_maxrss;
+}
+
+void run_forked(void (*measure)(const int variant, const unsigned long n),
+                const int variant, const unsigned long n) {
+        struct rusage usage;
+        int wstatus;
+        pid_t pid;
+
+        fflush(stdout);
+        pid = fork();
+        if (pid == -1) {
+                fputs("unitc_bench: cannot fork.\n", stderr);
+                return;
+        }
+        if (pid == 0) {
+                measure(variant, n);
+                fflush(stdout);
+                _exit(EXIT_SUCCESS);
+        }
+
+        if (wait4(pid, &wstatus, 0, &usage) == -1 || !WIFEXITED(wstatus) ||
+            WEXITSTATUS(wstatus) != EXIT_SUCCESS) {
+                fputs("unitc_bench: measurement failed.\n", stderr);
+                putchar('\n');
+        } else {
+                printf(" peak_rss_kb=%ld\n", usage.ru_maxrss);
+        }
+        fflush(stdout);
+}
+
+void make_checks(uc_suite suite, const unsigned long num,
+                 const enum check_kind kind) {
+        for (unsigned long i = 0; i < num; ++i) {
+                bool cond = i % 2 == 0;
+
+                switch (kind) {
+                case CHECK_NO_COMMENT:
+                        uc_check(suite, cond, NULL);
+                        break;
+                case CHECK_COMMENT:
+                        uc_check(suite, cond, "Benchmark check.");
+                        break;
+                default:
+                        uc_check_borrowed(suite, cond, "Benchmark check.");
+                        break;
+                }
+        }
+}
+
+void check_test(uc_suite suite) {
+        make_checks(suite, test_checks, test_check_kind);
+}
+
+void empty_test(uc_suite suite) {
+        (void)suite;
+}
+
+void bench_checks(const unsigned long max_checks) {
+        for (int kind = 0; kind < NUM_CHECK_KINDS; ++kind) {
+                for (unsigned long n = 1; n <= max_checks; n *= 10) {
+                        run_forked(&measure_checks, kind, n);
+                }
+        }
+}
+
+void measure_checks(const int kind, const unsigned long n) {
+        struct timespec start;
+        double check_secs, free_secs;
+        size_t heap_before, heap_bytes;
+        uc_suite suite = uc_init(UC_OPT_NONE, NULL, NULL);
+
+        heap_before = heap_in_use();
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        make_checks(suite, n, kind);
+        check_secs = seconds_since(&start);
+        heap_bytes = heap_in_use() - heap_before;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uc_free(suite);
+        free_secs = seconds_since(&start);
+
+        printf("bench=checks comment=%s checks=%lu seconds=%.6f "
+               "checks_per_sec=%.0f free_seconds=%.6f",
+               check_kind_names[kind], n, check_secs, n / check_secs,
+               free_secs);
+        if (n >= MIN_HEAP_CHECKS) {
+                printf(" bytes_per_check=%.1f", (double)heap_bytes / n);
+        }
+}
+
+void bench_results(const unsigned long max_checks) {
+        for (int kind = 0; kind < NUM_CHECK_KINDS; ++kind) {
+                for (unsigned long n = 1; n <= max_checks; n *= 10) {
+                        run_forked(&measure_results, kind, n);
+                }
+        }
+}
+
+void measure_results(const int kind, const unsigned long n) {
+        struct timespec start;
+        double secs;
+        uc_suite suite = uc_init(UC_OPT_NONE, NULL, NULL);
+
+        test_checks = n;
+        test_check_kind = kind;
+        uc_add_test(suite, &check_test, NULL, NULL);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uc_run_tests(suite);
+        secs = seconds_since(&start);
+        uc_free(suite);
+
+        printf("bench=results comment=%s checks=%lu seconds=%.6f "
+               "checks_per_sec=%.0f child_peak_rss_kb=%ld",
+               check_kind_names[kind], n, secs, n / secs,
+               children_peak_rss_kb());
+}
+
+void bench_tests(const unsigned long max_tests) {
+        for (size_t mode = 0; mode < sizeof(test_modes) / sizeof(test_modes[0]);
+             ++mode) {
+                for (unsigned long n = 1; n <= max_tests; n *= 10) {
+                        run_forked(&measure_tests, mode, n);
+                }
+        }
+}
+
+void measure_tests(const int mode, const unsigned long n) {
+        struct timespec start;
+        double secs;
+        uc_suite suite = uc_init(test_modes[mode].options, NULL, NULL);
+
+        uc_set_batch_size(suite, test_modes[mode].batch_size);
+        for (unsigned long i = 0; i < n; ++i) {
+                uc_add_test(suite, &empty_test, NULL, NULL);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uc_run_tests(suite);
+        secs = seconds_since(&start);
+        uc_free(suite);
+
+        printf("bench=tests mode=%s tests=%lu seconds=%.6f "
+               "tests_per_sec=%.0f us_per_test=%.2f",
+               test_modes[mode].name, n, secs, n / secs, secs * 1e6 / n);
+}
+
+void bench_report(const unsigned long max_checks) {
+        for (unsigned long n = 1; n <= max_checks; n *= 10) {
+                run_forked(&measure_report, 0, n);
+        }
+}
+
+void measure_report(const int unused, const unsigned long n) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        int stdout_fd = dup(STDOUT_FILENO);
+        struct timespec start;
+        double secs;
+        uc_suite suite;
+
+        (void)unused;
+        if (null_fd == -1 || stdout_fd == -1) {
+                fputs("unitc_bench: cannot redirect reports.\n", stderr);
+                exit(EXIT_FAILURE);
+        }
+
+        suite = uc_init(UC_OPT_NONE, NULL, NULL);
+        make_checks(suite, n, CHECK_BORROWED);
+
+        fflush(stdout);
+        dup2(null_fd, STDOUT_FILENO);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uc_report_standard(suite);
+        fflush(stdout);
+        secs = seconds_since(&start);
+        dup2(stdout_fd, STDOUT_FILENO);
+        uc_free(suite);
+
+        printf("bench=report checks=%lu seconds=%.6f checks_per_sec=%.0f",
+               n, secs, n / secs);
+
+        close(null_fd);
+        close(stdout_fd);
+}
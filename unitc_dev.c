@@ -3,13 +3,14 @@
   * The definitions of uc_* are to come from unitc.c not the installed library.
   */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 #include "unitc.h"
 #include "unitc_dev.h"
 
-dev_uc_suite dev_uc_init(const uint_least8_t options, const char *name,
+dev_uc_suite dev_uc_init(const uint_least32_t options, const char *name,
                          const char *comment) {
         return (dev_uc_suite)uc_init(options, name, comment);
 }
@@ -22,16 +23,240 @@ void dev_uc_check(dev_uc_suite suite, const bool cond, const char *comment) {
         uc_check((struct uc_suite *)suite, cond, comment);
 }
 
+void dev_uc_check_borrowed(dev_uc_suite suite, const bool cond,
+                           const char *comment) {
+        uc_check_borrowed((struct uc_suite *)suite, cond, comment);
+}
+
+bool dev_uc_check_snapshot(dev_uc_suite suite, const void *buf,
+                           const size_t len, const char *path) {
+        return uc_check_snapshot((struct uc_suite *)suite, buf, len, path);
+}
+
+bool dev_uc_check_snapshot_file(dev_uc_suite suite, const char *path,
+                                const char *golden_path) {
+        return uc_check_snapshot_file((struct uc_suite *)suite, path,
+                                      golden_path);
+}
+
+bool dev_uc_check_property(dev_uc_suite suite,
+                           bool (*property)(dev_uc_prop prop, void *data),
+                           void *data, const char *comment) {
+        return uc_check_property((struct uc_suite *)suite, property, data,
+                                 comment);
+}
+
+int64_t dev_uc_gen_int(dev_uc_prop prop, const int64_t min, const int64_t max) {
+        return uc_gen_int((struct uc_prop *)prop, min, max);
+}
+
+double dev_uc_gen_double(dev_uc_prop prop, const double min,
+                         const double max) {
+        return uc_gen_double((struct uc_prop *)prop, min, max);
+}
+
+const uint8_t *dev_uc_gen_bytes(dev_uc_prop prop, const size_t max_len,
+                                size_t *len) {
+        return uc_gen_bytes((struct uc_prop *)prop, max_len, len);
+}
+
+const char *dev_uc_gen_string(dev_uc_prop prop, const size_t max_len) {
+        return uc_gen_string((struct uc_prop *)prop, max_len);
+}
+
 void dev_uc_add_test(dev_uc_suite suite, void (*test_func)(dev_uc_suite suite),
                     const char *name, const char *comment) {
         uc_add_test((struct uc_suite *)suite,
                     (void (*)(uc_suite suite))test_func, name, comment);
 }
 
+void dev_uc_add_fuzz(dev_uc_suite suite,
+                     void (*func)(const uint8_t *data, size_t size),
+                     const char *name, const char *corpus_dir) {
+        uc_add_fuzz((struct uc_suite *)suite, func, name, corpus_dir);
+}
+
+void dev_uc_add_load_test(dev_uc_suite suite,
+                          bool (*func)(unsigned int caller),
+                          const char *name, const char *comment,
+                          const struct uc_load_options *options) {
+        uc_add_load_test((struct uc_suite *)suite, func, name, comment,
+                         options);
+}
+
+void dev_uc_add_test_descs(dev_uc_suite suite,
+                           const struct uc_test_desc *start,
+                           const struct uc_test_desc *stop) {
+        uc_add_test_descs((struct uc_suite *)suite, start, stop);
+}
+
+void dev_uc_set_suite_fixture(dev_uc_suite suite,
+                              void (*setup)(dev_uc_suite suite),
+                              void (*teardown)(dev_uc_suite suite)) {
+        uc_set_suite_fixture((struct uc_suite *)suite,
+                             (void (*)(uc_suite suite))setup,
+                             (void (*)(uc_suite suite))teardown);
+}
+
+void dev_uc_begin_group(dev_uc_suite suite, void (*setup)(dev_uc_suite suite),
+                        void (*teardown)(dev_uc_suite suite)) {
+        uc_begin_group((struct uc_suite *)suite,
+                       (void (*)(uc_suite suite))setup,
+                       (void (*)(uc_suite suite))teardown);
+}
+
+void dev_uc_end_group(dev_uc_suite suite) {
+        uc_end_group((struct uc_suite *)suite);
+}
+
+void dev_uc_set_test_fixture(dev_uc_suite suite,
+                             void (*setup)(dev_uc_suite suite),
+                             void (*teardown)(dev_uc_suite suite)) {
+        uc_set_test_fixture((struct uc_suite *)suite,
+                            (void (*)(uc_suite suite))setup,
+                            (void (*)(uc_suite suite))teardown);
+}
+
+void dev_uc_add_resource(dev_uc_suite suite, const char *name,
+                         const unsigned int capacity) {
+        uc_add_resource((struct uc_suite *)suite, name, capacity);
+}
+
+bool dev_uc_test_uses(dev_uc_suite suite, const char *resource,
+                      const unsigned int units) {
+        return uc_test_uses((struct uc_suite *)suite, resource, units);
+}
+
+bool dev_uc_test_after(dev_uc_suite suite, const char *prerequisite) {
+        return uc_test_after((struct uc_suite *)suite, prerequisite);
+}
+
+void dev_uc_set_batch_size(dev_uc_suite suite, const unsigned int batch_size) {
+        uc_set_batch_size((struct uc_suite *)suite, batch_size);
+}
+
+void dev_uc_set_jobs(dev_uc_suite suite, const unsigned int jobs) {
+        uc_set_jobs((struct uc_suite *)suite, jobs);
+}
+
+void dev_uc_set_output_limit(dev_uc_suite suite, const size_t limit) {
+        uc_set_output_limit((struct uc_suite *)suite, limit);
+}
+
+void dev_uc_set_cpus(dev_uc_suite suite, const int *cpus,
+                     const size_t num_cpus) {
+        uc_set_cpus((struct uc_suite *)suite, cpus, num_cpus);
+}
+
+void dev_uc_set_repeat(dev_uc_suite suite, const unsigned int times,
+                       const double seconds) {
+        uc_set_repeat((struct uc_suite *)suite, times, seconds);
+}
+
+void dev_uc_set_nice(dev_uc_suite suite, const int nice) {
+        uc_set_nice((struct uc_suite *)suite, nice);
+}
+
+void dev_uc_set_property_cases(dev_uc_suite suite, const unsigned long cases) {
+        uc_set_property_cases((struct uc_suite *)suite, cases);
+}
+
+void dev_uc_set_property_seed(dev_uc_suite suite, const uint64_t seed) {
+        uc_set_property_seed((struct uc_suite *)suite, seed);
+}
+
+void dev_uc_set_fuzz_limits(dev_uc_suite suite, const unsigned long runs,
+                            const double seconds) {
+        uc_set_fuzz_limits((struct uc_suite *)suite, runs, seconds);
+}
+
+void dev_uc_set_fuzz_timeout(dev_uc_suite suite, const double seconds) {
+        uc_set_fuzz_timeout((struct uc_suite *)suite, seconds);
+}
+
+void dev_uc_set_fuzz_output(dev_uc_suite suite, const char *dir) {
+        uc_set_fuzz_output((struct uc_suite *)suite, dir);
+}
+
+void dev_uc_set_realtime(dev_uc_suite suite, const int priority) {
+        uc_set_realtime((struct uc_suite *)suite, priority);
+}
+
+void dev_uc_set_coverage_map(dev_uc_suite suite, const char *path,
+                             void (*dump)(void), void (*reset)(void)) {
+        uc_set_coverage_map((struct uc_suite *)suite, path, dump, reset);
+}
+
+bool dev_uc_select_tests(dev_uc_suite suite, const char *changes_path) {
+        return uc_select_tests((struct uc_suite *)suite, changes_path);
+}
+
+void dev_uc_set_trace(dev_uc_suite suite, const char *path) {
+        uc_set_trace((struct uc_suite *)suite, path);
+}
+
+void dev_uc_set_profile(dev_uc_suite suite, const char *dir,
+                        const double min_seconds) {
+        uc_set_profile((struct uc_suite *)suite, dir, min_seconds);
+}
+
 void dev_uc_run_tests(dev_uc_suite suite) {
         uc_run_tests((struct uc_suite *)suite);
 }
 
+dev_uc_run dev_uc_run_tests_async(dev_uc_suite suite) {
+        return (dev_uc_run)uc_run_tests_async((struct uc_suite *)suite);
+}
+
+int dev_uc_run_fd(dev_uc_run run) {
+        return uc_run_fd((struct uc_run *)run);
+}
+
+bool dev_uc_run_step(dev_uc_run run) {
+        return uc_run_step((struct uc_run *)run);
+}
+
+void dev_uc_run_wait(dev_uc_run run) {
+        uc_run_wait((struct uc_run *)run);
+}
+
+void dev_uc_run_cancel(dev_uc_run run) {
+        uc_run_cancel((struct uc_run *)run);
+}
+
+void dev_uc_watch(dev_uc_suite suite, void (*report)(dev_uc_suite suite),
+                  const char *const *paths, const size_t num_paths) {
+        uc_watch((struct uc_suite *)suite, report, paths, num_paths);
+}
+
+dev_uc_registry dev_uc_registry_init(void) {
+        return (dev_uc_registry)uc_registry_init();
+}
+
+void dev_uc_registry_free(dev_uc_registry registry) {
+        uc_registry_free((struct uc_registry *)registry);
+}
+
+bool dev_uc_registry_add(dev_uc_registry registry, dev_uc_suite suite,
+                         dev_uc_suite parent) {
+        return uc_registry_add((struct uc_registry *)registry,
+                               (struct uc_suite *)suite,
+                               (struct uc_suite *)parent);
+}
+
+void dev_uc_registry_set_jobs(dev_uc_registry registry,
+                              const unsigned int jobs) {
+        uc_registry_set_jobs((struct uc_registry *)registry, jobs);
+}
+
+void dev_uc_registry_run(dev_uc_registry registry) {
+        uc_registry_run((struct uc_registry *)registry);
+}
+
+bool dev_uc_registry_all_passed(dev_uc_registry registry) {
+        return uc_registry_all_passed((struct uc_registry *)registry);
+}
+
 bool dev_uc_all_tests_passed(dev_uc_suite suite) {
         return uc_all_tests_passed((struct uc_suite *)suite);
 }
@@ -43,3 +268,7 @@ void dev_uc_report_basic(dev_uc_suite suite) {
 void dev_uc_report_standard(dev_uc_suite suite) {
         uc_report_standard((struct uc_suite *)suite);
 }
+
+void dev_uc_report_registry(dev_uc_registry registry) {
+        uc_report_registry((struct uc_registry *)registry);
+}
@@ -7,30 +7,167 @@
 #ifndef UNITC_DEV_H
 #define UNITC_DEV_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 #define dev_UC_OPT_NONE UC_OPT_NONE
+#define dev_UC_OPT_ZYGOTE UC_OPT_ZYGOTE
+#define dev_UC_OPT_THREADS UC_OPT_THREADS
+#define dev_UC_OPT_CAPTURE_OUTPUT UC_OPT_CAPTURE_OUTPUT
+#define dev_UC_OPT_DISCARD_PASSING_OUTPUT UC_OPT_DISCARD_PASSING_OUTPUT
+#define dev_UC_OPT_HEAP_STATS UC_OPT_HEAP_STATS
+#define dev_UC_OPT_FAIL_ON_LEAK UC_OPT_FAIL_ON_LEAK
+#define dev_UC_OPT_PERF_COUNTERS UC_OPT_PERF_COUNTERS
+#define dev_UC_OPT_PIN_CPUS UC_OPT_PIN_CPUS
+#define dev_UC_OPT_REPEAT_UNTIL_FAILURE UC_OPT_REPEAT_UNTIL_FAILURE
+#define dev_UC_OPT_PARALLEL UC_OPT_PARALLEL
 
 typedef uc_suite dev_uc_suite;
+typedef uc_run dev_uc_run;
+typedef uc_prop dev_uc_prop;
+typedef uc_registry dev_uc_registry;
 
-dev_uc_suite dev_uc_init(const uint_least8_t options, const char *name,
+dev_uc_suite dev_uc_init(const uint_least32_t options, const char *name,
                          const char *comment);
 
 void dev_uc_free(dev_uc_suite suite);
 
 void dev_uc_check(dev_uc_suite suite, const bool cond, const char *comment);
 
+void dev_uc_check_borrowed(dev_uc_suite suite, const bool cond,
+                           const char *comment);
+
+bool dev_uc_check_snapshot(dev_uc_suite suite, const void *buf,
+                           const size_t len, const char *path);
+
+bool dev_uc_check_snapshot_file(dev_uc_suite suite, const char *path,
+                                const char *golden_path);
+
+bool dev_uc_check_property(dev_uc_suite suite,
+                           bool (*property)(dev_uc_prop prop, void *data),
+                           void *data, const char *comment);
+
+int64_t dev_uc_gen_int(dev_uc_prop prop, const int64_t min, const int64_t max);
+
+double dev_uc_gen_double(dev_uc_prop prop, const double min, const double max);
+
+const uint8_t *dev_uc_gen_bytes(dev_uc_prop prop, const size_t max_len,
+                                size_t *len);
+
+const char *dev_uc_gen_string(dev_uc_prop prop, const size_t max_len);
+
 void dev_uc_add_test(dev_uc_suite suite, void (*test_func)(dev_uc_suite suite),
                  const char *name, const char *comment);
 
+void dev_uc_add_fuzz(dev_uc_suite suite,
+                     void (*func)(const uint8_t *data, size_t size),
+                     const char *name, const char *corpus_dir);
+
+void dev_uc_add_load_test(dev_uc_suite suite,
+                          bool (*func)(unsigned int caller),
+                          const char *name, const char *comment,
+                          const struct uc_load_options *options);
+
+void dev_uc_add_test_descs(dev_uc_suite suite,
+                           const struct uc_test_desc *start,
+                           const struct uc_test_desc *stop);
+
+#define dev_uc_add_defined_tests(suite)\
+        dev_uc_add_test_descs((suite), __start_uc_tests, __stop_uc_tests)
+
+void dev_uc_set_suite_fixture(dev_uc_suite suite,
+                              void (*setup)(dev_uc_suite suite),
+                              void (*teardown)(dev_uc_suite suite));
+
+void dev_uc_begin_group(dev_uc_suite suite, void (*setup)(dev_uc_suite suite),
+                        void (*teardown)(dev_uc_suite suite));
+
+void dev_uc_end_group(dev_uc_suite suite);
+
+void dev_uc_set_test_fixture(dev_uc_suite suite,
+                             void (*setup)(dev_uc_suite suite),
+                             void (*teardown)(dev_uc_suite suite));
+
+void dev_uc_add_resource(dev_uc_suite suite, const char *name,
+                         const unsigned int capacity);
+
+bool dev_uc_test_uses(dev_uc_suite suite, const char *resource,
+                      const unsigned int units);
+
+bool dev_uc_test_after(dev_uc_suite suite, const char *prerequisite);
+
+void dev_uc_set_batch_size(dev_uc_suite suite, const unsigned int batch_size);
+
+void dev_uc_set_jobs(dev_uc_suite suite, const unsigned int jobs);
+
+void dev_uc_set_output_limit(dev_uc_suite suite, const size_t limit);
+
+void dev_uc_set_cpus(dev_uc_suite suite, const int *cpus,
+                     const size_t num_cpus);
+
+void dev_uc_set_repeat(dev_uc_suite suite, const unsigned int times,
+                       const double seconds);
+
+void dev_uc_set_nice(dev_uc_suite suite, const int nice);
+
+void dev_uc_set_property_cases(dev_uc_suite suite, const unsigned long cases);
+
+void dev_uc_set_property_seed(dev_uc_suite suite, const uint64_t seed);
+
+void dev_uc_set_fuzz_limits(dev_uc_suite suite, const unsigned long runs,
+                            const double seconds);
+
+void dev_uc_set_fuzz_timeout(dev_uc_suite suite, const double seconds);
+
+void dev_uc_set_fuzz_output(dev_uc_suite suite, const char *dir);
+
+void dev_uc_set_realtime(dev_uc_suite suite, const int priority);
+
+void dev_uc_set_coverage_map(dev_uc_suite suite, const char *path,
+                             void (*dump)(void), void (*reset)(void));
+
+bool dev_uc_select_tests(dev_uc_suite suite, const char *changes_path);
+void dev_uc_set_trace(dev_uc_suite suite, const char *path);
+void dev_uc_set_profile(dev_uc_suite suite, const char *dir,
+                        const double min_seconds);
+
 void dev_uc_run_tests(dev_uc_suite suite);
 
+dev_uc_run dev_uc_run_tests_async(dev_uc_suite suite);
+
+int dev_uc_run_fd(dev_uc_run run);
+
+bool dev_uc_run_step(dev_uc_run run);
+
+void dev_uc_run_wait(dev_uc_run run);
+
+void dev_uc_run_cancel(dev_uc_run run);
+
+void dev_uc_watch(dev_uc_suite suite, void (*report)(dev_uc_suite suite),
+                  const char *const *paths, const size_t num_paths);
+
+dev_uc_registry dev_uc_registry_init(void);
+
+void dev_uc_registry_free(dev_uc_registry registry);
+
+bool dev_uc_registry_add(dev_uc_registry registry, dev_uc_suite suite,
+                         dev_uc_suite parent);
+
+void dev_uc_registry_set_jobs(dev_uc_registry registry,
+                              const unsigned int jobs);
+
+void dev_uc_registry_run(dev_uc_registry registry);
+
+bool dev_uc_registry_all_passed(dev_uc_registry registry);
+
 bool dev_uc_all_tests_passed(dev_uc_suite suite);
 
 void dev_uc_report_basic(dev_uc_suite suite);
 
 void dev_uc_report_standard(dev_uc_suite suite);
 
+void dev_uc_report_registry(dev_uc_registry registry);
+
 #endif /* UNITC_DEV_H */
 
@@ -9,8 +9,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <fcntl.h>
 
 #include <unitc.h>
@@ -56,6 +63,27 @@
   */
 static bool files_eq(char *path_a, char *path_b);
 
+/** Whether the file at path contains str, in its first 4095 bytes. */
+static bool file_contains(const char *path, const char *str);
+
+/** Remove the lines of the file at path starting with prefix (after
+  * indentation), e.g. to leave out timings before comparing reports.
+  */
+static void remove_lines(char *path, const char *prefix);
+
+/** Replace the number after each occurrence of word in the file at path
+  * with N, e.g. to leave out run numbers which depend on the mutations made.
+  */
+static void mask_numbers(char *path, const char *word);
+
+/** Copy the files of the directory from into the directory to. Returns
+  * false on failure.
+  */
+static bool copy_dir(const char *from, const char *to);
+
+/** Remove the directory at path with the files in it. */
+static void remove_dir(const char *path);
+
 static bool test_uc_init(void);
 
 static void test_files_eq(uc_suite);
@@ -65,6 +93,31 @@ static void test_uc_report_basic_with_tests(uc_suite);
 static void test_uc_report_standard(uc_suite);
 static void test_uc_report_standard_with_tests(uc_suite);
 static void test_isolation(uc_suite);
+static void test_fixtures(uc_suite);
+static void test_zygote(uc_suite);
+static void test_batches(uc_suite);
+static void test_threads(uc_suite);
+static void test_threaded_checks(uc_suite);
+static void test_capture_output(uc_suite);
+static void test_crash(uc_suite);
+static void test_heap_stats(uc_suite);
+static void test_perf_counters(uc_suite);
+static void test_placement(uc_suite);
+static void test_async(uc_suite);
+static void test_repeat(uc_suite);
+static void test_defined_tests(uc_suite);
+static void test_comments(uc_suite);
+static void test_properties(uc_suite);
+static void test_fuzz(uc_suite);
+static void test_snapshots(uc_suite);
+static void test_watch(uc_suite);
+static void test_registry(uc_suite);
+static void test_coverage_map(uc_suite);
+static void test_trace(uc_suite);
+static void test_profile(uc_suite);
+static void test_scheduling(uc_suite);
+static void test_registry_scheduling(uc_suite);
+static void test_load(uc_suite);
 
 int main(void) {
         uc_suite main_suite;
@@ -93,6 +146,56 @@ int main(void) {
         uc_add_test(main_suite, &test_isolation,
                     "Isolation tests",
                     "By using the same static int in separate tests.");
+        uc_add_test(main_suite, &test_fixtures, "Fixture tests",
+                    "Suite and group fixtures run once in the parent.");
+        uc_add_test(main_suite, &test_zygote, "Zygote tests",
+                    "Tests spawned by a zygote process.");
+        uc_add_test(main_suite, &test_batches, "Batch tests",
+                    "Several tests per process.");
+        uc_add_test(main_suite, &test_threads, "Thread pool tests",
+                    "Tests run on threads report like tests run in processes.");
+        uc_add_test(main_suite, &test_threaded_checks, "Threaded check tests",
+                    "uc_check from several threads of a test.");
+        uc_add_test(main_suite, &test_capture_output, "Output capture tests",
+                    NULL);
+        uc_add_test(main_suite, &test_crash, "Crash tests",
+                    "Crashed tests keep their checks.");
+        uc_add_test(main_suite, &test_heap_stats, "Heap stats tests", NULL);
+        uc_add_test(main_suite, &test_perf_counters, "Perf counter tests",
+                    "Counters may be unavailable, only the results are "
+                    "checked.");
+        uc_add_test(main_suite, &test_placement, "Placement tests", NULL);
+        uc_add_test(main_suite, &test_async, "Asynchronous run tests",
+                    "Stepped with poll, then cancelled.");
+        uc_add_test(main_suite, &test_repeat, "Repeat tests",
+                    "Run times are left out of the report.");
+        uc_add_test(main_suite, &test_defined_tests, "UC_TEST tests",
+                    "Tests registered in the uc_tests section.");
+        uc_add_test(main_suite, &test_comments, "Comment tests",
+                    "Borrowed and repeated comments.");
+        uc_add_test(main_suite, &test_properties, "Property tests",
+                    "Seeded generators and shrinking.");
+        uc_add_test(main_suite, &test_fuzz, "Fuzz tests",
+                    "Crashing inputs are minimised and reported.");
+        uc_add_test(main_suite, &test_snapshots, "Snapshot tests",
+                    "Golden files compared and updated.");
+        uc_add_test(main_suite, &test_watch, "Watch tests",
+                    "One run, stopped while watching.");
+        uc_add_test(main_suite, &test_registry, "Registry tests",
+                    "Suites and a sub-suite sharing two processes.");
+        uc_add_test(main_suite, &test_coverage_map, "Coverage map tests",
+                    "With gcov's counters read from test_resources.");
+        uc_add_test(main_suite, &test_trace, "Trace tests",
+                    "Spans and counters of a run of two tests.");
+        uc_add_test(main_suite, &test_profile, "Profile tests",
+                    "A slow test profiled, a fast one left out.");
+        uc_add_test(main_suite, &test_scheduling, "Scheduling tests",
+                    "Parallel tests with resources and prerequisites.");
+        uc_add_test(main_suite, &test_registry_scheduling,
+                    "Registry scheduling tests",
+                    "Resources and a test running alone across suites.");
+        uc_add_test(main_suite, &test_load, "Load tests",
+                    "Counted, timed and crashing load tests.");
         uc_run_tests(main_suite);
 
         uc_report_standard(main_suite);
@@ -129,6 +232,131 @@ static bool files_eq(char *path_a, char *path_b) {
         return a_char == b_char;
 }
 
+static void remove_lines(char *path, const char *prefix) {
+        char line[1024];
+        FILE *file, *kept;
+
+        file = fopen(path, "r");
+        if (file == NULL) return;
+
+        kept = tmpfile();
+        if (kept == NULL) {
+                fclose(file);
+                return;
+        }
+
+        while (fgets(line, sizeof(line), file) != NULL) {
+                const char *start = line + strspn(line, " ");
+
+                if (strncmp(start, prefix, strlen(prefix)) != 0) {
+                        fputs(line, kept);
+                }
+        }
+        fclose(file);
+
+        file = fopen(path, "w");
+        if (file != NULL) {
+                rewind(kept);
+                while (fgets(line, sizeof(line), kept) != NULL) {
+                        fputs(line, file);
+                }
+                fclose(file);
+        }
+
+        fclose(kept);
+}
+
+static void mask_numbers(char *path, const char *word) {
+        char line[1024], masked[1024];
+        FILE *file, *kept;
+
+        file = fopen(path, "r");
+        if (file == NULL) return;
+
+        kept = tmpfile();
+        if (kept == NULL) {
+                fclose(file);
+                return;
+        }
+
+        while (fgets(line, sizeof(line), file) != NULL) {
+                const char *from = line;
+                char *to = masked;
+                const char *found;
+
+                while ((found = strstr(from, word)) != NULL) {
+                        found += strlen(word);
+                        memcpy(to, from, found - from);
+                        to += found - from;
+                        from = found + strspn(found, "0123456789");
+                        if (from != found) *to++ = 'N';
+                }
+                strcpy(to, from);
+                fputs(masked, kept);
+        }
+        fclose(file);
+
+        file = fopen(path, "w");
+        if (file != NULL) {
+                rewind(kept);
+                while (fgets(line, sizeof(line), kept) != NULL) {
+                        fputs(line, file);
+                }
+                fclose(file);
+        }
+
+        fclose(kept);
+}
+
+static bool copy_dir(const char *from, const char *to) {
+        DIR *dir = opendir(from);
+        struct dirent *entry;
+        bool copied = dir != NULL;
+
+        while (copied && (entry = readdir(dir)) != NULL) {
+                char from_path[1024], to_path[1024];
+                FILE *in, *out;
+                int c;
+
+                if (entry->d_name[0] == '.') continue;
+
+                snprintf(from_path, sizeof(from_path), "%s/%s", from,
+                         entry->d_name);
+                snprintf(to_path, sizeof(to_path), "%s/%s", to,
+                         entry->d_name);
+                in = fopen(from_path, "rb");
+                out = fopen(to_path, "wb");
+                copied = in != NULL && out != NULL;
+                while (copied && (c = fgetc(in)) != EOF) fputc(c, out);
+                if (in != NULL) fclose(in);
+                if (out != NULL && fclose(out) == EOF) copied = false;
+        }
+
+        if (dir != NULL) closedir(dir);
+        return copied;
+}
+
+static void remove_dir(const char *path) {
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+
+        while (dir != NULL && (entry = readdir(dir)) != NULL) {
+                char entry_path[1024];
+
+                if (strcmp(entry->d_name, ".") == 0 ||
+                    strcmp(entry->d_name, "..") == 0) {
+                        continue;
+                }
+
+                snprintf(entry_path, sizeof(entry_path), "%s/%s", path,
+                         entry->d_name);
+                remove(entry_path);
+        }
+
+        if (dir != NULL) closedir(dir);
+        remove(path);
+}
+
 static void test_files_eq(uc_suite suite) {
         uc_check(suite, files_eq(TEST_DIR "files_eq_equal_a",
                                  TEST_DIR "files_eq_equal_b"),
@@ -542,3 +770,2230 @@ static void test_isolation(uc_suite suite) {
         dev_uc_free(sut_suite);
 }
 
+
+static int suite_fixture = 0, group_fixture = 0;
+static unsigned int suite_setups = 0, suite_teardowns = 0;
+static unsigned int group_setups = 0, group_teardowns = 0;
+static unsigned int test_setups = 0;
+
+static void fixture_suite_setup(dev_uc_suite suite) {
+        suite_fixture = 42;
+        ++suite_setups;
+}
+
+static void fixture_suite_teardown(dev_uc_suite suite) {
+        suite_fixture = 0;
+        ++suite_teardowns;
+}
+
+static void fixture_group_a_setup(dev_uc_suite suite) {
+        group_fixture = 1;
+        ++group_setups;
+}
+
+static void fixture_group_b_setup(dev_uc_suite suite) {
+        group_fixture = 2;
+        ++group_setups;
+}
+
+static void fixture_group_teardown(dev_uc_suite suite) {
+        group_fixture = 0;
+        ++group_teardowns;
+}
+
+static void fixture_test_setup(dev_uc_suite suite) {
+        ++test_setups;
+}
+
+static void fixture_group_a_test(dev_uc_suite suite) {
+        dev_uc_check(suite, suite_fixture == 42, "Suite fixture inherited.");
+        dev_uc_check(suite, group_fixture == 1, "Group a fixture inherited.");
+        dev_uc_check(suite, test_setups == 1, "Test fixture ran once.");
+}
+
+static void fixture_group_b_test(dev_uc_suite suite) {
+        dev_uc_check(suite, suite_fixture == 42, "Suite fixture inherited.");
+        dev_uc_check(suite, group_fixture == 2, "Group b fixture inherited.");
+        dev_uc_check(suite, test_setups == 1, "Test fixture ran once.");
+}
+
+static void fixture_no_group_test(dev_uc_suite suite) {
+        dev_uc_check(suite, suite_fixture == 42, "Suite fixture inherited.");
+        dev_uc_check(suite, group_fixture == 0, "Group fixture torn down.");
+}
+
+static void test_fixtures(uc_suite suite) {
+        dev_uc_suite sut_suite;
+
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, NULL, NULL);
+        dev_uc_set_suite_fixture(sut_suite, &fixture_suite_setup,
+                                 &fixture_suite_teardown);
+        dev_uc_set_test_fixture(sut_suite, &fixture_test_setup, NULL);
+        dev_uc_begin_group(sut_suite, &fixture_group_a_setup,
+                           &fixture_group_teardown);
+        dev_uc_add_test(sut_suite, &fixture_group_a_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &fixture_group_a_test, NULL, NULL);
+        dev_uc_begin_group(sut_suite, &fixture_group_b_setup,
+                           &fixture_group_teardown);
+        dev_uc_add_test(sut_suite, &fixture_group_b_test, NULL, NULL);
+        dev_uc_end_group(sut_suite);
+        dev_uc_add_test(sut_suite, &fixture_no_group_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+
+        uc_check(suite, dev_uc_all_tests_passed(sut_suite),
+                 "Check tests see the fixtures set up in the parent.");
+        uc_check(suite, suite_setups == 1 && suite_teardowns == 1,
+                 "Check the suite fixture ran once.");
+        uc_check(suite, group_setups == 2 && group_teardowns == 2,
+                 "Check each group fixture ran once.");
+        uc_check(suite, test_setups == 0 && suite_fixture == 0,
+                 "Check the test fixture only ran in test processes.");
+
+        dev_uc_free(sut_suite);
+}
+
+static void crash_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        abort();
+}
+
+static void test_zygote(uc_suite suite) {
+        dev_uc_suite sut_suite;
+
+        sut_suite = dev_uc_init(dev_UC_OPT_ZYGOTE, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+
+        uc_check(suite, dev_uc_all_tests_passed(sut_suite),
+                 "Check each zygote test ran in a separate address space.");
+
+        dev_uc_free(sut_suite);
+
+        group_setups = 0;
+        sut_suite = dev_uc_init(dev_UC_OPT_ZYGOTE, NULL, NULL);
+        dev_uc_set_suite_fixture(sut_suite, &fixture_suite_setup, NULL);
+        dev_uc_set_test_fixture(sut_suite, &fixture_test_setup, NULL);
+        dev_uc_begin_group(sut_suite, &fixture_group_a_setup, NULL);
+        dev_uc_add_test(sut_suite, &fixture_group_a_test, NULL, NULL);
+        dev_uc_end_group(sut_suite);
+        dev_uc_add_test(sut_suite, &crash_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+
+        uc_check(suite, group_setups == 0,
+                 "Check group fixtures ran in the zygote.");
+
+        dev_uc_check(sut_suite, true, NULL);
+        uc_check(suite, !dev_uc_all_tests_passed(sut_suite),
+                 "Check a crashing zygote test does not pass.");
+
+        dev_uc_free(sut_suite);
+}
+
+static void test_batches(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        /* Batches of 3 and 2: the static is only reset between them. A crash
+         * only fails the crashing test.
+         */
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Batches", NULL);
+        dev_uc_set_batch_size(sut_suite, 3);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &incr_static, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &crash_test, "Crash", NULL);
+        dev_uc_add_test(sut_suite, &unsucc_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_batch_a"),
+                 "Check batch report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/** Outputs the standard report of a suite run with options (and jobs). */
+static void report_threads_suite(const uint_least32_t options,
+                                 const unsigned int jobs) {
+        dev_uc_suite sut_suite;
+
+        sut_suite = dev_uc_init(options, "Threads", "Same report.");
+        dev_uc_set_jobs(sut_suite, jobs);
+        dev_uc_check(sut_suite, true, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, "Success", NULL);
+        dev_uc_add_test(sut_suite, &unsucc_test, NULL, "Failure");
+        dev_uc_begin_group(sut_suite, &fixture_group_b_setup,
+                           &fixture_group_teardown);
+        for (int i = 0; i < 20; ++i) {
+                dev_uc_add_test(sut_suite, &standard_e_test_1, NULL, NULL);
+                dev_uc_add_test(sut_suite, &basic_d_test_1, NULL, NULL);
+        }
+        dev_uc_end_group(sut_suite);
+        dev_uc_add_test(sut_suite, &standard_e_test_2, "Last", NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+}
+
+static void test_threads(uc_suite suite) {
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char threads_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+        strncpy(threads_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1 || close(tmp_file_fd) == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        tmp_file_fd = mkstemp(threads_file_path);
+        if (tmp_file_fd == -1 || close(tmp_file_fd) == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        report_threads_suite(dev_UC_OPT_NONE, 0);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        STDOUT_REDIR_SET_UP(threads_file_path, tmp_file_fd);
+        report_threads_suite(dev_UC_OPT_THREADS, 4);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path, threads_file_path),
+                 "Check a thread pool report matches a process report.");
+
+        STDOUT_REDIR_SET_UP(threads_file_path, tmp_file_fd);
+        report_threads_suite(dev_UC_OPT_THREADS, 1);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path, threads_file_path),
+                 "Check a single thread report matches a process report.");
+
+        if (remove(tmp_file_path) == -1 || remove(threads_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void *checking_thread(void *suite) {
+        for (int i = 0; i < 1000; ++i) dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, false, "Thread failure.");
+
+        return NULL;
+}
+
+static void threaded_checks_test(dev_uc_suite suite) {
+        pthread_t threads[4];
+
+        for (int i = 0; i < 4; ++i) {
+                pthread_create(&threads[i], NULL, &checking_thread, suite);
+        }
+        checking_thread(suite);
+        for (int i = 0; i < 4; ++i) pthread_join(threads[i], NULL);
+}
+
+static void test_threaded_checks(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Threaded checks", NULL);
+        dev_uc_add_test(sut_suite, &threaded_checks_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        threaded_checks_test(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite,
+                 files_eq(tmp_file_path, TEST_DIR "uc_report_threaded_a"),
+                 "Check threaded checks report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void loud_succ_test(dev_uc_suite suite) {
+        for (int i = 0; i < 10000; ++i) printf("Passing output %d.\n", i);
+        dev_uc_check(suite, true, NULL);
+}
+
+static void loud_unsucc_test(dev_uc_suite suite) {
+        puts("Some output.");
+        fflush(stdout);
+        fputs("Error output.\n", stderr);
+        dev_uc_check(suite, false, "Failure.");
+}
+
+static void nul_output_test(dev_uc_suite suite) {
+        fwrite("Before\0after.\n", 1, 14, stdout);
+        fflush(stdout);
+        dev_uc_check(suite, false, "Failure.");
+}
+
+static void test_capture_output(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_CAPTURE_OUTPUT, "Capture", NULL);
+        dev_uc_add_test(sut_suite, &loud_succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &loud_unsucc_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &crash_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &nul_output_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_CAPTURE_OUTPUT |
+                                dev_UC_OPT_DISCARD_PASSING_OUTPUT,
+                                "Limited", NULL);
+        dev_uc_set_output_limit(sut_suite, 20);
+        dev_uc_add_test(sut_suite, &loud_succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &loud_unsucc_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_capture_a"),
+                 "Check capture report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/* Not a constant so the compiler cannot see the bad write. */
+static int *volatile segv_address = (int *)0x10;
+
+static void segv_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, false, "Failing before the crash.");
+        *segv_address = 0;
+}
+
+static void killed_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        raise(SIGKILL);
+}
+
+static void test_crash(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Crashes", NULL);
+        dev_uc_add_test(sut_suite, &segv_test, "Segfault", NULL);
+        dev_uc_add_test(sut_suite, &crash_test, "Abort", NULL);
+        dev_uc_add_test(sut_suite, &killed_test, "Killed", NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, !dev_uc_all_tests_passed(sut_suite),
+                 "Check crashed tests do not pass.");
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_crash_a"),
+                 "Check crash report a.");
+
+        dev_uc_free(sut_suite);
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/* Volatile so the compiler keeps the allocations. */
+static void *volatile heap_block;
+
+static void balanced_heap_test(dev_uc_suite suite) {
+        heap_block = malloc(100);
+        heap_block = realloc(heap_block, 200);
+        free(heap_block);
+        dev_uc_check(suite, true, "Checks are not counted.");
+}
+
+static void leaky_heap_test(dev_uc_suite suite) {
+        heap_block = calloc(10, 10);
+        heap_block = malloc(100);
+        dev_uc_check(suite, true, NULL);
+}
+
+/* Allocated before the tests run, so freeing it is not the tests' business. */
+static void *early_block;
+
+static void early_free_heap_test(dev_uc_suite suite) {
+        free(early_block);
+        early_block = NULL;
+        heap_block = malloc(100);
+        dev_uc_check(suite, true, NULL);
+}
+
+static void test_heap_stats(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_HEAP_STATS, "Heap", NULL);
+        dev_uc_add_test(sut_suite, &balanced_heap_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &leaky_heap_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_HEAP_STATS |
+                                dev_UC_OPT_FAIL_ON_LEAK, "Leaks", NULL);
+        dev_uc_add_test(sut_suite, &balanced_heap_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &leaky_heap_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &early_free_heap_test, NULL, NULL);
+        early_block = malloc(1000);
+        dev_uc_run_tests(sut_suite);
+        free(early_block);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_heap_a"),
+                 "Check heap report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/** Touches freshly mapped memory, so it takes page faults. */
+static void faulting_test(dev_uc_suite suite) {
+        size_t size = 1 << 20;
+        char *volatile block = malloc(size);
+
+        if (block != NULL) memset(block, 1, size);
+        free(block);
+        dev_uc_check(suite, block != NULL, NULL);
+}
+
+static void test_perf_counters(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char line[512] = "";
+        int tmp_file_fd, orig_stdout, paranoid_level = 3;
+        FILE *report, *paranoid;
+
+        sut_suite = dev_uc_init(dev_UC_OPT_PERF_COUNTERS, NULL, NULL);
+        dev_uc_set_batch_size(sut_suite, 2);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+
+        uc_check(suite, dev_uc_all_tests_passed(sut_suite),
+                 "Check counted tests send their checks.");
+
+        dev_uc_add_test(sut_suite, &unsucc_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+
+        uc_check(suite, !dev_uc_all_tests_passed(sut_suite),
+                 "Check counted tests send their failures.");
+
+        dev_uc_free(sut_suite);
+
+        strcpy(tmp_file_path, TMP_FILE_TEMPLATE);
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(tmp_file_fd);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_PERF_COUNTERS, NULL, NULL);
+        dev_uc_add_test(sut_suite, &faulting_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+        dev_uc_free(sut_suite);
+
+        report = fopen(tmp_file_path, "r");
+        while (report != NULL && fgets(line, sizeof(line), report) != NULL) {
+                if (strstr(line, "Counters:") != NULL) break;
+                line[0] = '\0';
+        }
+        if (report != NULL) fclose(report);
+
+        /* Software counters need no PMU, only perf_event_paranoid <= 2. */
+        paranoid = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+        if (paranoid != NULL) {
+                if (fscanf(paranoid, "%d", &paranoid_level) != 1) {
+                        paranoid_level = 3;
+                }
+                fclose(paranoid);
+        }
+        uc_check(suite, paranoid_level > 2 ||
+                        strstr(line, "Counters:") != NULL,
+                 "Check counters are reported.");
+
+        if (strstr(line, "Counters:") != NULL) {
+                const char *task_clock = strstr(line, "task-clock ");
+                const char *page_faults = strstr(line, "page-faults ");
+                bool has_pmu =
+                        access("/sys/bus/event_source/devices/cpu",
+                               F_OK) == 0 ||
+                        access("/sys/bus/event_source/devices/cpu_core",
+                               F_OK) == 0;
+
+                uc_check(suite, task_clock != NULL &&
+                                strtod(task_clock + strlen("task-clock "),
+                                       NULL) > 0,
+                         "Check task-clock is counted.");
+                uc_check(suite, page_faults != NULL &&
+                                strtoul(page_faults + strlen("page-faults "),
+                                        NULL, 10) > 0,
+                         "Check page-faults are counted.");
+                uc_check(suite, has_pmu ||
+                                strstr(line, "instructions") == NULL,
+                         "Check hardware counters are left out without a "
+                         "PMU.");
+        }
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void nice_test(dev_uc_suite suite) {
+        dev_uc_check(suite, getpriority(PRIO_PROCESS, 0) == 19,
+                     "Should run at nice 19.");
+}
+
+static void test_placement(uc_suite suite) {
+        static const int cpus[] = { 0 };
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        /* Every machine has a CPU 0 and may raise its nice level to 19. */
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Processes", NULL);
+        /* Ignored. */
+        dev_uc_set_cpus(sut_suite, NULL, 1);
+        dev_uc_set_cpus(sut_suite, cpus, 1);
+        dev_uc_set_nice(sut_suite, 19);
+        dev_uc_add_test(sut_suite, &nice_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &nice_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_THREADS, "Threads", NULL);
+        dev_uc_set_cpus(sut_suite, cpus, 1);
+        dev_uc_set_jobs(sut_suite, 2);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_placement_a"),
+                 "Check placement report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void hanging_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        pause();
+}
+
+static void slow_exit(void) {
+        usleep(300000);
+}
+
+/* Its process takes a while to exit once its results are sent. */
+static void slow_exit_test(dev_uc_suite suite) {
+        atexit(&slow_exit);
+        dev_uc_check(suite, true, NULL);
+}
+
+/* Slow enough for a step waiting for it to show. */
+static void slow_thread_test(dev_uc_suite suite) {
+        usleep(300000);
+        dev_uc_check(suite, true, NULL);
+}
+
+static void test_async(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        dev_uc_run run;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+        unsigned int steps;
+        double longest;
+        bool more;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_CAPTURE_OUTPUT, "Stepped", NULL);
+        dev_uc_add_test(sut_suite, &loud_succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &loud_unsucc_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &crash_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        run = dev_uc_run_tests_async(sut_suite);
+        uc_check(suite, run != NULL, "Check the run starts.");
+        while (dev_uc_run_step(run)) {
+                struct pollfd fds = { dev_uc_run_fd(run), POLLIN, 0 };
+
+                poll(&fds, 1, -1);
+        }
+        dev_uc_run_wait(run);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Cancelled", NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &hanging_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        run = dev_uc_run_tests_async(sut_suite);
+        /* Long enough for the first test to finish. */
+        for (steps = 0; steps < 20 && dev_uc_run_step(run); ++steps) {
+                struct pollfd fds = { dev_uc_run_fd(run), POLLIN, 0 };
+
+                poll(&fds, 1, 50);
+        }
+        dev_uc_run_cancel(run);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, !dev_uc_all_tests_passed(sut_suite),
+                 "Check a cancelled test does not pass.");
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_async_a"),
+                 "Check async report a.");
+
+        dev_uc_free(sut_suite);
+
+        for (int zygote = 0; zygote < 2; ++zygote) {
+                sut_suite = dev_uc_init(zygote ? dev_UC_OPT_ZYGOTE :
+                                                 dev_UC_OPT_NONE, NULL, NULL);
+                dev_uc_add_test(sut_suite, &slow_exit_test, NULL, NULL);
+                run = dev_uc_run_tests_async(sut_suite);
+                longest = 0;
+                do {
+                        struct pollfd fds = { dev_uc_run_fd(run), POLLIN, 0 };
+                        struct timespec start, end;
+                        double secs;
+
+                        clock_gettime(CLOCK_MONOTONIC, &start);
+                        more = dev_uc_run_step(run);
+                        clock_gettime(CLOCK_MONOTONIC, &end);
+                        secs = (end.tv_sec - start.tv_sec) +
+                               (end.tv_nsec - start.tv_nsec) / 1e9;
+                        if (secs > longest) longest = secs;
+
+                        if (more) poll(&fds, 1, -1);
+                } while (more);
+                dev_uc_run_wait(run);
+
+                uc_check(suite, longest < 0.15,
+                         zygote ? "Check a step doesn't wait for the zygote "
+                                  "to report an exit." :
+                                  "Check a step doesn't wait for a test "
+                                  "process to exit.");
+                uc_check(suite, dev_uc_all_tests_passed(sut_suite),
+                         "Check a slowly exiting test passes.");
+                dev_uc_free(sut_suite);
+        }
+
+        sut_suite = dev_uc_init(dev_UC_OPT_THREADS, NULL, NULL);
+        dev_uc_add_test(sut_suite, &slow_thread_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        run = dev_uc_run_tests_async(sut_suite);
+        longest = 0;
+        steps = 0;
+        do {
+                struct pollfd fds = { dev_uc_run_fd(run), POLLIN, 0 };
+                struct timespec start, end;
+                double secs;
+
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                more = dev_uc_run_step(run);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                secs = (end.tv_sec - start.tv_sec) +
+                       (end.tv_nsec - start.tv_nsec) / 1e9;
+                if (secs > longest) longest = secs;
+                if (steps++ == 0) {
+                        uc_check(suite, more,
+                                 "Check the first step leaves the threads "
+                                 "running.");
+                }
+
+                if (more) poll(&fds, 1, -1);
+        } while (more);
+        dev_uc_run_wait(run);
+
+        uc_check(suite, longest < 0.15,
+                 "Check a step doesn't wait for tests running on threads.");
+        uc_check(suite, dev_uc_all_tests_passed(sut_suite),
+                 "Check tests stepped on threads pass.");
+        dev_uc_free(sut_suite);
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+#define FLAKY_RUNS_FILE TEST_DIR "flaky_runs"
+
+/* Fails on its third run, counted in FLAKY_RUNS_FILE. */
+static void flaky_test(dev_uc_suite suite) {
+        struct stat runs;
+        int fd;
+
+        fd = open(FLAKY_RUNS_FILE, O_WRONLY | O_APPEND | O_CREAT, 0600);
+        if (fd == -1 || write(fd, "x", 1) != 1 || fstat(fd, &runs) == -1) {
+                fputs("Failed to count runs.", stderr);
+        }
+        if (fd != -1) close(fd);
+
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, runs.st_size != 3, "Third run.");
+}
+
+static void test_repeat(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char trace_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char line[512];
+        /* Where the runs' test spans start and end, and the kept run's. */
+        double starts[5] = {0}, ends[5] = {0}, kept_end = -1;
+        unsigned int spans = 0;
+        bool third_kept = false;
+        int tmp_file_fd, orig_stdout, trace_fd;
+        FILE *trace;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_ZYGOTE, "Parallel", NULL);
+        dev_uc_set_repeat(sut_suite, 5, 0);
+        dev_uc_set_jobs(sut_suite, 2);
+        dev_uc_add_test(sut_suite, &succ_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &unsucc_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &crash_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        /* One job so runs finish in order. */
+        remove(FLAKY_RUNS_FILE);
+        sut_suite = dev_uc_init(dev_UC_OPT_REPEAT_UNTIL_FAILURE,
+                                "Until failure", NULL);
+        dev_uc_set_repeat(sut_suite, 10, 60);
+        dev_uc_set_jobs(sut_suite, 1);
+        dev_uc_add_test(sut_suite, &flaky_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        remove_lines(tmp_file_path, "Run time:");
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_repeat_a"),
+                 "Check repeat report a.");
+
+        /* The third of five runs is kept: its span has to be kept with its
+         * results, not the last run's.
+         */
+        strcpy(trace_path, TMP_FILE_TEMPLATE);
+        trace_fd = mkstemp(trace_path);
+        if (trace_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(trace_fd);
+
+        remove(FLAKY_RUNS_FILE);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Traced", NULL);
+        dev_uc_set_repeat(sut_suite, 5, 0);
+        dev_uc_set_jobs(sut_suite, 1);
+        dev_uc_set_trace(sut_suite, trace_path);
+        dev_uc_add_test(sut_suite, &flaky_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_free(sut_suite);
+
+        trace = fopen(trace_path, "r");
+        while (trace != NULL && fgets(line, sizeof(line), trace) != NULL) {
+                const char *ts = strstr(line, "\"ts\":");
+                const char *dur = strstr(line, "\"dur\":");
+
+                if (ts == NULL || strstr(line, "\"checks\":") == NULL) {
+                        continue;
+                }
+
+                if (strstr(line, "\"ph\":\"i\"") != NULL) {
+                        kept_end = strtod(ts + strlen("\"ts\":"), NULL);
+                        third_kept = strstr(line, "\"kept_run\":3,") != NULL;
+                } else if (dur != NULL && spans < 5) {
+                        starts[spans] = strtod(ts + strlen("\"ts\":"), NULL);
+                        ends[spans] = starts[spans] +
+                                      strtod(dur + strlen("\"dur\":"), NULL);
+                        ++spans;
+                }
+        }
+        if (trace != NULL) fclose(trace);
+
+        uc_check(suite, spans == 5 && third_kept && kept_end >= ends[1] &&
+                        kept_end <= starts[3],
+                 "Check the kept run's span is kept with its results.");
+
+        if (remove(trace_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (remove(FLAKY_RUNS_FILE) == -1) {
+                fputs("Could not remove run count file", stderr);
+        }
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+UC_TEST(defined_succ_test, "Defined first.") {
+        dev_uc_check(suite, true, NULL);
+}
+
+UC_TEST(defined_unsucc_test, NULL) {
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, false, "Defined failure.");
+}
+
+static void test_defined_tests(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Defined", NULL);
+        dev_uc_add_test(sut_suite, &succ_test, "Added", NULL);
+        dev_uc_add_defined_tests(sut_suite);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_defined_a"),
+                 "Check defined tests report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void repeated_comment_test(dev_uc_suite suite) {
+        char copied[] = "Copied.";
+
+        for (int i = 0; i < 3; ++i) {
+                dev_uc_check_borrowed(suite, i != 1, "Borrowed.");
+                dev_uc_check(suite, false, copied);
+        }
+        dev_uc_check_borrowed(suite, true, NULL);
+}
+
+static void repeated_comment_crash_test(dev_uc_suite suite) {
+        dev_uc_check_borrowed(suite, false, "Borrowed.");
+        dev_uc_check(suite, true, "Last before the crash.");
+        abort();
+}
+
+/** Checks made by many_comments_test, and the length of their comment. */
+#define MANY_CHECKS 1000
+#define LONG_COMMENT_LEN 256
+
+static void many_comments_test(dev_uc_suite suite) {
+        char comment[LONG_COMMENT_LEN + 1];
+
+        memset(comment, 'c', LONG_COMMENT_LEN);
+        comment[LONG_COMMENT_LEN] = '\0';
+        for (int i = 0; i < MANY_CHECKS; ++i) {
+                dev_uc_check(suite, false, comment);
+        }
+}
+
+static void test_comments(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char trace_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char line[512];
+        unsigned long long bytes = 0;
+        int tmp_file_fd, orig_stdout, trace_fd;
+        FILE *trace;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        /* One process sends comments once for all of its tests. */
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Processes", NULL);
+        dev_uc_set_batch_size(sut_suite, 3);
+        dev_uc_add_test(sut_suite, &repeated_comment_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &repeated_comment_test, NULL, NULL);
+        dev_uc_add_test(sut_suite, &repeated_comment_crash_test, NULL, NULL);
+        dev_uc_check_borrowed(sut_suite, false, "Borrowed suite check.");
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_THREADS, "Threads", NULL);
+        dev_uc_add_test(sut_suite, &repeated_comment_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_comments_a"),
+                 "Check comments report a.");
+
+        /* The bytes received by the parent, from the trace, show whether
+         * the comment was sent once or with every check.
+         */
+        strcpy(trace_path, TMP_FILE_TEMPLATE);
+        trace_fd = mkstemp(trace_path);
+        if (trace_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(trace_fd);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Interned", NULL);
+        dev_uc_add_test(sut_suite, &many_comments_test, NULL, NULL);
+        dev_uc_set_trace(sut_suite, trace_path);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_free(sut_suite);
+
+        trace = fopen(trace_path, "r");
+        while (trace != NULL && fgets(line, sizeof(line), trace) != NULL) {
+                const char *count = strstr(line, "\"bytes\":");
+
+                if (count != NULL) {
+                        unsigned long long n =
+                                strtoull(count + strlen("\"bytes\":"),
+                                         NULL, 10);
+
+                        if (n > bytes) bytes = n;
+                }
+        }
+        if (trace != NULL) fclose(trace);
+
+        uc_check(suite, bytes > 0 &&
+                        bytes < MANY_CHECKS * LONG_COMMENT_LEN / 10,
+                 "Check a repeated comment is sent once.");
+
+        if (remove(trace_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static bool small_int_prop(dev_uc_prop prop, void *data) {
+        int64_t x = dev_uc_gen_int(prop, -1000000, 1000000);
+
+        return x < 1000 && x > -1000;
+}
+
+static bool positive_int_prop(dev_uc_prop prop, void *data) {
+        int64_t x = dev_uc_gen_int(prop, 10, 20);
+
+        return x < 15;
+}
+
+static bool undo_prop(dev_uc_prop prop, void *data) {
+        int64_t a = dev_uc_gen_int(prop, INT32_MIN, INT32_MAX);
+        int64_t b = dev_uc_gen_int(prop, INT32_MIN, INT32_MAX);
+
+        ++*(unsigned long *)data;
+        return (a + b) - b == a;
+}
+
+static bool no_z_prop(dev_uc_prop prop, void *data) {
+        const char *s = dev_uc_gen_string(prop, 16);
+
+        return strchr(s, 'z') == NULL;
+}
+
+static bool ascii_prop(dev_uc_prop prop, void *data) {
+        size_t len;
+        const uint8_t *bytes = dev_uc_gen_bytes(prop, 8, &len);
+
+        for (size_t i = 0; i < len; ++i) {
+                if (bytes[i] > 0x7f) return false;
+        }
+        return true;
+}
+
+static bool square_prop(dev_uc_prop prop, void *data) {
+        double x = dev_uc_gen_double(prop, -10, 10);
+
+        return x * x < 2;
+}
+
+static void property_test(dev_uc_suite suite) {
+        unsigned long cases = 0;
+
+        dev_uc_check_property(suite, &small_int_prop, NULL, "Small ints.");
+        dev_uc_check_property(suite, &positive_int_prop, NULL, NULL);
+        dev_uc_check(suite, dev_uc_check_property(suite, &undo_prop,
+                                                  &cases,
+                                                  "Subtraction undoes addition."),
+                     "Held.");
+        dev_uc_check(suite, cases == 500, "Ran every case.");
+        dev_uc_check_property(suite, &no_z_prop, NULL, "No 'z'.");
+        dev_uc_check_property(suite, &ascii_prop, NULL, "ASCII bytes.");
+        dev_uc_check_property(suite, &square_prop, NULL, "Squares.");
+}
+
+static void test_properties(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        /* The same seed gives the same cases in a process and in a thread. */
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Processes", NULL);
+        dev_uc_set_property_cases(sut_suite, 500);
+        dev_uc_set_property_seed(sut_suite, 42);
+        dev_uc_add_test(sut_suite, &property_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_THREADS, "Threads", NULL);
+        dev_uc_set_property_cases(sut_suite, 500);
+        dev_uc_set_property_seed(sut_suite, 42);
+        dev_uc_add_test(sut_suite, &property_test, NULL, NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_properties_a"),
+                 "Check properties report a.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void bug_target(const uint8_t *data, size_t size) {
+        if (size >= 3 && memcmp(data, "bug", 3) == 0) abort();
+}
+
+static void exit_target(const uint8_t *data, size_t size) {
+        if (size > 2) exit(3);
+}
+
+static void hang_target(const uint8_t *data, size_t size) {
+        while (size == 0) pause();
+}
+
+static void robust_target(const uint8_t *data, size_t size) {
+        volatile uint8_t sum = 0;
+
+        for (size_t i = 0; i < size; ++i) sum += data[i];
+}
+
+static void test_fuzz(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char corpus[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout, corpus_fd;
+
+        /* The seed corpus is copied, as inputs reaching new coverage are
+         * written to the copy.
+         */
+        strcpy(corpus, TMP_FILE_TEMPLATE);
+        corpus_fd = mkstemp(corpus);
+        if (corpus_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(corpus_fd);
+        remove(corpus);
+        if (mkdir(corpus, 0755) == -1 ||
+            !copy_dir(TEST_DIR "fuzz_corpus", corpus)) {
+                fputs("Failed to copy the fuzz corpus.", stderr);
+                remove_dir(corpus);
+                return;
+        }
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Processes", NULL);
+        dev_uc_set_property_seed(sut_suite, 7);
+        dev_uc_set_fuzz_limits(sut_suite, 20000, 0);
+        dev_uc_set_fuzz_output(sut_suite, corpus);
+        dev_uc_add_fuzz(sut_suite, &bug_target, "Bug", corpus);
+        dev_uc_add_fuzz(sut_suite, &exit_target, "Exit", NULL);
+        dev_uc_add_fuzz(sut_suite, &robust_target, "Robust", corpus);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+
+        sut_suite = dev_uc_init(dev_UC_OPT_THREADS, "Threads", NULL);
+        dev_uc_set_property_seed(sut_suite, 7);
+        dev_uc_set_fuzz_limits(sut_suite, 20000, 0);
+        dev_uc_add_fuzz(sut_suite, &bug_target, "Bug", corpus);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        /* Which run finds a crash depends on the mutations made. */
+        mask_numbers(tmp_file_path, ", run ");
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_fuzz_a"),
+                 "Check fuzz report a.");
+
+        /* The first input, the empty one, hangs. The worker must be killed
+         * and fuzzing carry on from the next input.
+         */
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Hangs", NULL);
+        dev_uc_set_property_seed(sut_suite, 7);
+        dev_uc_set_fuzz_limits(sut_suite, 2000, 0);
+        dev_uc_set_fuzz_timeout(sut_suite, 0.1);
+        dev_uc_add_fuzz(sut_suite, &hang_target, "Hang", NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, file_contains(tmp_file_path, "Hung: over 0.100 s, "
+                                      "run 1, input [] (0 bytes)."),
+                 "Check a hanging input is reported.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+
+        remove_dir(corpus);
+}
+
+/* Golden file written by update_snapshot_test. */
+static const char snapshot_path[] = TEST_DIR "uc_snapshot_tmp";
+
+static void compare_snapshot_test(dev_uc_suite suite) {
+        static const char equal[] = "This is a file with some\ntext.\n...\n";
+        static const char changed[] = "This is a file with some\ntext!\n...\n";
+
+        dev_uc_check_snapshot(suite, equal, strlen(equal),
+                              TEST_DIR "files_eq_equal_a");
+        dev_uc_check_snapshot(suite, changed, strlen(changed),
+                              TEST_DIR "files_eq_equal_a");
+        dev_uc_check_snapshot(suite, equal, 10, TEST_DIR "files_eq_equal_a");
+        dev_uc_check_snapshot(suite, NULL, 0, TEST_DIR "files_eq_empty_a");
+        dev_uc_check_snapshot(suite, equal, strlen(equal),
+                              TEST_DIR "no_such_snapshot");
+        dev_uc_check_snapshot_file(suite, TEST_DIR "files_eq_equal_a",
+                                   TEST_DIR "files_eq_equal_b");
+        dev_uc_check_snapshot_file(suite, TEST_DIR "files_eq_diff_a",
+                                   TEST_DIR "files_eq_diff_b");
+}
+
+static void update_snapshot_test(dev_uc_suite suite) {
+        static const char output[] = "New\toutput.\n";
+
+        putenv("UC_UPDATE_SNAPSHOTS=1");
+        dev_uc_check_snapshot(suite, output, strlen(output), snapshot_path);
+        putenv("UC_UPDATE_SNAPSHOTS=0");
+        dev_uc_check_snapshot(suite, output, strlen(output), snapshot_path);
+        dev_uc_check_snapshot(suite, output, 3, snapshot_path);
+}
+
+static void test_snapshots(uc_suite suite) {
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Snapshots", NULL);
+        dev_uc_add_test(sut_suite, &compare_snapshot_test, "Compare", NULL);
+        dev_uc_add_test(sut_suite, &update_snapshot_test, "Update", NULL);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_report_standard(sut_suite);
+        dev_uc_free(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_snapshot_a"),
+                 "Check snapshot report a.");
+
+        if (remove(tmp_file_path) == -1 || remove(snapshot_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/* Written to by the tests run by test_watch, to see their order. */
+static int watch_order_fd;
+
+static void watch_a_test(dev_uc_suite suite) {
+        write(watch_order_fd, "a", 1);
+        dev_uc_check(suite, true, NULL);
+}
+
+static void watch_b_test(dev_uc_suite suite) {
+        write(watch_order_fd, "b", 1);
+        dev_uc_check(suite, false, "Fails now.");
+}
+
+static void watch_c_test(dev_uc_suite suite) {
+        write(watch_order_fd, "c", 1);
+        dev_uc_check(suite, true, NULL);
+}
+
+static bool file_contains(const char *path, const char *str) {
+        char contents[4096];
+        size_t len;
+        FILE *file = fopen(path, "r");
+
+        if (file == NULL) return false;
+
+        len = fread(contents, 1, sizeof(contents) - 1, file);
+        contents[len] = '\0';
+        fclose(file);
+
+        return strstr(contents, str) != NULL;
+}
+
+static void test_watch(uc_suite suite) {
+        /* The previous run, in which Watch c failed. */
+        static const char prev_state[] = "P Watch a\nP Watch b\nF Watch c\n";
+        static const char state[] = "P Watch a\nF Watch b\nP Watch c\n";
+        static char state_env[32];
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char state_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char order[4] = "", contents[sizeof(state)] = "";
+        size_t order_len = 0;
+        int tmp_file_fd, state_fd, order_pipe[2];
+        pid_t pid;
+
+        strcpy(tmp_file_path, TMP_FILE_TEMPLATE);
+        strcpy(state_path, TMP_FILE_TEMPLATE);
+
+        tmp_file_fd = mkstemp(tmp_file_path);
+        state_fd = mkstemp(state_path);
+        if (tmp_file_fd == -1 || state_fd == -1 || pipe(order_pipe) == -1) {
+                fputs("Failed to create temporary files.", stderr);
+                return;
+        }
+        close(tmp_file_fd);
+        write(state_fd, prev_state, strlen(prev_state));
+
+        /* uc_watch only returns on failure, so it is run in a child. */
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+                dev_uc_suite sut_suite;
+
+                close(order_pipe[0]);
+                watch_order_fd = order_pipe[1];
+                sprintf(state_env, "UC_WATCH_FD=%d", state_fd);
+                putenv(state_env);
+
+                STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+                sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Watch", NULL);
+                dev_uc_add_test(sut_suite, &watch_a_test, "Watch a", NULL);
+                dev_uc_add_test(sut_suite, &watch_b_test, "Watch b", NULL);
+                dev_uc_add_test(sut_suite, &watch_c_test, "Watch c", NULL);
+                dev_uc_watch(sut_suite, &dev_uc_report_basic, NULL, 0);
+                _exit(EXIT_FAILURE);
+        }
+        close(order_pipe[1]);
+
+        while (pid != -1 && order_len < 3) {
+                ssize_t got = read(order_pipe[0], order + order_len,
+                                   3 - order_len);
+                if (got <= 0) break;
+                order_len += got;
+        }
+
+        /* Up to 5 seconds for the report. */
+        for (int i = 0; pid != -1 && i < 500; ++i) {
+                if (file_contains(tmp_file_path, "Watching for changes.")) {
+                        break;
+                }
+                usleep(10000);
+        }
+
+        if (pid != -1) {
+                kill(pid, SIGKILL);
+                waitpid(pid, NULL, 0);
+        }
+
+        uc_check(suite, strcmp(order, "cab") == 0,
+                 "Check the test which failed before runs first.");
+        uc_check(suite, files_eq(tmp_file_path, TEST_DIR "uc_report_watch_a"),
+                 "Check watch report a.");
+        pread(state_fd, contents, sizeof(contents) - 1, 0);
+        uc_check(suite, strcmp(contents, state) == 0,
+                 "Check the state left for the next run.");
+
+        close(order_pipe[0]);
+        close(state_fd);
+        if (remove(tmp_file_path) == -1 || remove(state_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+}
+
+static void registry_pass_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, true, NULL);
+}
+
+static void registry_fail_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, false, "Registry check failed.");
+}
+
+static void test_registry(uc_suite suite) {
+        dev_uc_registry registry;
+        dev_uc_suite a_suite, b_suite, c_suite, outside_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+
+        strncpy(tmp_file_path, TMP_FILE_TEMPLATE,
+                strlen(TMP_FILE_TEMPLATE) + 1);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+        }
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        registry = dev_uc_registry_init();
+        dev_uc_registry_set_jobs(registry, 2);
+
+        a_suite = dev_uc_init(dev_UC_OPT_NONE, "Registry A", NULL);
+        for (int i = 0; i < 4; ++i) {
+                dev_uc_add_test(a_suite, &registry_pass_test, NULL, NULL);
+        }
+        dev_uc_add_test(a_suite, &registry_fail_test, "Failing", NULL);
+
+        b_suite = dev_uc_init(dev_UC_OPT_NONE, "Registry B", "Under A.");
+        dev_uc_add_test(b_suite, &registry_pass_test, "Passing", NULL);
+        dev_uc_begin_group(b_suite, NULL, NULL);
+        dev_uc_add_test(b_suite, &registry_pass_test, "Grouped", NULL);
+        dev_uc_add_test(b_suite, &registry_fail_test, "Grouped", NULL);
+        dev_uc_end_group(b_suite);
+
+        c_suite = dev_uc_init(dev_UC_OPT_ZYGOTE, NULL, NULL);
+        dev_uc_check(c_suite, true, "Outside of tests.");
+        dev_uc_add_test(c_suite, &registry_pass_test, NULL, NULL);
+        dev_uc_add_test(c_suite, &registry_pass_test, NULL, NULL);
+
+        outside_suite = dev_uc_init(dev_UC_OPT_NONE, NULL, NULL);
+
+        uc_check(suite, dev_uc_registry_add(registry, a_suite, NULL),
+                 "Check adding a suite.");
+        uc_check(suite, dev_uc_registry_add(registry, c_suite, NULL),
+                 "Check adding a second suite.");
+        uc_check(suite, dev_uc_registry_add(registry, b_suite, a_suite),
+                 "Check adding a sub-suite.");
+        uc_check(suite, !dev_uc_registry_add(registry, b_suite, NULL),
+                 "Check adding a suite twice fails.");
+        uc_check(suite, !dev_uc_registry_add(registry, outside_suite,
+                                             dev_uc_init(dev_UC_OPT_NONE,
+                                                         NULL, NULL)),
+                 "Check adding under a suite not in the registry fails.");
+        dev_uc_free(outside_suite);
+
+        dev_uc_registry_run(registry);
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        dev_uc_report_registry(registry);
+        dev_uc_report_standard(a_suite);
+        dev_uc_report_standard(b_suite);
+        dev_uc_report_standard(c_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+
+        uc_check(suite, !dev_uc_registry_all_passed(registry),
+                 "Check the registry's tests did not all pass.");
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_registry_a"),
+                 "Check registry report a.");
+        dev_uc_registry_free(registry);
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+/* Counters coverage_dump writes for the current test, NULL for none. */
+static const char *coverage_gcda;
+
+static void coverage_reset(void) {
+        coverage_gcda = NULL;
+}
+
+/** Stands in for __gcov_dump, writing coverage_gcda to where gcov would
+  * write the counters of test_resources/coverage/cov.c.
+  */
+static void coverage_dump(void) {
+        const char *prefix = getenv("GCOV_PREFIX");
+        char path[2048], cwd[1024];
+        FILE *from, *to;
+        int c;
+
+        if (coverage_gcda == NULL || prefix == NULL ||
+            getcwd(cwd, sizeof(cwd)) == NULL) {
+                return;
+        }
+
+        snprintf(path, sizeof(path), "%s%s/" TEST_DIR "coverage/cov.gcda",
+                 prefix, cwd);
+        for (char *slash = strchr(path + 1, '/'); slash != NULL;
+             slash = strchr(slash + 1, '/')) {
+                *slash = '\0';
+                mkdir(path, 0755);
+                *slash = '/';
+        }
+
+        from = fopen(coverage_gcda, "rb");
+        to = fopen(path, "wb");
+        while (from != NULL && to != NULL && (c = fgetc(from)) != EOF) {
+                fputc(c, to);
+        }
+        if (from != NULL) fclose(from);
+        if (to != NULL) fclose(to);
+}
+
+static void coverage_a_test(dev_uc_suite suite) {
+        coverage_gcda = TEST_DIR "coverage/cov_a.gcda";
+        dev_uc_check(suite, true, NULL);
+}
+
+static void coverage_b_test(dev_uc_suite suite) {
+        coverage_gcda = TEST_DIR "coverage/cov_b.gcda";
+        dev_uc_check(suite, true, NULL);
+}
+
+static void coverage_none_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+}
+
+static dev_uc_suite coverage_suite(const char *map_path) {
+        dev_uc_suite sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Coverage",
+                                             NULL);
+
+        dev_uc_add_test(sut_suite, &coverage_a_test, "Calls a", NULL);
+        dev_uc_add_test(sut_suite, &coverage_b_test, "Calls b", NULL);
+        dev_uc_add_test(sut_suite, &coverage_none_test, "Unmapped", NULL);
+        dev_uc_set_coverage_map(sut_suite, map_path, &coverage_dump,
+                                &coverage_reset);
+
+        return sut_suite;
+}
+
+static void test_coverage_map(uc_suite suite) {
+        /* cov_b's lines. */
+        static const char changes[] = "coverage/cov.c:10-11\n";
+        dev_uc_suite sut_suite;
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char map_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char changes_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, map_fd, changes_fd, orig_stdout;
+
+        strcpy(tmp_file_path, TMP_FILE_TEMPLATE);
+        strcpy(map_path, TMP_FILE_TEMPLATE);
+        strcpy(changes_path, TMP_FILE_TEMPLATE);
+
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        map_fd = mkstemp(map_path);
+        changes_fd = mkstemp(changes_path);
+        if (tmp_file_fd == -1 || map_fd == -1 || changes_fd == -1) {
+                fputs("Failed to create temporary files.", stderr);
+                return;
+        }
+        write(changes_fd, changes, strlen(changes));
+        close(changes_fd);
+        close(map_fd);
+
+        /* Since the STDOUT_REDIR_SET_UP opens. */
+        if (close(tmp_file_fd) == -1) {
+                fputs("Failed to close temporary file.", stderr);
+        };
+
+        sut_suite = coverage_suite(map_path);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_free(sut_suite);
+
+        uc_check(suite, file_contains(map_path, "F 5 7 cov_a "),
+                 "Check the functions of the first test are mapped.");
+        uc_check(suite, file_contains(map_path, "F 9 11 cov_b "),
+                 "Check the functions of the second test are mapped.");
+        uc_check(suite, !file_contains(map_path, "T Unmapped"),
+                 "Check tests without coverage are not mapped.");
+
+        sut_suite = coverage_suite(map_path);
+        uc_check(suite, dev_uc_select_tests(sut_suite, changes_path),
+                 "Check selecting tests.");
+        dev_uc_run_tests(sut_suite);
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+        dev_uc_free(sut_suite);
+
+        uc_check(suite, files_eq(tmp_file_path,
+                                 TEST_DIR "uc_report_coverage_a"),
+                 "Check coverage report a.");
+        uc_check(suite, file_contains(map_path, "F 5 7 cov_a "),
+                 "Check tests not run keep their functions.");
+
+        if (remove(tmp_file_path) == -1 || remove(map_path) == -1 ||
+            remove(changes_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void trace_test(dev_uc_suite suite) {
+        dev_uc_check(suite, true, NULL);
+        dev_uc_check(suite, false, NULL);
+}
+
+static void test_trace(uc_suite suite) {
+        char trace_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        dev_uc_suite sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Traced",
+                                             NULL);
+        int trace_fd;
+
+        strcpy(trace_path, TMP_FILE_TEMPLATE);
+        trace_fd = mkstemp(trace_path);
+        if (trace_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(trace_fd);
+
+        dev_uc_add_test(sut_suite, &trace_test, "Trace \"a\"", NULL);
+        dev_uc_add_test(sut_suite, &trace_test, NULL, NULL);
+        dev_uc_set_trace(sut_suite, trace_path);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_free(sut_suite);
+
+        uc_check(suite, file_contains(trace_path, "{\"traceEvents\":["),
+                 "Check the trace is in the trace event format.");
+        uc_check(suite, file_contains(trace_path, "\"args\":{\"name\":"
+                                                  "\"Slot 1\"}"),
+                 "Check the slot's lane is named.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Spawn\","
+                                                  "\"ph\":\"X\""),
+                 "Check test processes' spawns are traced.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Reap\","
+                                                  "\"ph\":\"X\""),
+                 "Check test processes' reaps are traced.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Trace "
+                                                  "\\\"a\\\"\",\"ph\":\"X\""),
+                 "Check named tests are traced, with their names escaped.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Test #2\","
+                                                  "\"ph\":\"X\""),
+                 "Check unnamed tests are traced by number.");
+        uc_check(suite, file_contains(trace_path,
+                                      "\"args\":{\"checks\":2,"
+                                      "\"passed\":1}"),
+                 "Check tests' spans have their checks.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Transfer\","
+                                                  "\"ph\":\"X\""),
+                 "Check result transfers are traced.");
+        uc_check(suite, file_contains(trace_path,
+                                      "\"args\":{\"children\":0}}"),
+                 "Check the in-flight children track drops to 0.");
+        uc_check(suite, file_contains(trace_path, "{\"name\":\"Bytes "
+                                                  "received\",\"ph\":\"C\""),
+                 "Check the bytes received track.");
+        uc_check(suite, file_contains(trace_path, "\n]}\n"),
+                 "Check the trace is complete.");
+
+        if (remove(trace_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+}
+
+static void profile_spin_test(dev_uc_suite suite) {
+        struct timespec start, now;
+
+        (void)suite;
+
+        /* Busy, as only CPU time is sampled. */
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        do {
+                clock_gettime(CLOCK_MONOTONIC, &now);
+        } while ((now.tv_sec - start.tv_sec) * 1000 +
+                 (now.tv_nsec - start.tv_nsec) / 1000000 < 100);
+}
+
+static void profile_fast_test(dev_uc_suite suite) {
+        (void)suite;
+}
+
+static void test_profile(uc_suite suite) {
+        char dir[strlen(TMP_FILE_TEMPLATE) + 1];
+        char spin_path[sizeof(dir) + 32], fast_path[sizeof(dir) + 32];
+        dev_uc_suite sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Profiled",
+                                             NULL);
+        unsigned long samples = 0;
+        FILE *profile;
+        int dir_fd;
+
+        /* A unique name for the directory, which is created by the run. */
+        strcpy(dir, TMP_FILE_TEMPLATE);
+        dir_fd = mkstemp(dir);
+        if (dir_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(dir_fd);
+        remove(dir);
+        sprintf(spin_path, "%s/Spin_test.folded", dir);
+        sprintf(fast_path, "%s/Fast.folded", dir);
+
+        dev_uc_add_test(sut_suite, &profile_spin_test, "Spin/test", NULL);
+        dev_uc_add_test(sut_suite, &profile_fast_test, "Fast", NULL);
+        dev_uc_set_profile(sut_suite, dir, 0.05);
+        dev_uc_run_tests(sut_suite);
+        dev_uc_free(sut_suite);
+
+        profile = fopen(spin_path, "r");
+        uc_check(suite, profile != NULL,
+                 "Check the slow test's profile is written, named after it.");
+        if (profile != NULL) {
+                char line[1024];
+
+                /* The count ends each line. */
+                while (fgets(line, sizeof(line), profile) != NULL) {
+                        char *count = strrchr(line, ' ');
+
+                        if (count != NULL) samples += strtoul(count, NULL, 10);
+                }
+                fclose(profile);
+        }
+        uc_check(suite, samples > 0, "Check the slow test was sampled.");
+        uc_check(suite, access(fast_path, F_OK) == -1,
+                 "Check the fast test is left out.");
+
+        if (remove(spin_path) == -1 || remove(dir) == -1) {
+                fputs("Could not remove temporary files", stderr);
+        }
+}
+
+/* Where scheduled tests write a lower case letter when they start and the
+ * upper case one when they end.
+ */
+static int sched_fd;
+
+static void sched_run(const char letter) {
+        char end = letter - 'a' + 'A';
+
+        write(sched_fd, &letter, 1);
+        usleep(50000);
+        write(sched_fd, &end, 1);
+}
+
+static void sched_setup_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('s');
+}
+
+static void sched_after_setup_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('d');
+}
+
+static void sched_port_a_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('a');
+}
+
+static void sched_port_b_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('b');
+}
+
+static void sched_free_a_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('f');
+}
+
+static void sched_free_b_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('g');
+}
+
+static void sched_db_a_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('h');
+}
+
+static void sched_db_b_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('i');
+}
+
+static void sched_db_c_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('j');
+}
+
+static void sched_alone_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('x');
+}
+
+static void sched_after_alone_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('y');
+}
+
+static void sched_fail_test(dev_uc_suite suite) {
+        dev_uc_check(suite, false, NULL);
+}
+
+static void sched_after_fail_test(dev_uc_suite suite) {
+        (void)suite;
+        sched_run('z');
+}
+
+/** Index of c in events, or -1. */
+static int event_index(const char *events, const char c) {
+        const char *found = strchr(events, c);
+
+        return found != NULL ? found - events : -1;
+}
+
+/** Most of the tests whose letters are in letters running at once. */
+static int max_overlap(const char *events, const char *letters) {
+        int running = 0, max = 0;
+
+        for (const char *c = events; *c != '\0'; ++c) {
+                if (strchr(letters, *c) != NULL) {
+                        if (++running > max) max = running;
+                } else if (strchr(letters, *c - 'A' + 'a') != NULL) {
+                        --running;
+                }
+        }
+
+        return max;
+}
+
+static void test_scheduling(uc_suite suite) {
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        char events[64];
+        int tmp_file_fd, orig_stdout, events_pipe[2], alone, running = 0;
+        ssize_t len;
+        dev_uc_suite sut_suite = dev_uc_init(dev_UC_OPT_PARALLEL,
+                                             "Scheduled", NULL);
+
+        strcpy(tmp_file_path, TMP_FILE_TEMPLATE);
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1 || pipe(events_pipe) == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(tmp_file_fd);
+        sched_fd = events_pipe[1];
+
+        dev_uc_set_jobs(sut_suite, 4);
+        dev_uc_add_resource(sut_suite, "db", 2);
+        dev_uc_add_test(sut_suite, &sched_setup_test, "Setup", NULL);
+        dev_uc_add_test(sut_suite, &sched_after_setup_test, "After setup",
+                        NULL);
+        uc_check(suite, dev_uc_test_after(sut_suite, "Setup"),
+                 "Check adding a prerequisite.");
+        uc_check(suite, !dev_uc_test_after(sut_suite, "Port a"),
+                 "Check later tests can't be prerequisites.");
+        dev_uc_add_test(sut_suite, &sched_port_a_test, "Port a", NULL);
+        dev_uc_test_uses(sut_suite, "port", 1);
+        dev_uc_add_test(sut_suite, &sched_port_b_test, "Port b", NULL);
+        dev_uc_test_uses(sut_suite, "port", 1);
+        dev_uc_add_test(sut_suite, &sched_free_a_test, "Free a", NULL);
+        dev_uc_add_test(sut_suite, &sched_free_b_test, "Free b", NULL);
+        dev_uc_add_test(sut_suite, &sched_db_a_test, "DB a", NULL);
+        uc_check(suite, dev_uc_test_uses(sut_suite, "db", 1),
+                 "Check using a declared resource.");
+        uc_check(suite, !dev_uc_test_uses(sut_suite, "db", 3),
+                 "Check using more than a resource has.");
+        dev_uc_add_test(sut_suite, &sched_db_b_test, "DB b", NULL);
+        dev_uc_test_uses(sut_suite, "db", 1);
+        dev_uc_add_test(sut_suite, &sched_db_c_test, "DB c", NULL);
+        dev_uc_test_uses(sut_suite, "db", 1);
+        dev_uc_add_test(sut_suite, &sched_alone_test, "Alone", NULL);
+        dev_uc_test_uses(sut_suite, NULL, 0);
+        dev_uc_add_test(sut_suite, &sched_fail_test, "Fails", NULL);
+        dev_uc_add_test(sut_suite, &sched_after_fail_test, "After fail",
+                        NULL);
+        dev_uc_test_after(sut_suite, "Fails");
+        dev_uc_run_tests(sut_suite);
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+        dev_uc_free(sut_suite);
+
+        close(events_pipe[1]);
+        len = read(events_pipe[0], events, sizeof(events) - 1);
+        close(events_pipe[0]);
+        events[len > 0 ? len : 0] = '\0';
+
+        uc_check(suite, event_index(events, 'd') > event_index(events, 'S'),
+                 "Check a test starts after its prerequisite.");
+        uc_check(suite, max_overlap(events, "ab") == 1,
+                 "Check tests using a resource run one at a time.");
+        uc_check(suite, max_overlap(events, "fg") == 2,
+                 "Check unconstrained tests run at the same time.");
+        uc_check(suite, max_overlap(events, "hij") == 2,
+                 "Check counted resources are shared up to capacity.");
+
+        alone = event_index(events, 'x');
+        for (int i = 0; i < alone; ++i) {
+                running += events[i] >= 'a' ? 1 : -1;
+        }
+        uc_check(suite, alone >= 0 && running == 0 &&
+                        events[alone + 1] == 'X',
+                 "Check a test using the whole machine runs alone.");
+
+        uc_check(suite, event_index(events, 'z') == -1,
+                 "Check a test isn't run after a failed prerequisite.");
+        uc_check(suite, file_contains(tmp_file_path, "Not run: prerequisite "
+                                                     "Fails did not pass."),
+                 "Check the test's prerequisite is reported.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}
+
+static void test_registry_scheduling(uc_suite suite) {
+        char events[32];
+        int events_pipe[2], alone, running = 0;
+        ssize_t len;
+        dev_uc_registry registry = dev_uc_registry_init();
+        dev_uc_suite a_suite = dev_uc_init(dev_UC_OPT_NONE, "A", NULL);
+        dev_uc_suite b_suite = dev_uc_init(dev_UC_OPT_NONE, "B", NULL);
+
+        if (pipe(events_pipe) == -1) {
+                fputs("Failed to create pipe.", stderr);
+                return;
+        }
+        sched_fd = events_pipe[1];
+
+        /* Each suite only has one test using the port: they must not run
+         * at the same time all the same.
+         */
+        dev_uc_registry_set_jobs(registry, 4);
+        dev_uc_add_test(a_suite, &sched_port_a_test, "Port a", NULL);
+        dev_uc_test_uses(a_suite, "port", 1);
+        dev_uc_add_test(b_suite, &sched_port_b_test, "Port b", NULL);
+        dev_uc_test_uses(b_suite, "port", 1);
+        dev_uc_registry_add(registry, a_suite, NULL);
+        dev_uc_registry_add(registry, b_suite, NULL);
+        dev_uc_registry_run(registry);
+        dev_uc_registry_free(registry);
+
+        len = read(events_pipe[0], events, sizeof(events) - 1);
+        events[len > 0 ? len : 0] = '\0';
+        uc_check(suite, strlen(events) == 4 && max_overlap(events, "ab") == 1,
+                 "Check suites share resources of the same name.");
+
+        /* Alone is the first test left of B while Free a and b run: After
+         * alone has to wait for it.
+         */
+        registry = dev_uc_registry_init();
+        a_suite = dev_uc_init(dev_UC_OPT_NONE, "A", NULL);
+        b_suite = dev_uc_init(dev_UC_OPT_NONE, "B", NULL);
+        dev_uc_registry_set_jobs(registry, 4);
+        dev_uc_add_test(a_suite, &sched_free_a_test, "Free a", NULL);
+        dev_uc_add_test(b_suite, &sched_free_b_test, "Free b", NULL);
+        dev_uc_add_test(b_suite, &sched_alone_test, "Alone", NULL);
+        dev_uc_test_uses(b_suite, NULL, 0);
+        dev_uc_add_test(b_suite, &sched_after_alone_test, "After alone",
+                        NULL);
+        dev_uc_registry_add(registry, a_suite, NULL);
+        dev_uc_registry_add(registry, b_suite, NULL);
+        dev_uc_registry_run(registry);
+
+        close(events_pipe[1]);
+        len = read(events_pipe[0], events, sizeof(events) - 1);
+        close(events_pipe[0]);
+        events[len > 0 ? len : 0] = '\0';
+
+        uc_check(suite, dev_uc_registry_all_passed(registry),
+                 "Check the registry's tests passed.");
+        dev_uc_registry_free(registry);
+
+        alone = event_index(events, 'x');
+        for (int i = 0; i < alone; ++i) {
+                running += events[i] >= 'a' ? 1 : -1;
+        }
+        uc_check(suite, alone >= 0 && running == 0 &&
+                        events[alone + 1] == 'X',
+                 "Check a test using the whole machine runs with no test of "
+                 "another suite.");
+        uc_check(suite, event_index(events, 'y') > event_index(events, 'X'),
+                 "Check later tests don't start ahead of a test running "
+                 "alone.");
+}
+
+/* Calls made to load_target by every thread of the test's process. */
+static unsigned long load_calls;
+
+/** Fails every tenth call. */
+static bool load_target(unsigned int caller) {
+        (void)caller;
+        return __atomic_add_fetch(&load_calls, 1, __ATOMIC_RELAXED) % 10 != 0;
+}
+
+static bool load_crash_target(unsigned int caller) {
+        if (caller == 1) abort();
+        return true;
+}
+
+static void test_load(uc_suite suite) {
+        char tmp_file_path[strlen(TMP_FILE_TEMPLATE) + 1];
+        int tmp_file_fd, orig_stdout;
+        struct uc_load_options counted = { .threads = 2, .calls = 1000,
+                                           .max_p50 = 1e-9,
+                                           .max_error_rate = 0.2 };
+        struct uc_load_options timed = { .threads = 2, .processes = 2,
+                                         .seconds = 0.05,
+                                         .max_latency = 10,
+                                         .min_throughput = 1,
+                                         .max_error_rate = 0.2 };
+        struct uc_load_options crash = { .processes = 2, .seconds = 0.01 };
+        dev_uc_suite sut_suite = dev_uc_init(dev_UC_OPT_NONE, "Load", NULL);
+
+        strcpy(tmp_file_path, TMP_FILE_TEMPLATE);
+        orig_stdout = dup(STDOUT_FILENO);
+        tmp_file_fd = mkstemp(tmp_file_path);
+        if (tmp_file_fd == -1) {
+                fputs("Failed to create temporary file.", stderr);
+                return;
+        }
+        close(tmp_file_fd);
+
+        dev_uc_add_load_test(sut_suite, &load_target, "Counted", NULL,
+                             &counted);
+        dev_uc_add_load_test(sut_suite, &load_target, "Timed", NULL, &timed);
+        dev_uc_add_load_test(sut_suite, &load_crash_target, "Crash", NULL,
+                             &crash);
+        dev_uc_run_tests(sut_suite);
+
+        STDOUT_REDIR_SET_UP(tmp_file_path, tmp_file_fd);
+        dev_uc_report_standard(sut_suite);
+        STDOUT_REDIR_TEAR_DOWN(tmp_file_fd, orig_stdout);
+        dev_uc_free(sut_suite);
+
+        uc_check(suite, file_contains(tmp_file_path, "Load: 1000 calls from 2 "
+                                                     "callers in "),
+                 "Check calls are limited across callers.");
+        uc_check(suite, file_contains(tmp_file_path, "100 failed (10.00%)."),
+                 "Check failed calls are counted.");
+        uc_check(suite, file_contains(tmp_file_path, "at most 0.001 us "
+                                                     "allowed."),
+                 "Check a missed latency objective fails.");
+        uc_check(suite, file_contains(tmp_file_path, "from 4 callers in "),
+                 "Check threads of each caller process are counted.");
+        uc_check(suite, !file_contains(tmp_file_path, "calls/s required."),
+                 "Check a met throughput objective passes.");
+        uc_check(suite, file_contains(tmp_file_path, "Caller process 1 was "
+                                                     "killed by signal 6."),
+                 "Check a crashed caller process fails.");
+
+        if (remove(tmp_file_path) == -1) {
+                fputs("Could not remove temporary file", stderr);
+        }
+
+        if (close(orig_stdout) == -1) {
+                fputs("Could not close dup'd stdout fd", stderr);
+        }
+}